@@ -0,0 +1,243 @@
+// Persistent constructive solid geometry for circular arc polygons
+
+#include <geode/exact/ArcCSG.h>
+#include <geode/exact/circle_quantization.h>
+#include <geode/exact/exact_circle_offsets.h>
+#include <geode/exact/scope.h>
+#include <geode/geometry/traverse.h>
+#include <geode/python/Class.h>
+#include <geode/python/stl.h>
+namespace geode {
+
+GEODE_DEFINE_TYPE(ArcCSG)
+
+ArcCSG::ArcCSG(const Box<Vec2> bounds)
+  : bounds(bounds)
+  , quant(make_arc_quantizer(bounds.empty() ? Box<Vec2>::unit_box() : bounds))
+  , live_arcs(0)
+  , dead_arcs(0) {}
+
+ArcCSG::~ArcCSG() {}
+
+const ArcContours& ArcCSG::shape(const int s) const {
+  GEODE_ASSERT(unsigned(s)<shapes.size() && alive[s],format("ArcCSG: invalid shape %d",s));
+  return shapes[s];
+}
+
+// Copy contours from another VertexSet, adding any new circles and intersections
+ArcContours ArcCSG::import_contours(const VertexSet<PS>& src_vertices, const ArcContours& src_contours) {
+  ArcContours result;
+  result.store.extend(src_contours.store);
+  for (auto& h : result.store.flat) {
+    const auto ref_cid = vertices.get_or_insert(src_vertices.reference(h.iid));
+    const auto inc_cid = vertices.get_or_insert(src_vertices.incident(h.iid).as_circle());
+    h.iid = vertices.get_or_insert(src_vertices.incident(h.iid), ref_cid, inc_cid);
+  }
+  return result;
+}
+
+// Embed contours (with ids from vertices) and store the region with winding number greater than depth as a new shape.
+// The embedding is built in a local VertexSet containing only the circles and intersections relevant to contours,
+// with intersections copied from vertices and only computed for circle pairs that have never been seen before.
+int ArcCSG::add_shape(const ArcContours& contours, RawArray<const int8_t> weights, const int depth) {
+  const auto g = new_<PlanarArcGraph<PS>>(uninit);
+  auto& local = g->vertices;
+  Array<CircleId> circle_ids; // The id in vertices of each local circle
+  Array<VertexId> vertex_ids; // The id in vertices of each local vertex
+  const auto local_circle = [&](const CircleId cid) {
+    const auto l = local.get_or_insert(vertices.circle(cid));
+    if (l.idx()==circle_ids.size())
+      circle_ids.append(cid);
+    return l;
+  };
+  const auto local_incident = [&](const IncidentId iid) {
+    const auto ref_cid = local_circle(vertices.reference_cid(iid)),
+               inc_cid = local_circle(vertices.incident_cid(iid));
+    const auto l = local.get_or_insert(vertices.incident(iid), ref_cid, inc_cid);
+    if (to_vid(l).idx()==vertex_ids.size())
+      vertex_ids.append(to_vid(iid));
+    return l;
+  };
+
+  ArcContours local_contours;
+  local_contours.store.extend(contours.store);
+  for (auto& h : local_contours.store.flat)
+    h.iid = local_incident(h.iid);
+
+  // Find candidate circle pairs exactly as insert_circle_intersections does.  Pairs never seen before are intersected
+  // in parallel and cached in full, and the intersections of every candidate pair are then looked up in the cache.
+  const CircleTree<PS> tree(local, local_contours);
+  const auto candidates = tree.candidate_pairs();
+  Array<Vector<CircleId,2>> fresh;
+  for (const auto n : candidates) {
+    const auto c0 = circle_ids[tree.prim(n.x).idx()],
+               c1 = circle_ids[tree.prim(n.y).idx()];
+    if (intersected.set(c0<c1 ? vec(c0,c1) : vec(c1,c0)))
+      fresh.append(vec(c0,c1));
+  }
+  insert_intersections(vertices, fresh, RawArray<const Box<Vec2>>());
+  for (const auto n : candidates) {
+    const auto b = Box<Vec2>::intersect(tree.tree->boxes[n.x],tree.tree->boxes[n.y]);
+    const auto c0 = circle_ids[tree.prim(n.x).idx()],
+               c1 = circle_ids[tree.prim(n.y).idx()];
+    // The two intersections of a pair of circles differ in which circle is on the left
+    for (const auto cl : vec(c0,c1)) {
+      const auto iid = vertices.try_find(cl, cl==c0 ? c1 : c0, ReferenceSide::cl);
+      if (iid.valid() && b.intersects(vertices.approx(iid).box()))
+        local_incident(iid);
+    }
+  }
+
+  g->embed_intersected_arcs(tree, local_contours, weights);
+  const auto edges = extract_region(g->topology, faces_greater_than(*g, depth));
+  ArcContours result = g->combine_concentric_arcs(g->edges_to_closed_contours(edges));
+  for (auto& h : result.store.flat)
+    h.iid = incident_id(vertex_ids[to_vid(h.iid).idx()], side(h.iid));
+  return push_shape(result);
+}
+
+int ArcCSG::push_shape(const ArcContours& contours) {
+  shapes.push_back(contours);
+  alive.append(true);
+  live_arcs += contours.store.total_size();
+  return int(shapes.size())-1;
+}
+
+void ArcCSG::release(const int s) {
+  const int arcs = shape(s).store.total_size();
+  shapes[s] = ArcContours();
+  alive[s] = false;
+  live_arcs -= arcs;
+  dead_arcs += arcs;
+  // Once released shapes hold most of the stored arcs, drop the circles and intersections only they used
+  if (dead_arcs > live_arcs)
+    compact();
+}
+
+void ArcCSG::compact() {
+  IntervalScope scope;
+  const auto old = vertices;
+  vertices = VertexSet<PS>();
+  for (const int s : range(int(shapes.size())))
+    if (alive[s])
+      shapes[s] = import_contours(old, shapes[s]);
+
+  // Keep cached pairs whose circles both survive, copying their intersections rather than recomputing them
+  Hashtable<Vector<CircleId,2>> new_intersected;
+  for (const auto& p : intersected) {
+    const auto c0 = vertices.find_cid(old.circle(p.x)),
+               c1 = vertices.find_cid(old.circle(p.y));
+    if (!c0.valid() || !c1.valid())
+      continue;
+    const auto iid = old.try_find(p.x, p.y, ReferenceSide::cl);
+    if (iid.valid())
+      vertices.get_or_insert(old.incident(iid), c0, c1);
+    const auto jid = old.try_find(p.y, p.x, ReferenceSide::cl);
+    if (jid.valid())
+      vertices.get_or_insert(old.incident(jid), c1, c0);
+    new_intersected.set(c0<c1 ? vec(c0,c1) : vec(c1,c0));
+  }
+  intersected = new_intersected;
+  dead_arcs = 0;
+}
+
+int ArcCSG::add(Nested<const CircleArc> arcs) {
+  GEODE_ASSERT(bounds.contains(approximate_bounding_box(arcs)),"ArcCSG: arcs lie outside bounds");
+  IntervalScope scope;
+  ArcContours contours;
+  vertices.quantize_circle_arcs(quant, arcs, contours);
+  return add_shape(contours, {}, 0);
+}
+
+int ArcCSG::add_open_offset(Nested<const CircleArc> arcs, const real d) {
+  GEODE_ASSERT(bounds.contains(approximate_bounding_box(arcs).thickened(max(d,0.))),"ArcCSG: offset arcs lie outside bounds");
+  IntervalScope scope;
+  const Quantized signed_offset = quantize_offset(quant, d);
+  if (signed_offset == 0)
+    return add_shape(ArcContours(), {}, 0);
+  ArcAccumulator<PS> minkowski_terms;
+  for (const auto& c : arcs) {
+    assert(c.size() > 0);
+    for (const int i : range(c.size() - 1))
+      add_capsule(minkowski_terms, quant(c[i].x), c[i].q, quant(c[i+1].x), signed_offset);
+  }
+  return add_shape(import_contours(minkowski_terms.vertices, minkowski_terms.contours), {}, 0);
+}
+
+int ArcCSG::split(RawArray<const int> shapes, const int depth) {
+  IntervalScope scope;
+  ArcContours contours;
+  for (const int s : shapes)
+    contours.store.extend(shape(s).store);
+  return add_shape(contours, {}, depth);
+}
+
+int ArcCSG::union_(const int a, const int b) {
+  return split(asarray(vec(a,b)), 0);
+}
+
+int ArcCSG::intersection(const int a, const int b) {
+  return split(asarray(vec(a,b)), 1);
+}
+
+int ArcCSG::difference(const int a, const int b) {
+  IntervalScope scope;
+  ArcContours contours;
+  contours.store.extend(shape(a).store);
+  contours.store.extend(shape(b).store);
+  Array<int8_t> weights(contours.size(), uninit);
+  weights.slice(0, shape(a).size()).fill(1);
+  weights.slice(shape(a).size(), weights.size()).fill(-1);
+  return add_shape(contours, weights, 0);
+}
+
+int ArcCSG::offset(const int s, const real d) {
+  IntervalScope scope;
+  const Quantized signed_offset = quantize_offset(quant, d);
+  const auto& contours = shape(s);
+  if (signed_offset == 0)
+    return push_shape(contours);
+  // Add a capsule around every arc, then union with the original contours as in offset_closed_exact_arcs
+  ArcAccumulator<PS> minkowski_terms;
+  Box<exact::Vec2> box;
+  for (const auto c : contours)
+    for (const auto sa : c) {
+      const auto arc = vertices.arc(vertices.ccw_arc(sa));
+      box.enlarge(bounding_box(arc));
+      add_capsule(minkowski_terms, arc, signed_offset);
+    }
+  GEODE_ASSERT(box.empty() || bounds.contains(Box<Vec2>(quant.inverse(box.min),quant.inverse(box.max)).thickened(max(d,0.))),
+               "ArcCSG: offset arcs lie outside bounds");
+  auto all = import_contours(minkowski_terms.vertices, minkowski_terms.contours);
+  all.store.extend(contours.store);
+  return add_shape(all, {}, 0);
+}
+
+Nested<CircleArc> ArcCSG::arcs(const int s) const {
+  IntervalScope scope;
+  return vertices.unquantize_circle_arcs(quant, shape(s));
+}
+
+}
+using namespace geode;
+
+void wrap_arc_csg() {
+  typedef ArcCSG Self;
+  Class<Self>("ArcCSG")
+    .GEODE_INIT(const Box<Vec2>)
+    .GEODE_FIELD(bounds)
+    .GEODE_GET(n_shapes)
+    .GEODE_GET(n_circles)
+    .GEODE_GET(n_vertices)
+    .GEODE_GET(n_intersected_pairs)
+    .GEODE_METHOD(add)
+    .GEODE_METHOD(add_open_offset)
+    .GEODE_METHOD(split)
+    .GEODE_METHOD_2("union",union_)
+    .GEODE_METHOD(intersection)
+    .GEODE_METHOD(difference)
+    .GEODE_METHOD(offset)
+    .GEODE_METHOD(arcs)
+    .GEODE_METHOD(release)
+    ;
+}
@@ -0,0 +1,75 @@
+// Persistent constructive solid geometry for circular arc polygons
+#pragma once
+
+#include <geode/exact/circle_csg.h>
+#include <geode/exact/PlanarArcGraph.h>
+#include <geode/structure/Hashtable.h>
+namespace geode {
+
+// ArcCSG keeps circular arc shapes in exact form across many CSG and offset operations.  split_circle_arcs and
+// offset_arcs choose a new quantizer, requantize their inputs, and recompute every circle intersection on each call.
+// An ArcCSG instead fixes one quantizer up front, and keeps a single VertexSet holding every circle and intersection
+// seen so far together with the set of circle pairs which have already been intersected.  Each operation only
+// computes exact intersections for circle pairs it has not seen before, so repeatedly offsetting or combining against
+// the same outline only pays for the arcs that changed.
+//
+// Shapes are referred to by integer ids and are stored as closed exact contours with positive orientation (the
+// boundary of the union of their inputs).  Results only leave exact form when requested via arcs.  Shapes which are no
+// longer needed should be released; once released shapes hold most of the stored arcs, the circles and intersections
+// used only by them are dropped from the cache.
+class ArcCSG : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  static constexpr Pb PS = Pb::Implicit;
+
+  const Box<Vec2> bounds; // All geometry, including the results of outward offsets, must lie inside bounds
+  const Quantizer<real,2> quant;
+
+protected:
+  VertexSet<PS> vertices; // Every circle and intersection used by any shape
+  Hashtable<Vector<CircleId,2>> intersected; // Sorted circle pairs whose intersections have all been added to vertices
+  vector<ArcContours> shapes;
+  Array<bool> alive; // False for released shapes
+  int live_arcs, dead_arcs; // Arcs in live shapes, and in shapes released since the last compaction
+
+  GEODE_CORE_EXPORT ArcCSG(const Box<Vec2> bounds);
+public:
+  ~ArcCSG();
+
+  int n_shapes() const { return int(shapes.size()); }
+  int n_circles() const { return vertices.n_circles(); }
+  int n_vertices() const { return vertices.n_vertices(); }
+  int n_intersected_pairs() const { return intersected.size(); }
+
+  // Quantize closed arc contours and add their union as a new shape
+  GEODE_CORE_EXPORT int add(Nested<const CircleArc> arcs);
+
+  // Add the region swept by a disk of radius d moving along open arc contours, as in offset_open_arcs
+  GEODE_CORE_EXPORT int add_open_offset(Nested<const CircleArc> arcs, const real d);
+
+  // Combine shapes, keeping points covered by more than depth of them.  depth = 0 gives the union, and
+  // depth = shapes.size()-1 the intersection.
+  GEODE_CORE_EXPORT int split(RawArray<const int> shapes, const int depth);
+  GEODE_CORE_EXPORT int union_(const int a, const int b);
+  GEODE_CORE_EXPORT int intersection(const int a, const int b);
+  GEODE_CORE_EXPORT int difference(const int a, const int b);
+
+  // Grow or shrink a shape by d, as in offset_arcs
+  GEODE_CORE_EXPORT int offset(const int shape, const real d);
+
+  // Unquantize a shape
+  GEODE_CORE_EXPORT Nested<CircleArc> arcs(const int shape) const;
+
+  // Free a shape.  Its id becomes invalid, and other ids are unchanged.
+  GEODE_CORE_EXPORT void release(const int shape);
+
+private:
+  const ArcContours& shape(const int s) const;
+  ArcContours import_contours(const VertexSet<PS>& src_vertices, const ArcContours& src_contours);
+  int add_shape(const ArcContours& contours, RawArray<const int8_t> weights, const int depth);
+  int push_shape(const ArcContours& contours);
+  void compact();
+};
+
+}
@@ -0,0 +1,190 @@
+// Continuous collision detection for deforming triangle meshes
+
+#include <geode/exact/CollisionDetector.h>
+#include <geode/exact/collision.h>
+#include <geode/geometry/traverse.h>
+#include <geode/python/Class.h>
+namespace geode {
+
+typedef real T;
+typedef Vector<T,3> TV;
+
+GEODE_DEFINE_TYPE(CollisionDetector)
+
+// Small leaves keep refitted boxes reasonably tight as the mesh deforms
+static const int leaf_size = 4;
+
+static Array<const VertexId> used_vertices(const TriangleTopology& mesh) {
+  Array<VertexId> vertices;
+  for (const auto v : mesh.vertices())
+    vertices.append(v);
+  return vertices;
+}
+
+// One interior halfedge per edge
+static Array<const HalfedgeId> unique_edges(const TriangleTopology& mesh) {
+  Array<HalfedgeId> edges;
+  for (const auto e : mesh.interior_halfedges()) {
+    const auto r = mesh.reverse(e);
+    if (mesh.is_boundary(r) || e<r)
+      edges.append(e);
+  }
+  return edges;
+}
+
+static inline Vector<VertexId,1> element_vertices(const TriangleTopology& mesh, const VertexId v) { return vec(v); }
+static inline Vector<VertexId,2> element_vertices(const TriangleTopology& mesh, const HalfedgeId e) { return mesh.vertices(e); }
+static inline Vector<VertexId,3> element_vertices(const TriangleTopology& mesh, const FaceId f) { return mesh.vertices(f); }
+
+// Boxes containing each element at both the start and end of the motion
+template<class Id> static Array<Box<TV>>
+swept_boxes(const TriangleTopology& mesh, const Array<const Id>& ids, RawField<const TV,VertexId> X0, RawField<const TV,VertexId> X1) {
+  GEODE_ASSERT(X0.size()==mesh.allocated_vertices() && X1.size()==mesh.allocated_vertices(),
+               format("CollisionDetector: expected %d positions, got %d and %d",
+                      mesh.allocated_vertices(),X0.size(),X1.size()));
+  Array<Box<TV>> boxes(ids.size(),uninit);
+  #pragma omp parallel for
+  for (int i=0;i<ids.size();i++) {
+    Box<TV> box;
+    for (const auto v : element_vertices(mesh,ids[i]))
+      box.enlarge(bounding_box(X0[v],X1[v]));
+    boxes[i] = box;
+  }
+  return boxes;
+}
+
+CollisionDetector::CollisionDetector(const TriangleTopology& mesh, Field<const TV,VertexId> X0, Field<const TV,VertexId> X1)
+  : mesh(ref(mesh))
+  , vertices(used_vertices(mesh))
+  , edges(unique_edges(mesh))
+  , faces(mesh.face_soup().y)
+  , X0(X0)
+  , X1(X1)
+  , vertex_boxes(swept_boxes(mesh,vertices,X0,X1))
+  , edge_boxes(swept_boxes(mesh,edges,X0,X1))
+  , face_boxes(swept_boxes(mesh,faces,X0,X1))
+  , vertex_tree(new_<BoxTree<TV>>(vertex_boxes,leaf_size))
+  , edge_tree(new_<BoxTree<TV>>(edge_boxes,leaf_size))
+  , face_tree(new_<BoxTree<TV>>(face_boxes,leaf_size)) {}
+
+CollisionDetector::~CollisionDetector() {}
+
+// Recompute leaf boxes from new primitive boxes, keeping the tree structure
+static void refit(BoxTree<TV>& tree, RawArray<const Box<TV>> boxes) {
+  for (const int n : tree.leaves) {
+    Box<TV> box;
+    for (const int p : tree.prims(n))
+      box.enlarge(boxes[p]);
+    tree.boxes[n] = box;
+  }
+  tree.update_nonleaf_boxes();
+}
+
+void CollisionDetector::update(Field<const TV,VertexId> X0, Field<const TV,VertexId> X1) {
+  vertex_boxes = swept_boxes(*mesh,vertices,X0,X1);
+  edge_boxes = swept_boxes(*mesh,edges,X0,X1);
+  face_boxes = swept_boxes(*mesh,faces,X0,X1);
+  this->X0 = X0;
+  this->X1 = X1;
+  refit(vertex_tree,vertex_boxes);
+  refit(edge_tree,edge_boxes);
+  refit(face_tree,face_boxes);
+}
+
+// Both queries test candidates exactly inside a parallel double traversal.  Each subtraversal gets its own visitor,
+// and the visitors come back in serial traversal order, so the results are independent of the number of threads.
+// Visitors hold plain references to the detector, so creating them causes no reference count traffic.
+
+Array<Vector<HalfedgeId,2>> CollisionDetector::edge_edge_collisions() const {
+  struct Visitor {
+    const CollisionDetector& self;
+    Array<Vector<HalfedgeId,2>> found;
+
+    bool cull(const int n) const { return false; }
+    bool cull(const int n0, const int n1) const { return false; }
+
+    void test(const int i, const int j) {
+      if (!self.edge_boxes[i].intersects(self.edge_boxes[j]))
+        return;
+      const auto ei = self.edges[i], ej = self.edges[j];
+      const auto a = self.mesh->vertices(ei),
+                 b = self.mesh->vertices(ej);
+      if (a.contains(b.x) || a.contains(b.y))
+        return;
+      const auto &X0 = self.X0, &X1 = self.X1;
+      if (edge_edge_collision_parity(X0[a.x],X0[a.y],X0[b.x],X0[b.y],
+                                     X1[a.x],X1[a.y],X1[b.x],X1[b.y]))
+        found.append(ei<ej ? vec(ei,ej) : vec(ej,ei));
+    }
+
+    void leaf(const int n) {
+      const auto prims = self.edge_tree->prims(n);
+      for (const int i : range(prims.size()))
+        for (const int j : range(i+1,prims.size()))
+          test(prims[i],prims[j]);
+    }
+
+    void leaf(const int n0, const int n1) {
+      for (const int i : self.edge_tree->prims(n0))
+        for (const int j : self.edge_tree->prims(n1))
+          test(i,j);
+    }
+  };
+  Array<Vector<HalfedgeId,2>> collisions;
+  for (const auto& visitor : parallel_double_traverse(*edge_tree,[this]() { return Visitor({*this}); }))
+    collisions.extend(visitor.found);
+  return collisions;
+}
+
+Tuple<Array<VertexId>,Array<FaceId>> CollisionDetector::vertex_face_collisions() const {
+  struct Visitor {
+    const CollisionDetector& self;
+    Array<VertexId> found_vertices;
+    Array<FaceId> found_faces;
+
+    bool cull(const int nv, const int nf) const { return false; }
+
+    void leaf(const int nv, const int nf) {
+      const auto &X0 = self.X0, &X1 = self.X1;
+      for (const int i : self.vertex_tree->prims(nv))
+        for (const int j : self.face_tree->prims(nf)) {
+          if (!self.vertex_boxes[i].intersects(self.face_boxes[j]))
+            continue;
+          const auto v = self.vertices[i];
+          const auto f = self.faces[j];
+          const auto t = self.mesh->vertices(f);
+          if (t.contains(v))
+            continue;
+          if (point_triangle_collision_parity(X0[v],X0[t.x],X0[t.y],X0[t.z],
+                                              X1[v],X1[t.x],X1[t.y],X1[t.z])) {
+            found_vertices.append(v);
+            found_faces.append(f);
+          }
+        }
+    }
+  };
+  Array<VertexId> vertices;
+  Array<FaceId> faces;
+  for (const auto& visitor : parallel_double_traverse(*vertex_tree,*face_tree,[this]() { return Visitor({*this}); })) {
+    vertices.extend(visitor.found_vertices);
+    faces.extend(visitor.found_faces);
+  }
+  return tuple(vertices,faces);
+}
+
+}
+using namespace geode;
+
+void wrap_collision_detector() {
+  typedef CollisionDetector Self;
+  Class<Self>("CollisionDetector")
+    .GEODE_INIT(const TriangleTopology&,Field<const TV,VertexId>,Field<const TV,VertexId>)
+    .GEODE_FIELD(mesh)
+    .GEODE_FIELD(vertices)
+    .GEODE_FIELD(edges)
+    .GEODE_FIELD(faces)
+    .GEODE_METHOD(update)
+    .GEODE_METHOD(edge_edge_collisions)
+    .GEODE_METHOD(vertex_face_collisions)
+    ;
+}
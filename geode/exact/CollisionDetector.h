@@ -0,0 +1,51 @@
+// Continuous collision detection for deforming triangle meshes
+#pragma once
+
+#include <geode/geometry/BoxTree.h>
+#include <geode/mesh/TriangleTopology.h>
+namespace geode {
+
+// CollisionDetector finds collisions in a triangle mesh whose vertices move linearly from X0 to X1 over a time step.
+// Candidate pairs come from double traversals of BoxTrees over the swept boxes (the boxes containing the start and end
+// positions) of the vertices, edges, and faces.  Candidates are then checked in parallel with the exact root parity tests
+// edge_edge_collision_parity and point_triangle_collision_parity from collision.h.  Pairs sharing a vertex always touch,
+// so they are skipped.
+//
+// Root parity tests report an odd number of crossings during the motion, so a pair which collides twice within a single
+// step is not reported; time steps should be small enough to make this unlikely.
+//
+// For the next time step, update refits the existing trees to new positions, keeping their structure.  This stays
+// efficient as long as the mesh deforms smoothly; after large changes, construct a new detector instead.
+class CollisionDetector : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef real T;
+  typedef Vector<T,3> TV;
+
+  const Ref<const TriangleTopology> mesh;
+  const Array<const VertexId> vertices;
+  const Array<const HalfedgeId> edges; // One interior halfedge for each edge
+  const Array<const FaceId> faces;
+
+private:
+  Field<const TV,VertexId> X0, X1; // Start and end positions
+  Array<Box<TV>> vertex_boxes, edge_boxes, face_boxes; // Swept boxes of each primitive
+  const Ref<BoxTree<TV>> vertex_tree, edge_tree, face_tree;
+
+protected:
+  GEODE_CORE_EXPORT CollisionDetector(const TriangleTopology& mesh, Field<const TV,VertexId> X0, Field<const TV,VertexId> X1);
+public:
+  ~CollisionDetector();
+
+  // Move to a new time step, refitting the trees
+  GEODE_CORE_EXPORT void update(Field<const TV,VertexId> X0, Field<const TV,VertexId> X1);
+
+  // Pairs of edges which collide during the motion, each given by its halfedge in edges
+  GEODE_CORE_EXPORT Array<Vector<HalfedgeId,2>> edge_edge_collisions() const;
+
+  // Vertices and faces which collide during the motion
+  GEODE_CORE_EXPORT Tuple<Array<VertexId>,Array<FaceId>> vertex_face_collisions() const;
+};
+
+}
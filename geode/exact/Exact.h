@@ -84,7 +84,7 @@ template<int d> static inline bool operator==(const Exact<d>& lhs, const Exact<d
   if(Exact<d>::limbs == 1)
     return lhs.n[0] == rhs.n[0];
   else
-    return mpn_cmp(lhs.n, rhs.n, Exact<d>::limbs) == 0;
+    return !memcmp(lhs.n, rhs.n, sizeof(lhs.n));
 }
 
 // For template compatibility with Interval
@@ -116,6 +116,43 @@ template<int d> static inline bool operator>(const Exact<d>& lhs, const Exact<d>
 // Pull in autogenerated arithmetic routines
 #include <geode/exact/exact-generated.h>
 
+// In place operations for any limb count, used to run symbolic perturbation without gmp (see perturb.h).  Since the
+// limb count is a compile time constant, these compile to straight line code.  All arithmetic is modulo 2^(64*limbs),
+// so the results are correct for 2's complement inputs whenever the true result fits.
+
+// x -= y
+template<int a> static inline void sub_in_place(Exact<a>& x, const Exact<a>& y) {
+  bool borrow = 0;
+  for (int i=0;i<x.limbs;i++) {
+    const auto t = __uint128_t(x.n[i])-y.n[i]-borrow;
+    borrow = t>>64;
+    x.n[i] = uint64_t(t);
+  }
+}
+
+// x *= s
+template<int a> static inline void mul_in_place(Exact<a>& x, const uint64_t s) {
+  uint64_t carry = 0;
+  for (int i=0;i<x.limbs;i++) {
+    const auto t = __uint128_t(x.n[i])*s+carry;
+    carry = uint64_t(t>>64);
+    x.n[i] = uint64_t(t);
+  }
+}
+
+// x -= s*y
+template<int a> static inline void submul_in_place(Exact<a>& x, const Exact<a>& y, const uint64_t s) {
+  uint64_t carry = 0;
+  bool borrow = 0;
+  for (int i=0;i<x.limbs;i++) {
+    const auto p = __uint128_t(y.n[i])*s+carry;
+    carry = uint64_t(p>>64);
+    const auto t = __uint128_t(x.n[i])-uint64_t(p)-borrow;
+    borrow = t>>64;
+    x.n[i] = uint64_t(t);
+  }
+}
+
 #endif // GEODE_FAST_EXACT
 
 template<int a> GEODE_PURE static inline Exact<a> operator+(const Exact<a> x, const Exact<a> y) {
@@ -205,8 +242,14 @@ template<int a> GEODE_PURE static inline Exact<a> operator-(const Exact<a> x) {
   Exact<a> r(uninit);
   if (r.limbs==1)
     r.n[0] = mp_limb_t(-mp_limb_signed_t(x.n[0]));
-  else
+  else {
+#if GEODE_FAST_EXACT
+    memset(r.n,0,sizeof(r.n));
+    sub_in_place(r,x);
+#else
     mpn_neg(r.n,x.n,x.limbs);
+#endif
+  }
   return r;
 }
 
@@ -0,0 +1,95 @@
+// Floating point filter with a forward error bound
+#pragma once
+
+// FloatFilter is the first stage of perturbed_predicate, ahead of interval arithmetic.  It evaluates a polynomial
+// in ordinary floating point while tracking a magnitude and an error index for each intermediate, following the
+// semi-static filter of Burnikel, Funke, and Schirra (a generalization of Shewchuk's stage A error bounds).  Unlike
+// Interval it never depends on the rounding mode, so it is equally valid inside or outside an IntervalScope, and
+// costs only a few extra flops per operation.
+//
+// If each input is exact, the computed value differs from the exact one by at most ind*mag*2^-52 in any rounding
+// mode, up to second order terms.  weak_sign uses 2^-51 to absorb those and the rounding of the bound itself.
+// Overflow produces inf or nan, which weak_sign rejects.  Underflow is impossible for quantized inputs, since every
+// intermediate is an integer.
+
+#include <geode/exact/config.h>
+#include <geode/utility/type_traits.h>
+#include <cmath>
+namespace geode {
+
+struct FloatFilter;
+template<> struct IsScalar<FloatFilter> : public mpl::true_ {};
+
+struct FloatFilter {
+  double value; // Computed value
+  double mag; // Bound on the magnitude of every term contributing to value
+  int ind; // Error index: |value-exact| <= ind*mag*2^-52
+
+  FloatFilter()
+    : value(0), mag(0), ind(0) {}
+
+  FloatFilter(const double x)
+    : value(x), mag(fabs(x)), ind(0) {}
+
+  FloatFilter(const double value, const double mag, const int ind)
+    : value(value), mag(mag), ind(ind) {}
+
+  FloatFilter operator+(const FloatFilter x) const {
+    return FloatFilter(value+x.value,mag+x.mag,1+(ind>x.ind?ind:x.ind));
+  }
+
+  FloatFilter operator-(const FloatFilter x) const {
+    return FloatFilter(value-x.value,mag+x.mag,1+(ind>x.ind?ind:x.ind));
+  }
+
+  FloatFilter operator*(const FloatFilter x) const {
+    return FloatFilter(value*x.value,mag*x.mag,1+ind+x.ind);
+  }
+
+  FloatFilter operator-() const {
+    return FloatFilter(-value,mag,ind);
+  }
+
+  FloatFilter& operator+=(const FloatFilter x) {
+    return *this = *this+x;
+  }
+
+  FloatFilter& operator-=(const FloatFilter x) {
+    return *this = *this-x;
+  }
+
+  FloatFilter& operator*=(const FloatFilter x) {
+    return *this = *this*x;
+  }
+};
+
+static inline FloatFilter operator+(const double x, const FloatFilter y) {
+  return FloatFilter(x)+y;
+}
+
+static inline FloatFilter operator-(const double x, const FloatFilter y) {
+  return FloatFilter(x)-y;
+}
+
+static inline FloatFilter sqr(const FloatFilter x) {
+  return FloatFilter(x.value*x.value,x.mag*x.mag,1+2*x.ind);
+}
+
+// Scaling by a power of two is exact
+GEODE_ALWAYS_INLINE static inline FloatFilter operator<<(const FloatFilter x, const int p) {
+  return FloatFilter(ldexp(x.value,p),ldexp(x.mag,p),x.ind);
+}
+
+GEODE_ALWAYS_INLINE static inline FloatFilter operator>>(const FloatFilter x, const int p) {
+  return x<<-p;
+}
+
+// The sign of x if it is certain, otherwise zero
+static inline int weak_sign(const FloatFilter x) {
+  const double error = ldexp((x.ind+1)*x.mag,-51);
+  return x.value >  error ?  1
+       : x.value < -error ? -1
+                          :  0;
+}
+
+}
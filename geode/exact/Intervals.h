@@ -0,0 +1,187 @@
+// Wide interval arithmetic for filtering batches of predicates
+#pragma once
+
+// Intervals<w> is w independent intervals stored as separate arrays of lower and upper bounds, so that each
+// operation acts on every lane at once without data dependent branches.  The operations are fixed length omp simd
+// loops over the lanes, which the compiler turns into packed SSE2, AVX2, or AVX-512 instructions depending on the
+// target, so no intrinsics are needed.  By default, each array of bounds fills one AVX2 or AVX-512 register.
+// As with Interval, all arithmetic must occur within an IntervalScope.
+//
+// Intervals<w> is used by perturbed_predicates (see perturb.h) to evaluate a predicate on w queries at once.
+
+#include <geode/exact/config.h>
+#include <geode/exact/scope.h>
+#include <geode/utility/type_traits.h>
+#include <cstring>
+namespace geode {
+
+#ifndef GEODE_INTERVALS_WIDTH
+#ifdef __AVX512F__
+#define GEODE_INTERVALS_WIDTH 8
+#else
+#define GEODE_INTERVALS_WIDTH 4
+#endif
+#endif
+
+template<int w> struct Intervals;
+template<int w> struct IsScalar<Intervals<w>> : public mpl::true_ {};
+
+// Negate by flipping the sign bit.  As in Interval.h, this hides the identity x * -y = -(x * y) from the compiler.
+// Unlike for Interval, this is needed for gcc as well: once the lane loops are inlined into a predicate, gcc applies
+// the identity and the resulting bounds are no longer conservative.
+static inline double lane_neg(const double x) {
+  uint64_t i;
+  memcpy(&i,&x,sizeof(x));
+  i ^= uint64_t(1)<<63;
+  double y;
+  memcpy(&y,&i,sizeof(y));
+  return y;
+}
+
+// Unlike std::max, this maps directly onto packed max instructions
+static inline double lane_max(const double a, const double b) {
+  return a>b ? a : b;
+}
+
+template<int w> struct Intervals {
+  typedef IntervalScope Scope;
+  static_assert(w>0,"");
+  static const int width = w;
+
+  // As in Interval, lane i is the interval [-nlo[i],hi[i]], so that only FE_UPWARD is needed
+  GEODE_ALIGNED(8*w) double nlo[w];
+  GEODE_ALIGNED(8*w) double hi[w];
+
+  Intervals() {
+    #pragma omp simd
+    for (int i=0;i<w;i++)
+      nlo[i] = hi[i] = 0;
+  }
+
+  // Every lane equal to x
+  Intervals(const double x) {
+    #pragma omp simd
+    for (int i=0;i<w;i++) {
+      nlo[i] = -x;
+      hi[i] = x;
+    }
+  }
+
+  // Set lane i to exactly x
+  void set(const int i, const double x) {
+    assert(unsigned(i)<unsigned(w));
+    nlo[i] = -x;
+    hi[i] = x;
+  }
+
+  Intervals operator+(const Intervals& x) const {
+    assert(fegetround() == FE_UPWARD);
+    Intervals r;
+    #pragma omp simd
+    for (int i=0;i<w;i++) {
+      r.nlo[i] = nlo[i]+x.nlo[i];
+      r.hi[i] = hi[i]+x.hi[i];
+    }
+    return r;
+  }
+
+  Intervals operator-(const Intervals& x) const {
+    assert(fegetround() == FE_UPWARD);
+    Intervals r;
+    #pragma omp simd
+    for (int i=0;i<w;i++) {
+      r.nlo[i] = nlo[i]+x.hi[i];
+      r.hi[i] = hi[i]+x.nlo[i];
+    }
+    return r;
+  }
+
+  Intervals operator-() const {
+    Intervals r;
+    #pragma omp simd
+    for (int i=0;i<w;i++) {
+      r.nlo[i] = hi[i];
+      r.hi[i] = nlo[i];
+    }
+    return r;
+  }
+
+  // Branch free, as in the SSE version of Interval::operator*:
+  //   [a,b]*[c,d] = [-max(na^d,b^nc,na^-nc,b^-d),max(na^nc,b^d,na^-d,b^-nc)]
+  // where ^ is multiplication rounded up.
+  Intervals operator*(const Intervals& x) const {
+    assert(fegetround() == FE_UPWARD);
+    Intervals r;
+    #pragma omp simd
+    for (int i=0;i<w;i++) {
+      const double na = nlo[i], b = hi[i],
+                   nc = x.nlo[i], d = x.hi[i],
+                   nna = lane_neg(na), nb = lane_neg(b);
+      r.nlo[i] = lane_max(lane_max(na*d,b*nc),lane_max(nna*nc,nb*d));
+      r.hi[i] = lane_max(lane_max(na*nc,b*d),lane_max(nna*d,nb*nc));
+    }
+    return r;
+  }
+
+  Intervals& operator+=(const Intervals& x) { return *this = *this+x; }
+  Intervals& operator-=(const Intervals& x) { return *this = *this-x; }
+  Intervals& operator*=(const Intervals& x) { return *this = *this*x; }
+};
+
+template<int w> const int Intervals<w>::width;
+
+template<int w> static inline Intervals<w> operator+(const double x, const Intervals<w>& y) {
+  return Intervals<w>(x)+y;
+}
+
+template<int w> static inline Intervals<w> operator-(const double x, const Intervals<w>& y) {
+  return Intervals<w>(x)-y;
+}
+
+// The lower bound is the square of the endpoint nearest zero, or zero if the interval contains zero
+template<int w> static inline Intervals<w> sqr(const Intervals<w>& x) {
+  assert(fegetround() == FE_UPWARD);
+  Intervals<w> r;
+  #pragma omp simd
+  for (int i=0;i<w;i++) {
+    const double m = lane_max(lane_max(lane_neg(x.nlo[i]),lane_neg(x.hi[i])),0.);
+    r.nlo[i] = m*lane_neg(m);
+    r.hi[i] = lane_max(x.nlo[i]*x.nlo[i],x.hi[i]*x.hi[i]);
+  }
+  return r;
+}
+
+// Shifts are exact
+template<int w> GEODE_ALWAYS_INLINE static inline Intervals<w> operator<<(const Intervals<w>& x, const int p) {
+  assert(unsigned(p)<32);
+  const double y = 1<<p;
+  Intervals<w> r;
+  #pragma omp simd
+  for (int i=0;i<w;i++) {
+    r.nlo[i] = y*x.nlo[i];
+    r.hi[i] = y*x.hi[i];
+  }
+  return r;
+}
+
+template<int w> GEODE_ALWAYS_INLINE static inline Intervals<w> operator>>(const Intervals<w>& x, const int p) {
+  assert(unsigned(p)<32);
+  const double y = 1./(1<<p);
+  Intervals<w> r;
+  #pragma omp simd
+  for (int i=0;i<w;i++) {
+    r.nlo[i] = y*x.nlo[i];
+    r.hi[i] = y*x.hi[i];
+  }
+  return r;
+}
+
+// The sign of lane i if it is certain, otherwise zero
+template<int w> static inline int weak_sign(const Intervals<w>& x, const int i) {
+  assert(unsigned(i)<unsigned(w));
+  return x.nlo[i]<0 ?  1
+       : x.hi[i] <0 ? -1
+                    :  0;
+}
+
+}
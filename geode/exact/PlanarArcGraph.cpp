@@ -5,6 +5,7 @@
 #include <geode/mesh/ComponentData.h>
 #include <geode/python/Class.h>
 #include <geode/utility/curry.h>
+#include <geode/utility/openmp.h>
 
 namespace geode {
 
@@ -193,32 +194,66 @@ template<Pb PS> Array<CircleId> CircleTree<PS>::circles_active_near(const Circle
 
 namespace { template<Pb PS> struct IntersectionHelper {
   const CircleTree<PS>& tree;
-  VertexSet<PS>& vertices;
+  Array<Vector<int,2>> pairs; // Candidate pairs of leaves, in traversal order
   bool cull(const int n) const { return false; }
   bool cull(const int n0, const int n1) const { return false; }
   void leaf(const int n) const { assert(tree.tree->prims(n).size()==1); }
   void leaf(const int n0, const int n1) {
     if(n0 == n1) // Only check unique arcs
       return;
-    const auto b = Box<Vec2>::intersect(tree.tree->boxes[n0],tree.tree->boxes[n1]);
-    assert(!b.empty());
-    const CircleId cid0 = tree.prim(n0);
-    const CircleId cid1 = tree.prim(n1);
-    const auto& c0 = vertices.circle(cid0);
-    const auto& c1 = vertices.circle(cid1);
-
-    for(const auto& i : c0.intersections_if_any(c1)) {
-      if(b.intersects(i.approx.box()))
-        vertices.get_or_insert(i, cid0, cid1);
-    }
+    assert(!Box<Vec2>::intersect(tree.tree->boxes[n0],tree.tree->boxes[n1]).empty());
+    pairs.append(vec(n0,n1));
   }
-
 };}
 
+template<Pb PS> Array<Vector<int,2>> CircleTree<PS>::candidate_pairs() const {
+  IntersectionHelper<PS> helper({*this});
+  double_traverse(*tree, helper);
+  return helper.pairs;
+}
+
+template<Pb PS> void insert_intersections(VertexSet<PS>& vertices, RawArray<const Vector<CircleId,2>> pairs,
+                                          RawArray<const Box<Vec2>> boxes) {
+  assert(!boxes.size() || boxes.size()==pairs.size());
+  // Exact intersections dominate the cost, so compute them in parallel with each block of candidate pairs
+  // writing to its own buffer.  Merging the buffers in pair order inserts vertices in exactly the same
+  // order (and thus with the same ids) as a serial pass.
+  const int block_size = 256;
+  const int blocks = (pairs.size()+block_size-1)/block_size;
+  vector<Array<IncidentVertexInfo<PS>>> found(blocks);
+  OmpExceptions errors;
+  #pragma omp parallel if (blocks>1)
+  {
+    IntervalScope scope;
+    #pragma omp for schedule(dynamic,1)
+    for (int k=0;k<blocks;k++) errors.capture([&]{
+      for (const int p : range(k*block_size,min(pairs.size(),(k+1)*block_size))) {
+        const CircleId cid0 = pairs[p].x;
+        const CircleId cid1 = pairs[p].y;
+        for(const auto& i : vertices.circle(cid0).intersections_if_any(vertices.circle(cid1))) {
+          if(!boxes.size() || boxes[p].intersects(i.approx.box()))
+            found[k].append(IncidentVertexInfo<PS>({i, cid0, cid1}));
+        }
+      }
+    });
+  }
+  errors.rethrow();
+  for (const auto& block : found)
+    for (const auto& v : block)
+      vertices.get_or_insert(v.i, v.ref_cid, v.inc_cid);
+}
+
 template<Pb PS> static CircleTree<PS> insert_circle_intersections(VertexSet<PS>& vertices, const ArcContours& contours) {
   const auto tree = CircleTree<PS>(vertices, contours);
-  IntersectionHelper<PS> helper({tree, vertices});
-  double_traverse(*(tree.tree), helper);
+  const auto leaves = tree.candidate_pairs();
+  Array<Vector<CircleId,2>> pairs(leaves.size(),uninit);
+  Array<Box<Vec2>> boxes(leaves.size(),uninit);
+  for (const int i : range(leaves.size())) {
+    const auto n = leaves[i];
+    pairs[i] = vec(tree.prim(n.x),tree.prim(n.y));
+    boxes[i] = Box<Vec2>::intersect(tree.tree->boxes[n.x],tree.tree->boxes[n.y]);
+  }
+  insert_intersections(vertices, pairs, boxes);
   // This doesn't ensure added intersections are on contours so some spurious vertices can be added
   // In practice, bounding boxes seem to be tight enough that it is faster to allow a few spurious vertices rather then adding a filtering step
   return tree;
@@ -518,7 +553,11 @@ struct AlwaysOneSequence {
 } // anonymous namespace
 
 template<Pb PS> void PlanarArcGraph<PS>::embed_arcs(const ArcContours& contours, const RawArray<const int8_t> weights) {
-  circle_tree = insert_circle_intersections(vertices, contours);
+  embed_intersected_arcs(insert_circle_intersections(vertices, contours), contours, weights);
+}
+
+template<Pb PS> void PlanarArcGraph<PS>::embed_intersected_arcs(const CircleTree<PS>& tree, const ArcContours& contours, const RawArray<const int8_t> weights) {
+  circle_tree = tree;
   incident_order = VertexSort<PS>(vertices);
   if(weights.empty()) {
     edge_srcs = init_topology_and_windings(topology, edge_windings, outgoing_edges, vertices, contours, AlwaysOneSequence{}, incident_order);
@@ -1331,6 +1370,8 @@ template<Pb PS> Tuple<Quantizer<real,2>,Ref<PlanarArcGraph<PS>>> quantize_circle
   template Tuple<Quantizer<real,2>,Ref<PlanarArcGraph<PS>>> quantize_circle_arcs(const Nested<const CircleArc> arcs); \
   template Field<bool, FaceId> faces_greater_than(const PlanarArcGraph<PS>& g, const int depth); \
   template Field<bool, FaceId> odd_faces(const PlanarArcGraph<PS>& g); \
+  template void insert_intersections(VertexSet<PS>& vertices, RawArray<const Vector<CircleId,2>> pairs, \
+                                     RawArray<const Box<Vec2>> boxes); \
   template SmallArray<CircleArc, 2> unquantize_arc(const Quantizer<real,2>& quant, const ExactArc<PS>& unsigned_arc, const ArcDirection direction); \
 //INSTANTIATE(Pb::Explicit)
 INSTANTIATE(Pb::Implicit)
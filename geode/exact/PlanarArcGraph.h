@@ -248,8 +248,16 @@ template<Pb PS> class CircleTree {
   // Traverse the box tree and find any circles that have arcs inside 'bounds'
   // Warning: This is not all circles that intersect bounds! Circles are clipped to 'active' regions traversed by contours in initialization
   Array<CircleId> circles_active_near(const CircleSet<PS>& circles, const Box<Vec2> bounds) const;
+
+  // Pairs of distinct leaves with overlapping boxes, in traversal order
+  Array<Vector<int,2>> candidate_pairs() const;
 };
 
+// Add the intersections of each pair of circles to vertices, keeping only those touching boxes[i] if boxes is nonempty
+// Exact intersections are computed in parallel, but inserted in pair order so ids don't depend on the number of threads
+template<Pb PS> void insert_intersections(VertexSet<PS>& vertices, RawArray<const Vector<CircleId,2>> pairs,
+                                          RawArray<const Box<Vec2>> boxes);
+
 // VertexSort iterator that traverses IncidentIds in CCW order around a circle
 struct IncidentCirculator {
   RawArray<const IncidentId> incidents;
@@ -335,6 +343,10 @@ public:
   // All vertices and circles must have been added to vertices
   void embed_arcs(const ArcContours& contours, RawArray<const int8_t> weights={});
 
+  // As embed_arcs, but for callers that have already added all intersections between arcs of contours to vertices
+  // circle_tree must have been computed from vertices and contours
+  void embed_intersected_arcs(const CircleTree<PS>& circle_tree, const ArcContours& contours, RawArray<const int8_t> weights={});
+
   inline CircleId circle_id(const EdgeId eid) const;
   inline IncidentId src(const EdgeId eid) const;
   inline IncidentId dst(const EdgeId eid) const;
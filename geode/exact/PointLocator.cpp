@@ -0,0 +1,278 @@
+// Point location in planar triangulations
+
+#include <geode/exact/PointLocator.h>
+#include <geode/array/amap.h>
+#include <geode/exact/Exact.h>
+#include <geode/exact/predicates.h>
+#include <geode/exact/scope.h>
+#include <geode/geometry/Triangle2d.h>
+#include <geode/python/Class.h>
+#include <geode/utility/openmp.h>
+#include <algorithm>
+namespace geode {
+
+typedef real T;
+typedef Vector<T,2> TV;
+typedef Vector<Quantized,2> EV;
+using exact::Perturbed2;
+
+GEODE_DEFINE_TYPE(PointLocator)
+
+// Sign of the unperturbed orientation of a triangle
+static int orientation(const EV a, const EV b, const EV c) {
+  const auto d = [](const Quantized x, const Quantized y) { return Exact<1>(ExactInt(x)-ExactInt(y)); };
+  return sign(d(b.x,a.x)*d(c.y,a.y)-d(b.y,a.y)*d(c.x,a.x));
+}
+
+// Interleave the bits of x with zeros
+static inline uint64_t spread_bits(const uint32_t x) {
+  uint64_t v = x;
+  v = (v|v<<16)&0x0000ffff0000ffffu;
+  v = (v|v<<8) &0x00ff00ff00ff00ffu;
+  v = (v|v<<4) &0x0f0f0f0f0f0f0f0fu;
+  v = (v|v<<2) &0x3333333333333333u;
+  v = (v|v<<1) &0x5555555555555555u;
+  return v;
+}
+
+// Is the boundary a single convex loop?  Boundary halfedges run clockwise.
+static bool convex_boundary(const TriangleTopology& mesh, RawField<const EV,VertexId> Q) {
+  const auto loops = mesh.boundary_loops();
+  if (loops.size()!=1)
+    return false;
+  for (const auto b : loops.flat)
+    if (orientation(Q[mesh.src(b)],Q[mesh.dst(b)],Q[mesh.dst(mesh.next(b))])>0)
+      return false;
+  return true;
+}
+
+PointLocator::PointLocator(const TriangleTopology& mesh, Field<const TV,VertexId> X)
+  : mesh(ref(mesh))
+  , X(X)
+  , box(bounding_box(X.flat))
+  , quant(quantizer(box))
+  , Q(amap(quant,X.flat).copy())
+  , convex(convex_boundary(mesh,Q)) {
+  GEODE_ASSERT(X.size()==mesh.allocated_vertices());
+
+  // Choose roughly four faces per seed cell, and seed each cell with any face whose centroid lies inside
+  const int nf = mesh.n_faces();
+  const TV sizes = box.sizes();
+  const T cell = sqrt(4*sizes.x*sizes.y/max(nf,1));
+  for (const int a : range(2))
+    grid[a] = cell>0 && isfinite(cell) ? clamp(int(ceil(sizes[a]/cell)),1,4096) : 1;
+  seeds.resize(grid.product());
+  for (const auto f : mesh.faces()) {
+    const auto v = mesh.vertices(f);
+    const TV c = (X[v.x]+X[v.y]+X[v.z])/3;
+    auto& s = seeds[seed_cell(c)];
+    if (!s.valid())
+      s = f;
+  }
+  // Fill empty cells from their neighbors, first along rows and then along columns
+  for (const int a : range(2)) {
+    const int stride = a ? 1 : grid.y;
+    const int lines = grid.product()/grid[a];
+    for (const int l : range(lines)) {
+      const int start = a ? l*grid.y : l;
+      for (const int pass : range(2)) {
+        FaceId last;
+        for (const int i : range(grid[a])) {
+          auto& s = seeds[start+stride*(pass ? grid[a]-1-i : i)];
+          if (s.valid())
+            last = s;
+          else
+            s = last;
+        }
+      }
+    }
+  }
+
+  // Walks in nonconvex meshes may be blocked by the boundary even for points inside, so prepare a fallback
+  if (!convex && nf) {
+    const auto tree = mesh.face_tree(X);
+    this->tree = tree.x;
+    tree_faces = tree.y;
+  }
+}
+
+PointLocator::~PointLocator() {}
+
+int PointLocator::seed_cell(const TV p) const {
+  const TV u = (p-box.min)/TV::componentwise_max(box.sizes(),TV(1e-300,1e-300));
+  Vector<int,2> c;
+  for (const int a : range(2))
+    c[a] = clamp(int(u[a]*grid[a]),0,grid[a]-1);
+  return c.x*grid.y+c.y;
+}
+
+struct PointLocator::Walk {
+  const PointLocator& self;
+  const TriangleTopology& mesh;
+  const int query_seed; // Perturbation seed of query points, distinct from all vertices
+  uint32_t state; // For a stochastic walk, which always terminates
+
+  Walk(const PointLocator& self, const uint32_t state)
+    : self(self), mesh(self.mesh), query_seed(mesh.allocated_vertices()), state(state|1) {}
+
+  Perturbed2 P(const VertexId v) const {
+    return Perturbed2(v.id,self.Q[v]);
+  }
+
+  int random3() {
+    state ^= state<<13;
+    state ^= state>>17;
+    state ^= state<<5;
+    return state%3;
+  }
+
+  // Is q in the closed face f, ignoring perturbation?
+  bool closed_contains(const FaceId f, const EV q) const {
+    const auto v = mesh.vertices(f);
+    for (const int i : range(3))
+      if (orientation(self.Q[v[i]],self.Q[v[(i+1)%3]],q)<0)
+        return false;
+    return true;
+  }
+
+  // Walk from f to p, which must be inside the bounding box.  q is p quantized outside of any IntervalScope, so that
+  // it rounds exactly as the vertices did.
+  FaceId operator()(FaceId f, const TV p, const EV q) {
+    if (!f.valid())
+      return FaceId();
+    const Perturbed2 pq(query_seed,q);
+    HalfedgeId from;
+    for (;;) {
+      const auto es = mesh.halfedges(f);
+      const int k0 = random3();
+      for (const int k : range(3)) {
+        const auto e = es[(k0+k)%3];
+        if (e==from)
+          continue;
+        if (!triangle_oriented(P(mesh.src(e)),P(mesh.dst(e)),pq)) {
+          from = mesh.reverse(e);
+          if (mesh.is_boundary(from))
+            return blocked(from,p,q);
+          f = mesh.face(from);
+          goto next;
+        }
+      }
+      return f;
+      next:;
+    }
+  }
+
+  // Resolve a walk blocked by boundary halfedge b
+  FaceId blocked(HalfedgeId b, const TV p, const EV q) const {
+    if (!self.convex)
+      return fallback(p,q);
+    // In a convex mesh, q is outside unless it lies on the boundary.  Follow the boundary towards q while collinear.
+    for (int i=0;i<mesh.n_boundary_edges();i++) {
+      const auto u = self.Q[mesh.src(b)],
+                 v = self.Q[mesh.dst(b)];
+      if (orientation(u,v,q))
+        break;
+      const auto f = mesh.face(mesh.reverse(b));
+      if (closed_contains(f,q))
+        return f;
+      const int a = abs(v.x-u.x)>=abs(v.y-u.y) ? 0 : 1;
+      b = (q[a]>v[a])==(v[a]>u[a]) ? mesh.next(b) : mesh.prev(b);
+    }
+    return FaceId();
+  }
+
+  // Find a face containing q using the SimplexTree, checking exactly
+  FaceId fallback(const TV p, const EV q) const {
+    const auto closest = self.tree->closest_point(p);
+    if (magnitude(closest.x-p) > 1e-10*self.box.sizes().max())
+      return FaceId();
+    const auto f = self.tree_faces[closest.y];
+    if (closed_contains(f,q))
+      return f;
+    for (const auto v : mesh.vertices(f))
+      for (const auto e : mesh.outgoing(v))
+        if (!mesh.is_boundary(e) && closed_contains(mesh.face(e),q))
+          return mesh.face(e);
+    return FaceId();
+  }
+};
+
+FaceId PointLocator::locate_point(const TV p) const {
+  if (!box.lazy_inside(p))
+    return FaceId();
+  const EV q = quant(p);
+  IntervalScope scope;
+  Walk walk(*this,1);
+  return walk(seeds[seed_cell(p)],p,q);
+}
+
+Array<FaceId> PointLocator::locate(RawArray<const TV> points) const {
+  const int n = points.size();
+  Array<FaceId> faces(n);
+
+  // Quantize and sort queries along a Morton curve, putting those outside the bounding box last
+  Array<EV> Q(n,uninit);
+  Array<Tuple<uint64_t,int>> order(n,uninit);
+  const T scale = T(uint32_t(-1))/max(box.sizes().max(),T(1e-300));
+  #pragma omp parallel for
+  for (int i=0;i<n;i++) {
+    const TV p = points[i];
+    uint64_t key = uint64_t(-1);
+    if (box.lazy_inside(p)) {
+      Q[i] = quant(p);
+      const TV u = scale*(p-box.min);
+      key = spread_bits(uint32_t(u.x))<<1|spread_bits(uint32_t(u.y));
+    }
+    order[i] = tuple(key,i);
+  }
+  std::sort(order.begin(),order.end());
+
+  // Walk through each chunk of nearby queries, starting from the previous answer
+  const int chunk = 1024;
+  OmpExceptions errors;
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int c=0;c<(n+chunk-1)/chunk;c++) errors.capture([&]{
+    IntervalScope scope;
+    Walk walk(*this,c+1);
+    FaceId prev;
+    for (const int i : range(c*chunk,min(n,(c+1)*chunk))) {
+      const int j = order[i].y;
+      const TV p = points[j];
+      if (!box.lazy_inside(p))
+        continue;
+      faces[j] = walk(prev.valid() ? prev : seeds[seed_cell(p)],p,Q[j]);
+      if (faces[j].valid())
+        prev = faces[j];
+    }
+  });
+  errors.rethrow();
+  return faces;
+}
+
+Tuple<Array<FaceId>,Array<Vector<T,3>>> PointLocator::locate_barycentric(RawArray<const TV> points) const {
+  const auto faces = locate(points);
+  Array<Vector<T,3>> weights(points.size());
+  #pragma omp parallel for
+  for (int i=0;i<points.size();i++)
+    if (faces[i].valid()) {
+      const auto v = mesh->vertices(faces[i]);
+      weights[i] = Triangle<TV>::barycentric_coordinates(points[i],X[v.x],X[v.y],X[v.z]);
+    }
+  return tuple(faces,weights);
+}
+
+}
+using namespace geode;
+
+void wrap_point_locator() {
+  typedef PointLocator Self;
+  Class<Self>("PointLocator")
+    .GEODE_INIT(const TriangleTopology&,Field<const TV,VertexId>)
+    .GEODE_FIELD(mesh)
+    .GEODE_FIELD(X)
+    .GEODE_FIELD(convex)
+    .GEODE_METHOD(locate_point)
+    .GEODE_METHOD(locate)
+    .GEODE_METHOD(locate_barycentric)
+    ;
+}
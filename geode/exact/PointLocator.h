@@ -0,0 +1,62 @@
+// Point location in planar triangulations
+#pragma once
+
+#include <geode/exact/config.h>
+#include <geode/exact/quantize.h>
+#include <geode/geometry/SimplexTree.h>
+#include <geode/mesh/TriangleTopology.h>
+namespace geode {
+
+// PointLocator finds the faces of a 2D TriangleTopology containing query points by walking through the mesh.
+// Each walk starts from a seed face taken from a coarse grid over the mesh, or, for batches, from the previous
+// answer: batch queries are sorted along a Morton curve and split into chunks processed in parallel, so most walks
+// take only a few steps.  Walk decisions use exact perturbed orientation tests on quantized coordinates, so every
+// point strictly inside a face is found there, and points exactly on edges or vertices get one of the faces
+// touching them.
+//
+// Walks are blocked only at the boundary.  For a convex mesh this proves the point is outside (after following any
+// collinear boundary).  For nonconvex meshes (or meshes with holes), blocked queries fall back to a SimplexTree over
+// the faces, built up front.  Points outside the mesh get an invalid FaceId.
+class PointLocator : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef real T;
+  typedef Vector<T,2> TV;
+  typedef Vector<Quantized,2> EV;
+
+  const Ref<const TriangleTopology> mesh;
+  const Field<const TV,VertexId> X;
+  const Box<TV> box; // Bounding box of the mesh, outside of which all queries fail immediately
+  const Quantizer<T,2> quant;
+  const Field<const EV,VertexId> Q; // Quantized vertex positions
+  const bool convex; // Whether the mesh has a single convex boundary loop
+
+private:
+  Vector<int,2> grid; // Size of the seed grid
+  Array<FaceId> seeds; // Seed face for each grid cell
+  Ptr<SimplexTree<TV,2>> tree; // Fallback for blocked walks, only for nonconvex meshes
+  Array<FaceId> tree_faces;
+
+protected:
+  // The mesh must be a valid planar embedding with positively oriented faces
+  GEODE_CORE_EXPORT PointLocator(const TriangleTopology& mesh, Field<const TV,VertexId> X);
+public:
+  ~PointLocator();
+
+  // The face containing p, or invalid if p is outside the mesh
+  GEODE_CORE_EXPORT FaceId locate_point(const TV p) const;
+
+  // The faces containing a batch of points, computed in parallel
+  GEODE_CORE_EXPORT Array<FaceId> locate(RawArray<const TV> points) const;
+
+  // The faces containing a batch of points and their barycentric coordinates, for interpolation.
+  // Points outside the mesh have zero weights.
+  GEODE_CORE_EXPORT Tuple<Array<FaceId>,Array<Vector<T,3>>> locate_barycentric(RawArray<const TV> points) const;
+
+private:
+  struct Walk;
+  int seed_cell(const TV p) const;
+};
+
+}
@@ -14,8 +14,16 @@ else:
 if not has_exact():
   raise ImportError('geode/exact is unavailable since geode was compiled without gmp support')
 
-def delaunay_points(X,edges=zeros((0,2),dtype=int32),validate=False):
-  return delaunay_points_py(X,edges,validate)
+def delaunay_points(X,edges=zeros((0,2),dtype=int32),validate=False,parallel=False):
+  return delaunay_points_py(X,edges,validate,parallel)
+
+def refine_delaunay(X,edges=zeros((0,2),dtype=int32),min_angle=pi/9,max_area=inf):
+  '''Triangulate and refine to a minimum angle (in radians) and maximum area.  Returns mesh,X.'''
+  return refine_delaunay_py(X,edges,min_angle,max_area)
+
+def split_polygons(polys,depth,parallel=False):
+  '''Resolve intersections between polygons and extract the contour with given external depth'''
+  return split_polygons_py(polys,depth,parallel)
 
 def polygon_union(*polys):
   '''The union of possibly intersecting polygons, assuming consistent ordering'''
@@ -396,6 +396,7 @@ void wrap_circle_csg() {
   GEODE_FUNCTION(offset_arcs)
   GEODE_FUNCTION(offset_open_arcs)
   GEODE_FUNCTION(offset_shells)
+  GEODE_FUNCTION(offset_shell_components)
   GEODE_FUNCTION(find_overlapping_offsets)
 #ifdef GEODE_PYTHON
   GEODE_FUNCTION(_set_circle_arc_dtypes)
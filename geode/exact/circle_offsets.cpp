@@ -4,6 +4,8 @@
 #include <geode/exact/exact_circle_offsets.h>
 #include <geode/exact/PlanarArcGraph.h>
 #include <geode/exact/scope.h>
+#include <geode/utility/openmp.h>
+#include <climits>
 
 namespace geode {
 static constexpr Pb PS = Pb::Implicit;
@@ -28,7 +30,7 @@ vector<Nested<CircleArc>> offset_shells(const Nested<const CircleArc> arcs, cons
   const auto input_g = new_<PlanarArcGraph<PS>>(input_verts, input_arcs);
 
   auto shell = tuple(input_g, extract_region(input_g->topology, faces_greater_than(*input_g, 0)));
-  for(int i = 0; i < max_shells; ++i) {
+  for(int i = 0; max_shells < 0 || i < max_shells; ++i) {
     shell = offset_closed_exact_arcs(*shell.x, shell.y, exact_d);
     if(shell.y.empty())
       break;
@@ -37,6 +39,119 @@ vector<Nested<CircleArc>> offset_shells(const Nested<const CircleArc> arcs, cons
   return result;
 }
 
+namespace {
+// A region split off from the shell of its parent component, which still needs to be offset
+struct ShellSeed {
+  Ref<const PlanarArcGraph<PS>> g;
+  Nested<HalfedgeId> contours; // The first shell of the region, as edges of g
+  int parent, first;
+};
+}
+
+// Split a region of g with winding number greater than zero into its connected components
+static vector<Nested<HalfedgeId>> split_components(const PlanarArcGraph<PS>& g, const Nested<HalfedgeId>& contours) {
+  const auto component = region_components(*g.topology, faces_greater_than(g, 0), contours);
+  vector<Nested<HalfedgeId,false>> parts(component.size() ? component.max()+1 : 0);
+  for(const int i : range(contours.size())) {
+    parts[component[i]].append(contours[i]);
+  }
+  vector<Nested<HalfedgeId>> result;
+  for(const auto& p : parts)
+    result.push_back(p.freeze());
+  return result;
+}
+
+Tuple<vector<Nested<CircleArc>>,vector<ShellComponent>> offset_shell_components(const Nested<const CircleArc> arcs, const real d, const int max_shells) {
+  Tuple<vector<Nested<CircleArc>>,vector<ShellComponent>> result;
+  auto& components = result.y;
+  const auto approx_bounds = approximate_bounding_box(arcs).thickened(max(d*max_shells,0));
+  const auto quant = make_arc_quantizer(approx_bounds);
+  const auto exact_d = quantize_offset(quant,d);
+  if(exact_d == 0 || max_shells == 0) {
+    result.x = offset_shells(arcs, d, max_shells);
+    if(!result.x.empty())
+      components.push_back(ShellComponent(-1, 0, result.x));
+    return result;
+  }
+  IntervalScope scope;
+  assert(exact_d < 0 || max_shells >= 0);
+  const int n_shells = max_shells >= 0 ? max_shells : INT_MAX;
+
+  VertexSet<PS> input_verts;
+  auto input_arcs = input_verts.quantize_circle_arcs(quant, arcs);
+  const auto input_g = new_<PlanarArcGraph<PS>>(input_verts, input_arcs);
+
+  // The first shell is computed on its own, so construction of its PlanarArcGraph can use all threads
+  vector<ShellSeed> seeds;
+  const auto first = offset_closed_exact_arcs(*input_g, extract_region(input_g->topology, faces_greater_than(*input_g, 0)), exact_d);
+  if(exact_d > 0) { // Growing regions can merge, so we never split
+    if(!first.y.empty())
+      seeds.push_back({first.x, first.y, -1, 0});
+  } else {
+    for(const auto& part : split_components(*first.x, first.y))
+      seeds.push_back({first.x, part, -1, 0});
+  }
+
+  // Each round offsets every pending region in parallel until it vanishes, runs out of shells, or splits into new
+  // regions for the next round.  Seeds of a round share graphs, so threads only access them by reference.
+  while(!seeds.empty()) {
+    const int base = int(components.size());
+    components.resize(base+seeds.size());
+    vector<vector<ShellSeed>> children(seeds.size());
+    OmpExceptions errors;
+    #pragma omp parallel if (seeds.size()>1)
+    {
+      IntervalScope scope;
+      #pragma omp for schedule(dynamic,1)
+      for(int k=0;k<int(seeds.size());k++) errors.capture([&]{
+        const auto& seed = seeds[k];
+        auto& component = components[base+k];
+        component.x = seed.parent;
+        component.y = seed.first;
+        component.z.push_back(seed.g->unquantize_circle_arcs(quant, seed.contours));
+        const PlanarArcGraph<PS>* g = &*seed.g;
+        Ptr<const PlanarArcGraph<PS>> owned_g; // Keeps g alive once we've moved past the seed's graph
+        Nested<HalfedgeId> contours = seed.contours;
+        for(int i = seed.first+1; i < n_shells; ++i) {
+          const auto shell = offset_closed_exact_arcs(*g, contours, exact_d);
+          owned_g = shell.x;
+          g = &*owned_g;
+          if(shell.y.empty())
+            break;
+          if(exact_d < 0) {
+            const auto parts = split_components(*g, shell.y);
+            if(parts.size() > 1) {
+              for(const auto& part : parts)
+                children[k].push_back({shell.x, part, base+k, i});
+              break;
+            }
+          }
+          contours = shell.y;
+          component.z.push_back(g->unquantize_circle_arcs(quant, contours));
+        }
+      });
+    }
+    errors.rethrow();
+    vector<ShellSeed> next;
+    for(const auto& c : children)
+      next.insert(next.end(), c.begin(), c.end());
+    seeds.swap(next);
+  }
+
+  // Collect the shells of all components at each offset
+  vector<Nested<CircleArc,false>> flat;
+  for(const auto& c : components) {
+    for(const int i : range(int(c.z.size()))) {
+      if(int(flat.size()) <= c.y+i)
+        flat.resize(c.y+i+1);
+      flat[c.y+i].extend(c.z[i]);
+    }
+  }
+  for(const auto& f : flat)
+    result.x.push_back(f.freeze());
+  return result;
+}
+
 Nested<CircleArc> offset_arcs(const Nested<const CircleArc> arcs, const real d) {
   auto bounds = approximate_bounding_box(arcs);
   if(bounds.empty()) bounds = Box<Vec2>::unit_box(); // We generate a non-degenerate box in case input was empty
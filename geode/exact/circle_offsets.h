@@ -1,5 +1,6 @@
 #pragma once
 #include <geode/exact/circle_csg.h>
+#include <geode/structure/Tuple.h>
 namespace geode {
 
 // offset_arcs performs a csg_union on arcs then grows or shrinks (based on sign of d) interior by d
@@ -8,7 +9,8 @@ namespace geode {
 // that should have resulted in a single arc. The exponential increase in number of arcs quickly cripples performance.
 // * Calling offset_arcs on the original input with different offsets is one workaround
 // * offset_shells preserves a higher precision representation that should avoid this issue
-// * If user has a way to simplify arc contours (not currently available in geode) between iterations this would avoid the issue
+// * ArcCSG (see ArcCSG.h) keeps shapes in exact form between operations, avoiding the round trip through CircleArcs
+// * Simplifying arc contours between iterations with simplify_closed_arcs (see geometry/simplify_arcs.h) keeps complexity bounded
 Nested<CircleArc> offset_arcs(const Nested<const CircleArc> arcs, const real d);
 
 // Generate closed contours around area covered by a disk of radius d moving along open arcs
@@ -19,4 +21,13 @@ Nested<CircleArc> offset_open_arcs(const Nested<const CircleArc> arcs, const rea
 // If max_shells == -1 and d is zero or positive this will grind until it runs out of memory or otherwise do something horrible
 vector<Nested<CircleArc>> offset_shells(const Nested<const CircleArc> arcs, const real d, const int max_shells = -1);
 
+// The shells of one connected region found by offset_shell_components: (parent, first, shells)
+// parent is the component whose last shell split into this one (or -1), and shells[i] is part of flat shell first+i
+typedef Tuple<int,int,vector<Nested<CircleArc>>> ShellComponent;
+
+// As offset_shells, but each time the shells split into disjoint regions, the regions are offset independently in parallel
+// Returns the flat list of shells as offset_shells would (up to contour order) along with the shells of each region
+// Regions only split for inward offsets, so for d >= 0 this is a single component equivalent to offset_shells
+Tuple<vector<Nested<CircleArc>>,vector<ShellComponent>> offset_shell_components(const Nested<const CircleArc> arcs, const real d, const int max_shells = -1);
+
 } // namespace geode
@@ -2,6 +2,7 @@
 #include <geode/exact/Interval.h>
 #include <geode/exact/scope.h>
 #include <geode/exact/Expansion.h>
+#include <geode/python/wrap.h>
 #include <geode/vector/magnitude.h>
 #include <geode/vector/normalize.h>
 namespace geode {
@@ -2571,3 +2572,9 @@ bool triangle_triangle_intersection(const Vector<double,3>& a0, const Vector<dou
 }
 
 }
+using namespace geode;
+
+void wrap_collision() {
+  GEODE_FUNCTION(edge_edge_collision_parity)
+  GEODE_FUNCTION(point_triangle_collision_parity)
+}
@@ -14,10 +14,14 @@
 #include <geode/utility/curry.h>
 #include <geode/utility/interrupts.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/openmp.h>
+#include <algorithm>
+#include <vector>
 namespace geode {
 
 using Log::cout;
 using std::endl;
+using std::vector;
 typedef Vector<real,2> TV;
 typedef Vector<Quantized,2> EV;
 using exact::Perturbed2;
@@ -770,8 +774,8 @@ static void spatial_sort(RawArray<Perturbed2> X, const int leaf_size, Random& ra
 }
 
 // Prepare a list of points for Delaunay triangulation: randomly assign into logarithmic bins, sort within bins, and add sentinels.
-// For details, see Amenta et al., Incremental Constructions con BRIO.
-static Array<Perturbed2> partially_sorted_shuffle(RawArray<const EV> Xin) {
+// For details, see Amenta et al., Incremental Constructions con BRIO.  The sentinels are given seeds starting at sentinel.
+static Array<Perturbed2> partially_sorted_shuffle(RawArray<const Perturbed2> Xin, const int sentinel) {
   const int n = Xin.size();
   Array<Perturbed2> X(n+3,uninit);
 
@@ -783,7 +787,7 @@ static Array<Perturbed2> partially_sorted_shuffle(RawArray<const EV> Xin) {
     int j = (int)random_permute(n,key,i);
     const int bin = min(integer_log(j+1),bins-1);
     j = (1<<bin)-1+bin_counts[bin]++;
-    X[j] = Perturbed2(i,Xin[i]);
+    X[j] = Xin[i];
   }
 
   // Spatially sort each bin down to clusters of size 64.
@@ -796,37 +800,248 @@ static Array<Perturbed2> partially_sorted_shuffle(RawArray<const EV> Xin) {
   }
 
   // Add 3 sentinel points at infinity
-  X[n+0] = Perturbed2(n+0,EV(-bound,-bound));
-  X[n+1] = Perturbed2(n+1,EV( bound, 0)    );
-  X[n+2] = Perturbed2(n+2,EV(-bound, bound));
+  X[n+0] = Perturbed2(sentinel+0,EV(-bound,-bound));
+  X[n+1] = Perturbed2(sentinel+1,EV( bound, 0)    );
+  X[n+2] = Perturbed2(sentinel+2,EV(-bound, bound));
 
   return X;
 }
 
+static Array<Perturbed2> partially_sorted_shuffle(RawArray<const EV> Xin) {
+  const int n = Xin.size();
+  Array<Perturbed2> X(n,uninit);
+  for (const int i : range(n))
+    X[i] = Perturbed2(i,Xin[i]);
+  return partially_sorted_shuffle(X,n);
+}
+
+// In parallel mode, we split the points into vertical strips of equal size, triangulate each strip independently,
+// and merge adjacent strips pairwise up a binary tree using the divide and conquer merge of
+//
+//   Leonidas Guibas and Jorge Stolfi, "Primitives for the manipulation of general subdivisions and the computation of Voronoi diagrams".
+//
+// Strips are separated using the same exact, perturbed axis comparisons as spatial_sort, so every merge is between
+// two point sets separated by a (perturbed) vertical line, and all merge decisions are exact predicates on the same
+// perturbed points as the serial algorithm.  Since the Delaunay triangulation of perturbed points is unique, the result
+// has the same triangles as the serial algorithm, even for degenerate input.
+//
+// Each merge runs on the disjoint union of the two meshes, which the seam walk treats as read only: deleted edges are
+// recorded in a hash table and skipped when rotating around a vertex.  Seam edges never appear in these rotations,
+// but they are always below the current base edge, where the circle tests fail anyway.  Once the upper tangent is
+// reached, every triangle touching a deleted edge is erased and the seam triangles are added.
+GEODE_NEVER_INLINE static void merge_delaunay(MutableTriangleTopology& mesh, RawField<const Perturbed2,VertexId> X,
+                                              VertexId l, VertexId r) {
+  IntervalScope scope;
+  const auto oriented = [&](const VertexId a, const VertexId b, const VertexId c) {
+    return triangle_oriented(X[a],X[b],X[c]);
+  };
+  const auto inside = [&](const VertexId a, const VertexId b, const VertexId c, const VertexId d) {
+    return incircle(X[a],X[b],X[c],X[d]);
+  };
+
+  // Walk down both hulls from the closest pair of extreme points to find the lower tangent.
+  // Boundary halfedges run clockwise, so halfedge(v) points to the next hull vertex clockwise.
+  for (;;) {
+    const auto ln = mesh.dst(mesh.halfedge(l)),
+               rn = mesh.src(mesh.prev(mesh.halfedge(r)));
+    if (!oriented(l,r,ln))
+      l = ln;
+    else if (!oriented(l,r,rn))
+      r = rn;
+    else
+      break;
+  }
+
+  // Rotate to the next undeleted edge counterclockwise or clockwise.  Edges below the base are never deleted,
+  // so these always terminate.
+  Hashtable<Vector<VertexId,2>> deleted;
+  Array<HalfedgeId> deleted_list;
+  const auto alive = [&](const HalfedgeId e) { return !deleted.contains(mesh.vertices(e).sorted()); };
+  const auto ccw = [&](HalfedgeId e) { do e = mesh.left(e);  while (!alive(e)); return e; };
+  const auto cw  = [&](HalfedgeId e) { do e = mesh.right(e); while (!alive(e)); return e; };
+  const auto kill = [&](const HalfedgeId e) {
+    deleted.set(mesh.vertices(e).sorted());
+    deleted_list.append(e);
+  };
+
+  // Zip the seam from bottom to top.  The left candidate is the first edge counterclockwise from the base
+  // around l, and the right candidate is the first edge clockwise from the base around r.  Seam edges at l
+  // come counterclockwise after lstop, the edge to the previous l, and the first goes to lfirst.  Similarly for r.
+  Array<Vector<int,3>> seam;
+  auto el = mesh.left(mesh.halfedge(l)),
+       er = mesh.halfedge(r),
+       lstop = mesh.halfedge(l),
+       rstop = mesh.left(mesh.halfedge(r));
+  auto lfirst = r,
+       rfirst = l;
+  for (;;) {
+    // Delete left candidates whose circle with the base contains the next neighbor of l
+    auto lc = mesh.dst(el);
+    if (oriented(l,r,lc))
+      for (;;) {
+        const auto next = el!=lstop ? ccw(el) : HalfedgeId();
+        const auto x = next.valid() ? mesh.dst(next) : lfirst;
+        if (x==r || !inside(l,r,lc,x))
+          break;
+        GEODE_ASSERT(next.valid());
+        kill(el);
+        el = next;
+        lc = x;
+      }
+    // Same for the right
+    auto rc = mesh.dst(er);
+    if (oriented(l,r,rc))
+      for (;;) {
+        const auto next = er!=rstop ? cw(er) : HalfedgeId();
+        const auto y = next.valid() ? mesh.dst(next) : rfirst;
+        if (y==l || !inside(l,r,rc,y))
+          break;
+        GEODE_ASSERT(next.valid());
+        kill(er);
+        er = next;
+        rc = y;
+      }
+
+    // Stop at the upper tangent, otherwise add the triangle with the empty circumcircle and advance the base
+    const bool lvalid = oriented(l,r,lc),
+               rvalid = oriented(l,r,rc);
+    if (!lvalid && !rvalid)
+      break;
+    if (!lvalid || (rvalid && inside(l,r,lc,rc))) {
+      seam.append(vec(l.id,r.id,rc.id));
+      rstop = mesh.reverse(er);
+      er = cw(rstop);
+      rfirst = l;
+      r = rc;
+    } else {
+      seam.append(vec(l.id,r.id,lc.id));
+      lstop = mesh.reverse(el);
+      el = ccw(lstop);
+      lfirst = r;
+      l = lc;
+    }
+  }
+
+  // Replace the triangles touching deleted edges with the seam
+  Hashtable<FaceId> dead;
+  Array<FaceId> erase;
+  for (const auto e : deleted_list)
+    for (const auto f : vec(mesh.face(e),mesh.face(mesh.reverse(e))))
+      if (f.valid() && dead.set(f))
+        erase.append(f);
+  for (const auto f : erase)
+    mesh.erase(f);
+  mesh.add_faces(seam);
+}
+
+GEODE_NEVER_INLINE static Ref<MutableTriangleTopology> parallel_exact_delaunay(RawArray<const EV> Xin, const int strips,
+                                                                                const bool validate) {
+  const int n = Xin.size();
+  GEODE_ASSERT(strips>=2 && !(strips&(strips-1)));
+  Array<Perturbed2> X(n,uninit);
+  #pragma omp parallel for
+  for (int i=0;i<n;i++)
+    X[i] = Perturbed2(i,Xin[i]);
+
+  // Split into strips by recursive exact median partitioning along x
+  const auto less = [](const Perturbed2& a, const Perturbed2& b) { return axis_less<0>(a,b); };
+  Array<int> bounds(strips+1,uninit);
+  for (const int s : range(strips+1))
+    bounds[s] = int(int64_t(n)*s/strips);
+  for (int size=strips;size>1;size/=2) {
+    #pragma omp parallel for
+    for (int s=0;s<strips;s+=size)
+      std::nth_element(X.data()+bounds[s],X.data()+bounds[s+size/2],X.data()+bounds[s+size],less);
+  }
+  Array<int> position(n,uninit);
+  #pragma omp parallel for
+  for (int i=0;i<n;i++)
+    position[X[i].seed()] = i;
+
+  // Triangulate each strip in its own vertex numbering, which is order within the strip
+  vector<Ptr<MutableTriangleTopology>> meshes(strips);
+  Array<int> leftmost(strips,uninit), rightmost(strips,uninit);
+  OmpExceptions errors;
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int s=0;s<strips;s++) errors.capture([&]{
+    const int lo = bounds[s];
+    const auto Xs = X.slice(lo,bounds[s+1]);
+    Field<const Perturbed2,VertexId> Xp(partially_sorted_shuffle(Xs,n));
+    const auto mesh = deterministic_exact_delaunay(Xp,false);
+    mesh->permute_vertices(amap([&](const Perturbed2& x) { return position[x.seed()]-lo; },
+                                Xp.flat.slice(0,Xs.size())).copy());
+    int left = 0, right = 0;
+    for (const int i : range(1,Xs.size())) {
+      if (less(Xs[i],Xs[left])) left = i;
+      if (less(Xs[right],Xs[i])) right = i;
+    }
+    leftmost[s] = left;
+    rightmost[s] = right;
+    meshes[s] = mesh;
+  });
+  errors.rethrow();
+
+  // Merge neighboring strips up a binary tree.  The merges at each level are independent.
+  for (int size=1;size<strips;size*=2) {
+    #pragma omp parallel for schedule(dynamic,1)
+    for (int s=0;s<strips;s+=2*size) errors.capture([&]{
+      const int lo = bounds[s], mid = bounds[s+size];
+      auto& mesh = *meshes[s];
+      mesh.add(*meshes[s+size]);
+      meshes[s+size].clear();
+      merge_delaunay(mesh,RawField<const Perturbed2,VertexId>(X.slice(lo,bounds[s+2*size])),
+                     VertexId(bounds[s+size-1]-lo+rightmost[s+size-1]),VertexId(mid-lo+leftmost[s+size]));
+    });
+    errors.rethrow();
+  }
+
+  // Compact and undo the vertex permutation
+  const auto mesh = ref(*meshes[0]);
+  mesh->collect_garbage();
+  mesh->permute_vertices(X.project<int,&Perturbed2::seed_>().copy());
+  if (validate) {
+    IntervalScope scope;
+    assert_delaunay("parallel delaunay validate: ",mesh,RawField<const EV,VertexId>(Xin));
+  }
+  return mesh;
+}
+
 Ref<TriangleTopology> exact_delaunay_points(RawArray<const EV> X, RawArray<const Vector<int,2>> edges,
-                                            const bool validate) {
+                                            const bool validate, const bool parallel) {
   const int n = X.size();
   GEODE_ASSERT(n>=3);
 
-  // Quantize all input points, reorder, and add sentinels
-  Field<const Perturbed2,VertexId> Xp(partially_sorted_shuffle(X));
-
-  // Compute Delaunay triangulation
-  const auto mesh = deterministic_exact_delaunay(Xp,validate);
-
-  // Undo the vertex permutation
-  mesh->permute_vertices(Xp.flat.slice(0,n).project<int,&Perturbed2::seed_>().copy());
+  // In parallel mode, use two strips per thread, but don't make strips tiny
+  const int min_strip = 32;
+  int strips = 1;
+  if (parallel)
+    while (strips<2*omp_get_max_threads() && n/(2*strips)>=min_strip)
+      strips *= 2;
+
+  Ptr<MutableTriangleTopology> mesh;
+  if (strips>1)
+    mesh = parallel_exact_delaunay(X,strips,validate);
+  else {
+    // Quantize all input points, reorder, and add sentinels
+    Field<const Perturbed2,VertexId> Xp(partially_sorted_shuffle(X));
+
+    // Compute Delaunay triangulation
+    mesh = deterministic_exact_delaunay(Xp,validate);
+
+    // Undo the vertex permutation
+    mesh->permute_vertices(Xp.flat.slice(0,n).project<int,&Perturbed2::seed_>().copy());
+  }
 
   // Insert constraint edges in random order
-  add_constraint_edges(mesh,RawField<const EV,VertexId>(X),edges,validate);
+  add_constraint_edges(*mesh,RawField<const EV,VertexId>(X),edges,validate);
 
   // All done!
-  return mesh;
+  return ref(*mesh);
 }
 
 Ref<TriangleTopology> delaunay_points(RawArray<const Vector<real,2>> X, RawArray<const Vector<int,2>> edges,
-                                      const bool validate) {
-  return exact_delaunay_points(amap(quantizer(bounding_box(X)),X).copy(),edges,validate);
+                                      const bool validate, const bool parallel) {
+  return exact_delaunay_points(amap(quantizer(bounding_box(X)),X).copy(),edges,validate,parallel);
 }
 
 // Greedily compute a set of nonintersecting edges in a point cloud for testing purposes
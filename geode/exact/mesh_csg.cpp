@@ -9,7 +9,9 @@
 #include <geode/exact/scope.h>
 #include <geode/exact/simple_triangulate.h>
 #include <geode/array/amap.h>
+#include <geode/array/arange.h>
 #include <geode/array/ConstantMap.h>
+#include <geode/array/IndirectArray.h>
 #include <geode/array/RawField.h>
 #include <geode/array/reversed.h>
 #include <geode/array/sort.h>
@@ -18,14 +20,18 @@
 #include <geode/math/mean.h>
 #include <geode/math/optimal_sort.h>
 #include <geode/mesh/TriangleSoup.h>
+#include <geode/python/Class.h>
 #include <geode/python/function.h>
 #include <geode/python/wrap.h>
 #include <geode/random/permute.h>
 #include <geode/random/Random.h>
 #include <geode/structure/Hashtable.h>
 #include <geode/structure/UnionFind.h>
+#include <geode/utility/function.h>
+#include <geode/utility/openmp.h>
 #include <geode/utility/Unique.h>
 #include <geode/vector/Matrix.h>
+#include <vector>
 namespace geode {
 
 // Algorithm explanation:
@@ -60,8 +66,9 @@ static const uint128_t key = uint128_t(9975794406056834021u)+(uint128_t(92051915
 // Some variables in the code can refer to either original vertices (possibly loop vertices),
 // edge-face intersection vertices, or face-face-face intersection vertices.  For this purpose,
 // we concatenate the ranges for the three types of vertices in order.  The same numbering is
-// used for vertices in the split output mesh before pruning.
-#define Xi(i) P(i,X[i])
+// used for vertices in the split output mesh before pruning.  Original vertex i is perturbed
+// with seed seeds[i], which is i except when splitting part of a larger mesh (see MeshCSGSession).
+#define Xi(i) P(seeds[i],X[i])
 #define Xi2(i) (i < X.size() ? IV(X[i]) \
                              : ef_vertices.flat[i-X.size()].p())
 #define Xi3(i) (  i < X.size()                    ? IV(X[i]) \
@@ -178,6 +185,7 @@ namespace {
 struct State {
   // Vertices of all three types
   const RawArray<const EV> X;
+  const RawArray<const int> seeds; // Perturbation seeds for X
   const Nested<const EdgeFaceVertex> ef_vertices;
   Array<FaceFaceFaceVertex>& fff_vertices;
   Hashtable<Vector<int,3>,int>& faces_to_fff; // Sorted faces to corresponding fff vertex
@@ -189,10 +197,11 @@ struct State {
   // depth weights for faces
   const RawArray<const int> depth_weight;
 
-  State(RawArray<const EV> X, Nested<const EdgeFaceVertex> ef_vertices,
+  State(RawArray<const EV> X, RawArray<const int> seeds, Nested<const EdgeFaceVertex> ef_vertices,
         Array<FaceFaceFaceVertex>& fff_vertices, Hashtable<Vector<int,3>,int>& faces_to_fff,
         RawArray<const Vector<int,3>> faces, RawArray<const Vector<int,2>> edges, RawArray<const int> depth_weight)
     : X(X)
+    , seeds(seeds)
     , ef_vertices(ef_vertices)
     , fff_vertices(fff_vertices)
     , faces_to_fff(faces_to_fff)
@@ -284,7 +293,7 @@ struct Policy : public State, public Noncopyable {
         Xi(faces[face].z))
     , face_edges(face_edges)
     , normal(cross(iv(f.y)-iv(f.x),iv(f.z)-iv(f.x))) {
-    assert(edges[face_edges.z].contains_all(vec(f.x.seed(),f.y.seed())));
+    assert(edges[face_edges.z].contains_all(faces[face].xy()));
   }
 
   Line reverse_line(const Line L) const {
@@ -407,7 +416,7 @@ struct Policy : public State, public Noncopyable {
     // This routine is a huge case analysis on the different kinds of vertex patterns.
     // The types are V (input), B (boundary edge-face), EF (interior edge-face), and FFF (face-face-face).
     static const int V = 0, B = 1, EF = 2, FFF = 3;
-    const auto fv = vec(f.x.seed(),f.y.seed(),f.z.seed());
+    const auto fv = faces[face];
 
     // Classify vertices
     const int n = X.size(),
@@ -728,7 +737,7 @@ template<int up> struct PolicyUp : public Policy {
 
 // Find all intersection vertices and edges
 static Tuple<Nested<const EdgeFaceVertex>,Array<const FaceFaceEdge>>
-intersection_simplices(const SimplexTree<EV,2>& face_tree) {
+intersection_simplices(const SimplexTree<EV,2>& face_tree, RawArray<const int> seeds) {
   const auto X = face_tree.X;
   const TriangleSoup& faces = face_tree.mesh;
   const SegmentSoup& edges = faces.segment_soup();
@@ -746,10 +755,11 @@ intersection_simplices(const SimplexTree<EV,2>& face_tree) {
     // Or perhaps I misunderstand something about lifetime of temporaries in this context?
     // Adding a seperate reference is a clean enough workaround
     const auto helper_edge_tree = new_<SimplexTree<EV, 1>>(edges, X, 1);
-    struct {
+    struct Helper {
       const Ref<const SimplexTree<EV,1>> edge_tree;
       const SimplexTree<EV,2>& face_tree;
       const RawArray<const EV> X;
+      const RawArray<const int> seeds;
       Array<EdgeFaceVertex> ef_vertices;
 
       bool cull(const int ne, const int nf) const { return false; }
@@ -768,47 +778,59 @@ intersection_simplices(const SimplexTree<EV,2>& face_tree) {
           }
         }
       }
-    } helper({helper_edge_tree,face_tree,X});
-    double_traverse(*helper.edge_tree,face_tree,helper);
+    };
+    // Traverse in parallel.  The helpers come back in serial traversal order, so ef vertex numbering is deterministic.
+    const auto helpers = parallel_double_traverse<IntervalScope>(*helper_edge_tree,face_tree,[&]() {
+      return Helper({helper_edge_tree,face_tree,X,seeds}); });
 
     // Bucket edge face vertices by edge
     Array<int> counts(edges.elements.size());
-    for (const auto& ef : helper.ef_vertices)
-      counts[ef.edge]++;
+    for (const auto& helper : helpers)
+      for (const auto& ef : helper.ef_vertices)
+        counts[ef.edge]++;
     ef_vertices = Nested<EdgeFaceVertex>(counts,uninit);
-    for (const auto& ef : helper.ef_vertices)
-      ef_vertices(ef.edge,--counts[ef.edge]) = ef;
+    for (const auto& helper : helpers)
+      for (const auto& ef : helper.ef_vertices)
+        ef_vertices(ef.edge,--counts[ef.edge]) = ef;
   }
 
-  // Sort ef_vertices along each edge
-  for (const int e : range(edges.elements.size())) {
-    const auto e0 = Xi(edges.elements[e].x),
-               e1 = Xi(edges.elements[e].y);
-    struct {
-      RawArray<const Vector<int,3>> faces;
-      RawArray<const EV> X;
-      const P e0, e1;
-      const IV de;
-
-      bool operator()(const EdgeFaceVertex& i0, const EdgeFaceVertex& i1) const {
-        if (i0.face == i1.face)
-          return false;
-        const auto &f0 = faces[i0.face],
-                   &f1 = faces[i1.face];
-        return FILTER(dot(de,i1.p()-i0.p()),
-                      helper(i0.face,f0,i1.face,f1));
-      }
+  // Sort ef_vertices along each edge.  Edges are independent, so this is done in parallel.
+  OmpExceptions errors;
+  #pragma omp parallel
+  {
+    IntervalScope scope;
+    #pragma omp for schedule(dynamic,64)
+    for (int e=0;e<edges.elements.size();e++) errors.capture([&]() {
+      const auto e0 = Xi(edges.elements[e].x),
+                 e1 = Xi(edges.elements[e].y);
+      struct {
+        RawArray<const Vector<int,3>> faces;
+        RawArray<const EV> X;
+        RawArray<const int> seeds;
+        const P e0, e1;
+        const IV de;
+
+        bool operator()(const EdgeFaceVertex& i0, const EdgeFaceVertex& i1) const {
+          if (i0.face == i1.face)
+            return false;
+          const auto &f0 = faces[i0.face],
+                     &f1 = faces[i1.face];
+          return FILTER(dot(de,i1.p()-i0.p()),
+                        helper(i0.face,f0,i1.face,f1));
+        }
 
-      bool helper(const int i0, const Vector<int,3> f0,
-                  const int i1, const Vector<int,3> f1) const {
-        if (f0.sorted() == f1.sorted())
-          throw ValueError(format("mesh_csg: Duplicate faces found: face %d (%d,%d,%d) = %d (%d,%d,%d)",
-                                  i0,f0.x,f0.y,f0.z,i1,f1.x,f1.y,f1.z));
-        return segment_triangle_intersections_ordered(e0,e1,FX(f0),FX(f1));
-      }
-    } less({faces.elements,X,e0,e1,iv(e1)-iv(e0)});
-    sort(ef_vertices[e],less);
+        bool helper(const int i0, const Vector<int,3> f0,
+                    const int i1, const Vector<int,3> f1) const {
+          if (f0.sorted() == f1.sorted())
+            throw ValueError(format("mesh_csg: Duplicate faces found: face %d (%d,%d,%d) = %d (%d,%d,%d)",
+                                    i0,f0.x,f0.y,f0.z,i1,f1.x,f1.y,f1.z));
+          return segment_triangle_intersections_ordered(e0,e1,FX(f0),FX(f1));
+        }
+      } less({faces.elements,X,seeds,e0,e1,iv(e1)-iv(e0)});
+      sort(ef_vertices[e],less);
+    });
   }
+  errors.rethrow();
 
   // Map from original vertices to faces
   const auto incident_faces = faces.incident_elements();
@@ -900,6 +922,8 @@ struct DepthUnionFind {
     int d; // depth(parent)-depth(self)
   };
   Array<Info> info;
+  bool lenient = false; // If true, record inconsistent merges in consistent rather than throwing
+  bool consistent = true;
 
   int append() {
     return info.append(Info({-1,0}));
@@ -945,9 +969,12 @@ struct DepthUnionFind {
   void merge(const int i, const int j, const int dij) {
     auto ri = find(i),
          rj = find(j);
-    if (ri.p == rj.p)
-      GEODE_ASSERT(ri.d-rj.d==dij,"Inconsistent depth calculation, input meshes are not topologically closed");
-    else {
+    if (ri.p == rj.p) {
+      if (ri.d-rj.d != dij) {
+        GEODE_ASSERT(lenient,"Inconsistent depth calculation, input meshes are not topologically closed");
+        consistent = false;
+      }
+    } else {
       if (info[ri.p].p <= info[rj.p].p) { // Make ri the root
         if (info[ri.p].p == info[rj.p].p)
           info[ri.p].p--;
@@ -957,15 +984,50 @@ struct DepthUnionFind {
     }
   }
 };
+
+// Union-find operations recorded while retriangulating one face, so that faces can be processed in parallel
+// and their operations replayed in face order.  Nodes below fixed (original and ff edges) are shared by all
+// faces; nodes from fixed on are the cut faces of this face, which receive global indices during replay.
+struct DepthMerges {
+  int fixed, faces;
+  Array<Vector<int,3>> merges; // i,j,dij
+
+  int extend(const int n) {
+    const int base = fixed+faces;
+    faces += n;
+    return base;
+  }
+
+  void merge(const int i, const int j, const int dij) {
+    merges.append(vec(i,j,dij));
+  }
+
+  void replay(DepthUnionFind& union_find) const {
+    const int shift = union_find.extend(faces)-fixed;
+    for (const auto& m : merges)
+      union_find.merge(m.x<fixed ? m.x : m.x+shift,
+                       m.y<fixed ? m.y : m.y+shift,m.z);
+  }
+};
+
+// The retriangulation of a single face.  Face-face-face vertices are numbered locally (in order of creation)
+// until all faces are merged.
+struct CutFace {
+  bool cut;
+  Array<Vector<int,3>> faces;
+  Array<FaceFaceFaceVertex> fff_vertices;
+  DepthMerges merges;
+};
 }
 
 template<int up> static void
-retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, Array<int> &original_face_index, DepthUnionFind* const union_find,
+retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, DepthMerges* const union_find,
                    const int face, Vector<int,3> e, RawArray<int> interior,
                    RawArray<const FaceFaceEdge> ff_edges, RawArray<const int> ffs) {
   // Sort vertices in upwards order, keeping track of permutation parity.
   const auto save_e = e;
   const auto X = S.X;
+  const auto seeds = S.seeds;
   auto v = S.faces[face];
   bool flip = false;
   #define C(i,j) \
@@ -1059,7 +1121,6 @@ retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, Array<int> &origin
   // Copy mesh into cut_faces
   for (const auto f : mesh->faces()) {
     const auto v = mesh->vertices(f);
-    original_face_index.append(face);
     cut_faces.append(vec(vertices[v.x],
                          vertices[v.y],
                          vertices[v.z]));
@@ -1114,12 +1175,71 @@ struct OrientedWithX { template<class TV> static inline PredicateType<2,TV> eval
 }};
 static inline bool oriented_with_x(const P p0, const P p1, const P p2) {
   return perturbed_predicate<OrientedWithX>(p0,p1,p2);
-}}
+}
 
-// Retriangulate each face w.r.t. the other faces which cut it
+// A ray from q = v0+e1*(v1-v0)+e2*(v2-v0)+e3*normal to infinity along the positive x axis,
+// where 1 >> e1 >> e2 >> e3 are infinitesimals.  See retriangulate_soup for details.
+struct XRay {
+  const P v0,v1,v2;
+  const bool orient_v012; // orient_with_x(v0,v1,v2)
+
+  XRay(const P v0, const P v1, const P v2)
+    : v0(v0), v1(v1), v2(v2)
+    , orient_v012(oriented_with_x(v0,v1,v2)) {}
+
+  bool cull(const Box<EV>& box) const {
+    return                        box.max.x<v0.value().x
+           || v0.value().y<box.min.y || box.max.y<v0.value().y
+           || v0.value().z<box.min.z || box.max.z<v0.value().z;
+  }
+
+  // Returns 1 if triangle f crosses the ray in the positive x direction, -1 if negative, 0 if they miss.
+  // The entries of f must be the seeds of p0,p1,p2.
+  int crossing(const Vector<int,3> f, const P p0, const P p1, const P p2) const {
+    const bool with_x = oriented_with_x(p0,p1,p2);
+    if (!f.contains(v0.seed())) {
+      // Triangle doesn't touch v0, so computation is infinitesimal free
+      if (   with_x != tetrahedron_oriented(p0,p1,p2,v0)
+          && with_x == oriented_with_x(v0,p0,p1)
+          && with_x == oriented_with_x(v0,p1,p2)
+          && with_x == oriented_with_x(v0,p2,p0))
+        goto hit;
+    } else if (!f.contains(v1.seed())) {
+      // Triangle shares v0 but not v1.  It suffices to consider q = v0+e1*(v1-v0).  The
+      // computation is equivalent to firing a ray from v1 -> v1+inf*x against the partially
+      // infinite triangle p0+a(p1-p0)+b(p2-p0), {a,b}>=0, as can be seen by scaling around
+      // v0 by 1/e1.  This is the same as the no v0 case above except that we do not check
+      // against the edge p12, which is now infinitely far away.
+      if (   with_x != tetrahedron_oriented(p0,p1,p2,v1)
+          && (f.z==v0.seed() || with_x==oriented_with_x(v1,p0,p1))
+          && (f.x==v0.seed() || with_x==oriented_with_x(v1,p1,p2))
+          && (f.y==v0.seed() || with_x==oriented_with_x(v1,p2,p0)))
+        goto hit;
+    } else if (!f.contains(v2.seed())) {
+      // Triangle shares v0,v1 but not v2.  We must consider the full q = v0+e1*(v1-v0)+e2*(v2-v0).
+      // Shift v0 to 0, so that q = e1*v1+e2*v2.
+      if (   with_x == (orient_v012 ^ flipped_in(vec(v0.seed(),v1.seed()),f))
+          && with_x != tetrahedron_oriented(p0,p1,p2,v2))
+        goto hit;
+    } else {
+      // If f contains v0,v1,v2, we're the start triangle, and we hit iff we're oriented against x.
+      if (!with_x)
+        goto hit;
+    }
+    return 0;
+    hit:
+    return with_x ? 1 : -1;
+  }
+};
+}
+
+// Retriangulate each face w.r.t. the other faces which cut it.  If outside is given, it is added to the
+// depth of each ray, accounting for faces which are not part of face_tree.
 static Tuple<Array<const FaceFaceFaceVertex>,Array<Vector<int,3>>,Array<int>>
-retriangulate_soup(const SimplexTree<EV,2>& face_tree, Array<const int> depth_weight, DepthUnionFind* const union_find,
-                   Nested<const EdgeFaceVertex> ef_vertices, RawArray<const FaceFaceEdge> ff_edges) {
+retriangulate_soup(const SimplexTree<EV,2>& face_tree, RawArray<const int> seeds, Array<const int> depth_weight,
+                   DepthUnionFind* const union_find,
+                   Nested<const EdgeFaceVertex> ef_vertices, RawArray<const FaceFaceEdge> ff_edges,
+                   const function<int(const XRay&)>& outside) {
   GEODE_ASSERT(face_tree.leaf_size==1);
   const auto X = face_tree.X;
   const TriangleSoup& faces = face_tree.mesh;
@@ -1172,40 +1292,85 @@ retriangulate_soup(const SimplexTree<EV,2>& face_tree, Array<const int> depth_we
     union_find->extend(edges.elements.size()+ff_edges.size());
   }
 
-  // Retriangulate each face
+  // Retriangulate each cut face independently and in parallel.  Union-find operations are recorded rather
+  // than applied, since their effect depends on order.
+  std::vector<CutFace> cut(faces.elements.size());
+  OmpExceptions errors;
+  #pragma omp parallel
+  {
+    IntervalScope scope;
+    #pragma omp for schedule(dynamic)
+    for (int f=0;f<faces.elements.size();f++) errors.capture([&]() {
+      const auto v = faces.elements[f];
+
+      // Find the three edges bounding this face
+      const auto fe = face_edges[f]; // v01,v12,v20
+      const Vector<int,3> e(fe.y,fe.z,fe.x); // e[3-i-j] connects v[i] and v[j]
+
+      // If the face isn't cut, there's very little to do
+      auto& c = cut[f];
+      const auto interior = face_to_ef[f];
+      c.cut = interior.size() || ef_vertices.size(e.x)
+                              || ef_vertices.size(e.y)
+                              || ef_vertices.size(e.z);
+      if (!c.cut)
+        return;
+
+      // Face-face-face vertices are created locally, and deduplicated across faces during the merge below
+      Hashtable<Vector<int,3>,int> faces_to_fff;
+      State S(X,seeds,ef_vertices,c.fff_vertices,faces_to_fff,faces.elements,edges.elements,depth_weight);
+      c.merges.fixed = edges.elements.size()+ff_edges.size();
+      c.merges.faces = 0;
+      const auto merges = union_find ? &c.merges : 0;
+
+      // Let the longest axis be the upwards sweep axis.  This choice can be made using inexact arithmetic,
+      // since it does not affect correctness.
+      const int up = bounding_box(X[v.x],X[v.y],X[v.z]).sizes().dominant_axis();
+      const auto ffs = face_to_ff[f];
+      if (up==0)      retriangulate_face<0>(S,c.faces,merges,f,e,interior,ff_edges,ffs);
+      else if (up==1) retriangulate_face<1>(S,c.faces,merges,f,e,interior,ff_edges,ffs);
+      else            retriangulate_face<2>(S,c.faces,merges,f,e,interior,ff_edges,ffs);
+    });
+  }
+  errors.rethrow();
+
+  // Merge in face order, so that vertex numbering and depths are independent of the number of threads.
+  // Face-face-face vertices shared between faces are numbered in order of first appearance.
+  const int nn = X.size()+ef_vertices.flat.size();
   Array<FaceFaceFaceVertex> fff_vertices;
-  Hashtable<Vector<int,3>,int> faces_to_fff;
-  State S(X,ef_vertices,fff_vertices,faces_to_fff,faces.elements,edges.elements,depth_weight);
+  Hashtable<Vector<int,3>,int> faces_to_fff; // Sorted faces to corresponding fff vertex
+  Array<int> local_to_fff;
   for (const int f : range(faces.elements.size())) {
-    const auto v = faces.elements[f];
-
-    // Find the three edges bounding this face
-    const auto fe = face_edges[f]; // v01,v12,v20
-    Vector<int,3> e(fe.y,fe.z,fe.x); // e[3-i-j] connects v[i] and v[j]
-
-    // If the face isn't cut, there's very little to do
-    const auto interior = face_to_ef[f];
-    if (!interior.size() && !ef_vertices.size(e.x)
-                         && !ef_vertices.size(e.y)
-                         && !ef_vertices.size(e.z)) {
+    auto& c = cut[f];
+    if (!c.cut) {
+      const auto fe = face_edges[f];
       original_face_index.append(f);
-      cut_faces.append(v);
+      cut_faces.append(faces.elements[f]);
       if (union_find) {
         const int i = union_find->append();
-        union_find->merge(i,e.x,0);
-        union_find->merge(i,e.y,0);
-        union_find->merge(i,e.z,0);
+        union_find->merge(i,fe.y,0);
+        union_find->merge(i,fe.z,0);
+        union_find->merge(i,fe.x,0);
       }
       continue;
     }
-
-    // Let the longest axis be the upwards sweep axis.  This choice can be made using inexact arithmetic,
-    // since it does not affect correctness.
-    const int up = bounding_box(X[v.x],X[v.y],X[v.z]).sizes().dominant_axis();
-    const auto ffs = face_to_ff[f];
-    if (up==0)      retriangulate_face<0>(S,cut_faces,original_face_index,union_find,f,e,interior,ff_edges,ffs);
-    else if (up==1) retriangulate_face<1>(S,cut_faces,original_face_index,union_find,f,e,interior,ff_edges,ffs);
-    else            retriangulate_face<2>(S,cut_faces,original_face_index,union_find,f,e,interior,ff_edges,ffs);
+    local_to_fff.resize(c.fff_vertices.size(),uninit);
+    for (const int i : range(c.fff_vertices.size())) {
+      const int n = fff_vertices.size();
+      local_to_fff[i] = faces_to_fff.get_or_insert(c.fff_vertices[i].faces.sorted(),n);
+      if (local_to_fff[i] == n)
+        fff_vertices.append(c.fff_vertices[i]);
+    }
+    for (auto t : c.faces) {
+      for (int i=0;i<3;i++)
+        if (t[i] >= nn)
+          t[i] = nn+local_to_fff[t[i]-nn];
+      original_face_index.append(f);
+      cut_faces.append(t);
+    }
+    if (union_find)
+      c.merges.replay(*union_find);
+    c = CutFace();
   }
 
   // Add one union-find node at infinity, and fire rays until everything is connected to it
@@ -1232,73 +1397,28 @@ retriangulate_soup(const SimplexTree<EV,2>& face_tree, Array<const int> depth_we
       // specially.  By the choice of q, the depth that we compute will be accurate
       // immediately outside edge v01.  Note that it is *not* necessarily correct anywhere
       // else, since triangle v012 may be cut arbitrarily.
+      const XRay ray(Xi(v.x),Xi(v.y),Xi(v.z));
       struct Visitor {
         const SimplexTree<EV,2>& face_tree;
-        RawArray<const EV> X;
+        const RawArray<const EV> X;
+        const RawArray<const int> seeds;
         const RawArray<const int> depth_weight;
-        const P v0,v1,v2;
-        const bool orient_v012; // orient_with_x(v0,v1,v2)
+        const XRay& ray;
         int depth;
 
-        Visitor(const SimplexTree<EV,2>& face_tree, const int face, const Vector<int,3> v, const RawArray<const int> depth_weight)
-          : face_tree(face_tree)
-          , X(face_tree.X)
-          , depth_weight(depth_weight)
-          , v0(Xi(v.x))
-          , v1(Xi(v.y))
-          , v2(Xi(v.z))
-          , orient_v012(oriented_with_x(v0,v1,v2))
-          , depth(0) {}
-
         bool cull(const int n) const {
-          const auto box = face_tree.boxes[n];
-          return                        box.max.x<v0.value().x
-                 || v0.value().y<box.min.y || box.max.y<v0.value().y
-                 || v0.value().z<box.min.z || box.max.z<v0.value().z;
+          return ray.cull(face_tree.boxes[n]);
         }
 
         void leaf(const int n) {
           const int face_idx = face_tree.prims(n)[0];
           const auto f = face_tree.mesh->elements[face_idx];
-          const P p0 = Xi(f.x),
-                  p1 = Xi(f.y),
-                  p2 = Xi(f.z);
-          const bool with_x = oriented_with_x(p0,p1,p2);
-          if (!f.contains(v0.seed())) {
-            // Triangle doesn't touch v0, so computation is infinitesimal free
-            if (   with_x != tetrahedron_oriented(p0,p1,p2,v0)
-                && with_x == oriented_with_x(v0,p0,p1)
-                && with_x == oriented_with_x(v0,p1,p2)
-                && with_x == oriented_with_x(v0,p2,p0))
-              goto hit;
-          } else if (!f.contains(v1.seed())) {
-            // Triangle shares v0 but not v1.  It suffices to consider q = v0+e1*(v1-v0).  The
-            // computation is equivalent to firing a ray from v1 -> v1+inf*x against the partially
-            // infinite triangle p0+a(p1-p0)+b(p2-p0), {a,b}>=0, as can be seen by scaling around
-            // v0 by 1/e1.  This is the same as the no v0 case above except that we do not check
-            // against the edge p12, which is now infinitely far away.
-            if (   with_x != tetrahedron_oriented(p0,p1,p2,v1)
-                && (f.z==v0.seed() || with_x==oriented_with_x(v1,p0,p1))
-                && (f.x==v0.seed() || with_x==oriented_with_x(v1,p1,p2))
-                && (f.y==v0.seed() || with_x==oriented_with_x(v1,p2,p0)))
-              goto hit;
-          } else if (!f.contains(v2.seed())) {
-            // Triangle shares v0,v1 but not v2.  We must consider the full q = v0+e1*(v1-v0)+e2*(v2-v0).
-            // Shift v0 to 0, so that q = e1*v1+e2*v2.
-            if (   with_x == (orient_v012 ^ flipped_in(vec(v0.seed(),v1.seed()),f))
-                && with_x != tetrahedron_oriented(p0,p1,p2,v2))
-              goto hit;
-          } else {
-            // If f contains v0,v1,v2, we're the start triangle, and we hit iff we're oriented against x.
-            if (!with_x)
-              goto hit;
-          }
-          return;
-          hit:
-          depth += depth_weight[face_idx] * (with_x ? 1 : -1);
+          depth += depth_weight[face_idx]*ray.crossing(vec(seeds[f.x],seeds[f.y],seeds[f.z]),Xi(f.x),Xi(f.y),Xi(f.z));
         }
-      } visitor(face_tree,f,v,depth_weight);
+      } visitor({face_tree,X,seeds,depth_weight,ray,0});
       single_traverse(face_tree,visitor);
+      if (outside)
+        visitor.depth += outside(ray);
       union_find->merge(infinity,e.x,visitor.depth);
     }
   }
@@ -1381,7 +1501,8 @@ exact_split_soup(const TriangleSoup& faces, Array<const EV> X, Array<const int>
 
   // Find ef_vertices and ff_halfedges
   const auto face_tree = new_<SimplexTree<EV,2>>(faces,X,1);
-  const auto A = intersection_simplices(face_tree);
+  const auto seeds = arange(X.size()).copy();
+  const auto A = intersection_simplices(face_tree,seeds);
   const auto ef_vertices = A.x;
   const auto ff_edges = A.y;
 
@@ -1391,7 +1512,7 @@ exact_split_soup(const TriangleSoup& faces, Array<const EV> X, Array<const int>
     union_find.reset(new DepthUnionFind);
 
   // Retriangulate mesh and compute depths
-  const auto B = retriangulate_soup(face_tree,depth_weight,union_find.get(),ef_vertices,ff_edges);
+  const auto B = retriangulate_soup(face_tree,seeds,depth_weight,union_find.get(),ef_vertices,ff_edges,nullptr);
   const auto fff_vertices = B.x;
   const auto cut_faces = B.y;
   const auto original_face_index = B.z;
@@ -1440,6 +1561,414 @@ Tuple<Ref<const TriangleSoup>,Array<TV>> split_soup(const TriangleSoup& faces, A
   return split_soup(faces, X, depth_weight, depth);
 }
 
+GEODE_DEFINE_TYPE(MeshCSGSession)
+
+// Operand faces are weighted so that a single depth d encodes both the stock depth and the operand depth as
+// d = stock_depth + operand_weight*operand_depth.  Stock depths are tiny, since the stock is (nearly) intersection free.
+static const int operand_weight = 1<<16;
+
+MeshCSGSession::MeshCSGSession(const TriangleSoup& stock, Array<const TV> X, const Box<TV>& bounds)
+  : bounds(Box<TV>::combine(bounds,bounding_box(X)))
+  , quant(this->bounds)
+  , alive_faces(0)
+  , alive_vertices(0) {
+  // Resolve any self intersections in the stock once, up front
+  const auto S = exact_split_soup(stock,amap(quant,X).copy(),0);
+  this->X = S.y;
+  insert(S.x->elements);
+}
+
+MeshCSGSession::~MeshCSGSession() {}
+
+int MeshCSGSession::subtract(const TriangleSoup& tool, Array<const TV> X) {
+  return apply(tool,X,true);
+}
+
+int MeshCSGSession::add(const TriangleSoup& tool, Array<const TV> X) {
+  return apply(tool,X,false);
+}
+
+MeshCSGSession::Level MeshCSGSession::level(RawArray<const int> ids) const {
+  const auto mesh = new_<const TriangleSoup>(faces.subset(ids).copy());
+  return Level({new_<const SimplexTree<EV,2>>(*mesh,X,1),ids.copy()});
+}
+
+void MeshCSGSession::insert(RawArray<const Vector<int,3>> new_faces) {
+  if (!new_faces.size())
+    return;
+  const int start = faces.size();
+  faces.extend(new_faces);
+  alive.extend(constant_map(new_faces.size(),true));
+  alive_faces += new_faces.size();
+  uses.resize(X.size());
+  for (const auto& f : new_faces)
+    for (const int v : f)
+      alive_vertices += !uses[v]++;
+
+  // If most faces or vertices are dead, start over
+  if (2*alive_faces < faces.size() || 2*alive_vertices < X.size())
+    return compact();
+
+  // Otherwise, add a new level and merge levels of comparable size, so that there are O(log n) levels
+  Array<int> ids(new_faces.size(),uninit);
+  for (const int i : range(ids.size()))
+    ids[i] = start+i;
+  levels.push_back(level(ids));
+  while (levels.size()>1 && levels[levels.size()-2].faces.size() <= 2*levels.back().faces.size()) {
+    Array<int> ids;
+    for (const int i : range(2))
+      for (const int f : levels[levels.size()-1-i].faces)
+        if (alive[f])
+          ids.append(f);
+    levels.pop_back();
+    levels.pop_back();
+    if (ids.size())
+      levels.push_back(level(ids));
+  }
+}
+
+void MeshCSGSession::compact() {
+  // Renumber vertices and faces, dropping dead ones
+  Array<int> map(X.size()), face_map(faces.size());
+  map.fill(-1);
+  face_map.fill(-1);
+  Array<EV> new_X;
+  Array<Vector<int,3>> new_faces;
+  for (const int f : range(faces.size()))
+    if (alive[f]) {
+      auto v = faces[f];
+      for (int i=0;i<3;i++) {
+        if (map[v[i]] < 0)
+          map[v[i]] = new_X.append(X[v[i]]);
+        v[i] = map[v[i]];
+      }
+      face_map[f] = new_faces.append(v);
+    }
+  Array<Vector<int,2>> new_crossings;
+  for (const auto c : crossings)
+    if (alive[c.x] && alive[c.y])
+      new_crossings.append(vec(face_map[c.x],face_map[c.y]));
+  X = new_X;
+  uses.copy(constant_map(X.size(),0));
+  for (const auto& f : new_faces)
+    for (const int v : f)
+      uses[v]++;
+  alive_vertices = X.size();
+  faces = new_faces;
+  crossings = new_crossings;
+  alive.copy(constant_map(faces.size(),true));
+  alive_faces = faces.size();
+  levels.clear();
+  if (faces.size())
+    levels.push_back(level(arange(faces.size()).copy()));
+}
+
+bool MeshCSGSession::split(const TriangleSoup& tool, const SimplexTree<EV,2>& tool_tree, RawArray<const int> affected,
+                           const Hashtable<int>& affected_set, const bool subtract,
+                           Tuple<Array<Vector<int,3>>,Array<EV>>& result) const {
+  // Build a local soup of the affected faces followed by the operand, numbering the stock vertices they use
+  // contiguously so that the work is proportional to the affected region rather than the whole session.  Local
+  // vertices are perturbed with their session ids as seeds, so that symbolic perturbations agree with those seen
+  // by the rest of the stock.  Operand vertices get seeds past every session id.
+  const int n = X.size();
+  Hashtable<int,int> to_local;
+  Array<int> seeds;
+  Array<Vector<int,3>> local_faces(affected.size()+tool.elements.size(),uninit);
+  for (const int i : range(affected.size())) {
+    auto v = faces[affected[i]];
+    for (int j=0;j<3;j++) {
+      const int k = to_local.get_or_insert(v[j],seeds.size());
+      if (k == seeds.size())
+        seeds.append(v[j]);
+      v[j] = k;
+    }
+    local_faces[i] = v;
+  }
+  const int m = seeds.size();
+  for (const int i : range(tool.elements.size()))
+    local_faces[affected.size()+i] = tool.elements[i]+m;
+  Array<EV> local_X(m+tool_tree.X.size(),uninit);
+  for (const int i : range(m))
+    local_X[i] = X[seeds[i]];
+  local_X.slice(m,local_X.size()) = tool_tree.X;
+  for (const int i : range(tool_tree.X.size()))
+    seeds.append(n+i);
+  Array<int> weight(local_faces.size(),uninit);
+  weight.slice(0,affected.size()).fill(1);
+  weight.slice(affected.size(),weight.size()).fill(operand_weight);
+
+  // Split the local soup
+  const auto local_mesh = new_<const TriangleSoup>(local_faces);
+  const auto face_tree = new_<SimplexTree<EV,2>>(*local_mesh,local_X,1);
+  const auto A = intersection_simplices(face_tree,seeds);
+  const auto ef_vertices = A.x;
+  const auto ff_edges = A.y;
+
+  // Compute depths, with rays also counting the unaffected stock
+  DepthUnionFind union_find;
+  union_find.lenient = true;
+  const auto outside = [&](const XRay& ray) {
+    int depth = 0;
+    for (const auto& L : levels) {
+      struct {
+        const XRay& ray;
+        const Level& L;
+        const Hashtable<int>& affected_set;
+        RawArray<const bool> alive;
+        RawArray<const Vector<int,3>> faces;
+        RawArray<const EV> X;
+        int& depth;
+
+        bool cull(const int n) const {
+          return ray.cull(L.tree->boxes[n]);
+        }
+
+        void leaf(const int n) {
+          const int f = L.faces[L.tree->prims(n)[0]];
+          if (!alive[f] || affected_set.contains(f))
+            return;
+          const auto v = faces[f];
+          depth += ray.crossing(v,P(v.x,X[v.x]),P(v.y,X[v.y]),P(v.z,X[v.z]));
+        }
+      } visitor({ray,L,affected_set,alive,faces,X,depth});
+      single_traverse(*L.tree,visitor);
+    }
+    return depth;
+  };
+  const auto B = retriangulate_soup(face_tree,seeds,weight,&union_find,ef_vertices,ff_edges,outside);
+  const auto fff_vertices = B.x;
+  const auto cut_faces = B.y;
+  const auto original_face_index = B.z;
+  if (!union_find.consistent)
+    return false;
+
+  // Keep stock pieces outside the operand, and operand pieces inside (subtract) or outside (add) the stock.
+  // The stock depth of a stock piece is nonzero only if rounding has left the stock slightly self intersecting.
+  Array<Vector<int,3>> kept;
+  const int infinity = union_find.info.size()-1;
+  const int base = local_mesh->segment_soup()->elements.size()+ff_edges.size();
+  for (const int f : range(cut_faces.size())) {
+    const int d = union_find.delta(infinity,base+f),
+              operand_depth = (d+operand_weight/2)>>16, // Round to nearest
+              stock_depth = d-operand_weight*operand_depth;
+    static_assert(operand_weight==1<<16,"");
+    if (original_face_index[f] < affected.size()) {
+      if (!operand_depth && !stock_depth)
+        kept.append(cut_faces[f]);
+    } else if (subtract ? stock_depth>0 : stock_depth<=0)
+      kept.append(subtract ? vec(cut_faces[f].x,cut_faces[f].z,cut_faces[f].y) : cut_faces[f]);
+  }
+
+  // Concatenate local vertices together, and repair loop vertices as in exact_split_soup
+  Array<EV> Xs;
+  Xs.preallocate(local_X.size()+ef_vertices.flat.size()+fff_vertices.size());
+  Xs.extend(local_X);
+  for (const auto& v : ef_vertices.flat)
+    Xs.append_assuming_enough_space(v.rounded);
+  for (const auto& v : fff_vertices)
+    Xs.append_assuming_enough_space(v.rounded);
+  fix_loops(kept,Xs,local_X.size(),ff_edges);
+
+  // Map stock vertices back to their session ids.  All other vertices are new, and are numbered n+i for Xs[m+i].
+  for (auto& v : kept)
+    for (int i=0;i<3;i++)
+      v[i] = v[i]<m ? seeds[v[i]] : n+v[i]-m;
+  result = tuple(kept,Xs.slice_own(m,Xs.size()));
+  return true;
+}
+
+// Directed boundary edges of a patch of faces, with multiplicity
+static Hashtable<Vector<int,2>,int> patch_boundary(RawArray<const Vector<int,3>> faces) {
+  Hashtable<Vector<int,2>,int> boundary;
+  for (const auto& f : faces)
+    for (int i=0;i<3;i++) {
+      const auto e = vec(f[i],f[(i+1)%3]);
+      if (e.x < e.y)
+        boundary[e]++;
+      else
+        boundary[e.reversed()]--;
+    }
+  return boundary;
+}
+
+static bool same_boundary(const Hashtable<Vector<int,2>,int>& b0, const Hashtable<Vector<int,2>,int>& b1) {
+  int n0 = 0, n1 = 0;
+  for (const auto& e : b0)
+    if (e.y) {
+      n0++;
+      if (b1.get_default(e.x,0) != e.y)
+        return false;
+    }
+  for (const auto& e : b1)
+    n1 += e.y!=0;
+  return n0 == n1;
+}
+
+int MeshCSGSession::apply(const TriangleSoup& tool, RawArray<const TV> tool_X, const bool subtract) {
+  GEODE_ASSERT(tool.nodes()<=tool_X.size());
+  if (!bounds.contains(bounding_box(tool_X)))
+    throw ValueError("MeshCSGSession: operand lies outside the session bounds");
+  IntervalScope scope;
+  const auto tool_tree = new_<SimplexTree<EV,2>>(tool,amap(quant,tool_X).copy(),1);
+
+  // Collect live stock faces whose boxes overlap the operand's box.  All other stock faces are outside the operand.
+  const auto tool_box = tool_tree->bounding_box().thickened(4);
+  Hashtable<int> affected_set;
+  Array<int> affected;
+  for (const auto& L : levels) {
+    struct {
+      const Level& L;
+      const Box<EV> box;
+      RawArray<const bool> alive;
+      Hashtable<int>& affected_set;
+      Array<int>& affected;
+
+      bool cull(const int n) const {
+        return !L.tree->boxes[n].intersects(box);
+      }
+
+      void leaf(const int n) {
+        const int f = L.faces[L.tree->prims(n)[0]];
+        if (alive[f] && affected_set.set(f))
+          affected.append(f);
+      }
+    } visitor({L,tool_box,alive,affected_set,affected});
+    single_traverse(*L.tree,visitor);
+  }
+  // Faces crossing an affected face must be re-split along with it
+  for (bool changed=true;changed;) {
+    changed = false;
+    for (const auto c : crossings)
+      for (const int i : range(2))
+        if (alive[c[i]] && alive[c[1-i]] && affected_set.contains(c[i]) && affected_set.set(c[1-i])) {
+          affected.append(c[1-i]);
+          changed = true;
+        }
+  }
+  sort(affected);
+
+  // Resplit locally.  Since the stock may be slightly self intersecting due to rounding, the local depths
+  // can occasionally disagree with those of the full stock.  We detect this either as an inconsistency in
+  // the depth computation or as a change in the boundary of the replaced patch, and fall back to resplitting
+  // everything, which is equivalent to split_soup.
+  Tuple<Array<Vector<int,3>>,Array<EV>> split;
+  const bool local = this->split(tool,tool_tree,affected,affected_set,subtract,split)
+                  && same_boundary(patch_boundary(faces.subset(affected).copy()),patch_boundary(split.x));
+  if (!local) {
+    affected_set.clear();
+    affected.clear();
+    for (const int f : range(faces.size()))
+      if (alive[f]) {
+        affected_set.set(f);
+        affected.append(f);
+      }
+    GEODE_ASSERT(this->split(tool,tool_tree,affected,affected_set,subtract,split),
+                 "Inconsistent depth calculation, input meshes are not topologically closed");
+  }
+  auto& kept = split.x;
+  const auto& new_X = split.y;
+
+  // Add new vertices to the session
+  const int n = X.size();
+  Array<int> to_session(new_X.size(),uninit);
+  to_session.fill(-1);
+  for (auto& v : kept)
+    for (int i=0;i<3;i++)
+      if (v[i] >= n) {
+        int& j = to_session[v[i]-n];
+        if (j < 0)
+          j = X.append(new_X[v[i]-n]);
+        v[i] = j;
+      }
+
+  // Replace the affected faces
+  for (const int f : affected) {
+    alive[f] = false;
+    for (const int v : faces[f])
+      alive_vertices -= !--uses[v];
+  }
+  alive_faces -= affected.size();
+
+  // Record new faces which cross each other or the remaining stock due to rounding
+  if (kept.size()) {
+    const int start = faces.size();
+    const auto kept_mesh = new_<const TriangleSoup>(kept);
+    const auto kept_tree = new_<SimplexTree<EV,2>>(*kept_mesh,X,1);
+    for (const auto& L : levels) {
+      struct {
+        MeshCSGSession& self;
+        const Level& L;
+        const SimplexTree<EV,2>& kept_tree;
+        const int start;
+
+        bool cull(const int n0, const int n1) const { return false; }
+
+        void leaf(const int n0, const int n1) {
+          const int f0 = L.faces[L.tree->prims(n0)[0]],
+                    f1 = kept_tree.prims(n1)[0];
+          if (self.alive[f0] && self.crosses(self.faces[f0],kept_tree.mesh->elements[f1]))
+            self.crossings.append(vec(f0,start+f1));
+        }
+      } visitor({*this,L,kept_tree,start});
+      double_traverse(*L.tree,*kept_tree,visitor);
+    }
+    struct {
+      MeshCSGSession& self;
+      const SimplexTree<EV,2>& kept_tree;
+      const int start;
+
+      bool cull(const int n) const { return false; }
+      bool cull(const int n0, const int n1) const { return false; }
+      void leaf(const int n) {}
+
+      void leaf(const int n0, const int n1) {
+        const int f0 = kept_tree.prims(n0)[0],
+                  f1 = kept_tree.prims(n1)[0];
+        const auto& elements = kept_tree.mesh->elements;
+        if (self.crosses(elements[f0],elements[f1]))
+          self.crossings.append(vec(start+f0,start+f1));
+      }
+    } visitor({*this,kept_tree,start});
+    double_traverse(*kept_tree,visitor);
+  }
+  insert(kept);
+  return affected.size();
+}
+
+bool MeshCSGSession::crosses(const Vector<int,3> f0, const Vector<int,3> f1) const {
+  // As in intersection_simplices, two faces intersect iff an edge of one crosses the other away from shared vertices
+  for (const int r : range(2)) {
+    const auto a = r ? f1 : f0,
+               b = r ? f0 : f1;
+    const P b0(b.x,X[b.x]), b1(b.y,X[b.y]), b2(b.z,X[b.z]);
+    for (int i=0;i<3;i++) {
+      const int u = a[i], v = a[(i+1)%3];
+      if (   !b.contains(u) && !b.contains(v)
+          && segment_triangle_intersect(P(u,X[u]),P(v,X[v]),b0,b1,b2))
+        return true;
+    }
+  }
+  return false;
+}
+
+Tuple<Ref<const TriangleSoup>,Array<TV>> MeshCSGSession::soup() const {
+  Array<int> map(X.size());
+  map.fill(-1);
+  Array<TV> new_X;
+  Array<Vector<int,3>> new_faces;
+  for (const int f : range(faces.size()))
+    if (alive[f]) {
+      auto v = faces[f];
+      for (int i=0;i<3;i++) {
+        if (map[v[i]] < 0)
+          map[v[i]] = new_X.append(quant.inverse(X[v[i]]));
+        v[i] = map[v[i]];
+      }
+      new_faces.append(v);
+    }
+  return tuple(new_<const TriangleSoup>(new_faces),new_X);
+}
+
 // A random looking polynomial vector field for testing purposes.  Doing this in numpy was terribly slow.
 static TV signature(const TV p) {
   static const TV cs[20] = {{0.63579617566858204,0.9803866221230878,-1.1149781390749458},{-1.6911029843181062,0.0076849096251670494,-0.20902591156558492},{-0.32936081722995436,1.0215088816527711,-1.5612465562435749},{-0.45614229334747636,-0.70778970138794417,0.81221475328378245},{0.69508749936195235,0.36830278439721859,-0.023097745289497953},{-0.36041115257507639,0.084618397319454405,-0.62507343653099212},{-0.42001958405510559,0.58110444489126467,0.035872312121989956},{-1.0638801780427223,-1.4966105518400179,-0.46276143102821121},{-0.22713523028165017,-0.51887442706005649,-0.61617899144489152},{-0.01614627380526858,-1.0348875675622369,-2.0864245187665253},{0.34335366817123675,1.1129271600488675,0.030032754961424244},{-0.18700129596135318,0.57715102790126815,0.044064679264981095},{0.38502926178803099,0.93873127293758907,-0.024237498658405344},{0.405772588718322,0.27261261469141018,-1.3784370485864426},{0.033162792967982614,-0.53478654089645028,0.66062198865384403},{0.10747984116039729,0.50678316980726434,0.35782550032895966},{1.3356403638933552,0.01886685799296664,-0.92324588402595387},{-0.4121840452935373,0.25449626619085108,-0.1168890420360859},{-0.24743247723688286,0.6995835397565725,1.8017593723959369},{-2.1202767211585711,0.47120110220149913,0.088232150712609772}};
@@ -1494,4 +2023,14 @@ void wrap_mesh_csg() {
   GEODE_OVERLOADED_FUNCTION_2(exact_split_depth_fn,"exact_split_soup_with_weight",exact_split_soup)
 
   GEODE_FUNCTION(mesh_signature)
+
+  typedef MeshCSGSession Self;
+  Class<Self>("MeshCSGSession")
+    .GEODE_INIT(const TriangleSoup&,Array<const TV>,const Box<TV>&)
+    .GEODE_FIELD(bounds)
+    .GEODE_METHOD(size)
+    .GEODE_METHOD(subtract)
+    .GEODE_METHOD(add)
+    .GEODE_METHOD(soup)
+    ;
 }
@@ -2,7 +2,11 @@
 #pragma once
 
 #include <geode/exact/config.h>
+#include <geode/exact/quantize.h>
+#include <geode/geometry/forward.h>
+#include <geode/structure/forward.h>
 #include <geode/mesh/TriangleSoup.h>
+#include <vector>
 namespace geode {
 
 // If depth is this, faces at all depths are returned
@@ -21,4 +25,64 @@ exact_split_soup(const TriangleSoup& faces, Array<const exact::Vec3> X, const in
 GEODE_CORE_EXPORT Tuple<Ref<const TriangleSoup>,Array<exact::Vec3>>
 exact_split_soup(const TriangleSoup& faces, Array<const exact::Vec3> X, Array<const int> depth_weights, const int depth);
 
+// A persistent CSG session for applying many small closed operands to one large closed stock mesh, such as
+// subtracting tool positions in machining simulation.  The stock is quantized once and kept in a small set of
+// face trees.  Each operation re-splits only the stock faces whose boxes overlap the operand, so its cost
+// tracks the size of the affected region rather than the size of the stock.  Operands must be closed,
+// positively oriented, and lie inside the bounds given at construction.
+class MeshCSGSession : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef Vector<double,3> TV;
+  typedef exact::Vec3 EV;
+
+  const Box<TV> bounds;
+  const Quantizer<double,3> quant;
+
+private:
+  Array<EV> X; // Quantized vertices, some of which may be unused
+  Array<int> uses; // Number of live faces using each vertex
+  Array<Vector<int,3>> faces; // Every face ever added, dead or alive
+  Array<bool> alive;
+  int alive_faces, alive_vertices;
+
+  // Faces are partitioned into trees of geometrically decreasing size, merged as new faces arrive
+  struct Level {
+    Ref<const SimplexTree<EV,2>> tree;
+    Array<const int> faces; // Session face for each tree prim
+  };
+  std::vector<Level> levels;
+
+  // Rounding constructed vertices can leave pairs of nearby faces slightly intersecting.  Such pairs must be
+  // re-split together, so we remember them.
+  Array<Vector<int,2>> crossings;
+
+protected:
+  GEODE_CORE_EXPORT MeshCSGSession(const TriangleSoup& stock, Array<const TV> X, const Box<TV>& bounds);
+public:
+  ~MeshCSGSession();
+
+  int size() const { return alive_faces; }
+
+  // Apply an operand, returning the number of stock faces which were re-split
+  GEODE_CORE_EXPORT int subtract(const TriangleSoup& tool, Array<const TV> X);
+  GEODE_CORE_EXPORT int add(const TriangleSoup& tool, Array<const TV> X);
+
+  // The current stock, without unused vertices
+  GEODE_CORE_EXPORT Tuple<Ref<const TriangleSoup>,Array<TV>> soup() const;
+
+private:
+  int apply(const TriangleSoup& tool, RawArray<const TV> X, const bool subtract);
+  // Split affected faces against the operand, returning false if the local depths are inconsistent.  Result faces
+  // refer either to session vertices or, for indices i >= X.size(), to new vertices result.y[i-X.size()].
+  bool split(const TriangleSoup& tool, const SimplexTree<EV,2>& tool_tree, RawArray<const int> affected,
+             const Hashtable<int>& affected_set, const bool subtract,
+             Tuple<Array<Vector<int,3>>,Array<EV>>& result) const;
+  Level level(RawArray<const int> faces) const;
+  void insert(RawArray<const Vector<int,3>> new_faces);
+  void compact();
+  bool crosses(const Vector<int,3> f0, const Vector<int,3> f1) const;
+};
+
 }
@@ -11,8 +11,13 @@ void wrap_exact() {
   GEODE_WRAP(predicates)
   GEODE_WRAP(constructions)
   GEODE_WRAP(delaunay)
+  GEODE_WRAP(refine_delaunay)
+  GEODE_WRAP(point_locator)
+  GEODE_WRAP(collision)
+  GEODE_WRAP(collision_detector)
   GEODE_WRAP(polygon_csg)
   GEODE_WRAP(circle_csg)
+  GEODE_WRAP(arc_csg)
   GEODE_WRAP(simple_triangulate)
   GEODE_WRAP(mesh_csg)
   GEODE_WRAP(polynomial)
@@ -9,7 +9,15 @@
 #include <geode/python/wrap.h>
 #include <geode/random/counter.h>
 #include <geode/utility/move.h>
+#include <geode/utility/Log.h>
 #include <geode/vector/Matrix.h>
+#if GEODE_PREDICATE_STATS
+#include <map>
+#include <mutex>
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+#endif
 namespace geode {
 
 // Our function is defined by
@@ -81,6 +89,10 @@ template<int m> inline Vector<ExactInt,m> perturbation(const int level, const ex
 template<int m> inline Vector<ExactInt,m> perturbation(const int level, const exact::Perturbed<2>::ValueType seed) { return packed_perturbation<m>(level, seed); }
 template<int m> inline Vector<ExactInt,m> perturbation(const int level, const exact::Perturbed<3>::ValueType seed) { return packed_perturbation<m>(level, seed); }
 
+template<class PerturbedT> Vector<ExactInt,PerturbedT::m> seed_perturbation(const int level, const PerturbedT X) {
+  return perturbation<PerturbedT::m>(level,X.seed());
+}
+
 /********** Symbolic perturbation **********/
 
 template<int m> static inline Vector<ExactInt,m> to_exact(const Vector<Quantized,m>& x) {
@@ -121,7 +133,7 @@ assert_last_nonzero(void(*const polynomial)(R,RawArray<const Vector<Exact<1>,Per
 }
 
 template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,PerturbedT::m>>),
-                                                      const int degree, RawArray<const PerturbedT> X) {
+                                                      const int degree, RawArray<const PerturbedT> X, int* const depth) {
   const int m = PerturbedT::m;
   typedef Vector<Exact<1>,m> EV;
   if (check)
@@ -139,8 +151,11 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
       Z[i] = EV(to_exact(X[i].value()));
     const auto R = GEODE_RAW_ALLOCA(precision,mp_limb_t);
     predicate(R,Z);
-    if (const int sign = mpz_sign(R))
+    if (const int sign = mpz_sign(R)) {
+      if (depth)
+        *depth = 0;
       return sign>0;
+    }
   }
 
   // Check the first perturbation level with specialized code
@@ -171,8 +186,11 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
 
     // Compute sign
     for (int j=0;j<degree;j++)
-      if (const int sign = mpz_sign(values[j]))
+      if (const int sign = mpz_sign(values[j])) {
+        if (depth)
+          *depth = 1;
         return sign>0;
+      }
   }
 
   {
@@ -215,8 +233,11 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
         }
 
       // If we find a nonzero sign, we're done!
-      if (sign)
+      if (sign) {
+        if (depth)
+          *depth = d;
         return sign>0;
+      }
 
       // If we get through two levels without fixing the degeneracy, run a fast, strict identity test to make sure we weren't handed an impossible problem.
       if (d==2)
@@ -569,13 +590,62 @@ static void perturbed_ratio_test() {
     }
 }
 
+#if GEODE_PREDICATE_STATS
+// Each translation unit has its own copy of each predicate's counters, so we merge by name when reporting
+static std::mutex stats_mutex;
+static vector<PredicateStats*> all_stats;
+
+static string demangle(const char* name) {
+#ifdef __GNUC__
+  int status;
+  if (char* s = abi::__cxa_demangle(name,0,0,&status)) {
+    const string r = s;
+    free(s);
+    return r;
+  }
+#endif
+  return name;
+}
+
+PredicateStats::PredicateStats(const char* name)
+  : name(name), calls(0), float_filter(0), interval_filter(0), unperturbed(0) {
+  for (auto& d : depths)
+    d = 0;
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  all_stats.push_back(this);
+}
+
+void report_predicate_stats() {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  std::map<string,Vector<uint64_t,7>> merged;
+  for (const auto s : all_stats) {
+    const uint64_t counts[7] = {s->calls.exchange(0),s->float_filter.exchange(0),s->interval_filter.exchange(0),
+                                s->unperturbed.exchange(0),s->depths[0].exchange(0),s->depths[1].exchange(0),
+                                s->depths[2].exchange(0)};
+    auto& m = merged[demangle(s->name)];
+    for (const int i : range(7))
+      m[i] += counts[i];
+  }
+  static const char* labels[7] = {"calls","float filter","interval filter","unperturbed",
+                                  "depth 1","depth 2","depth 3+"};
+  for (const auto& m : merged)
+    if (m.second[0])
+      for (const int i : range(7))
+        Log::stat(format("%s %s",m.first,labels[i]),m.second[i]);
+}
+#else
+void report_predicate_stats() {}
+#endif
+
 #define INSTANTIATE(m) \
   template Vector<ExactInt,m> perturbation(const int, const int); \
   template Vector<ExactInt,m> packed_perturbation(const int, const Vector<Quantized,m>); \
+  template Vector<ExactInt,m> seed_perturbation(const int, const exact::Perturbed<m>); \
+  template Vector<ExactInt,m> seed_perturbation(const int, const exact::ImplicitlyPerturbed<m>); \
   template bool perturbed_sign(void(*const)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,m>>), \
-                                            const int, RawArray<const exact::Perturbed<m>>); \
+                                            const int, RawArray<const exact::Perturbed<m>>, int* const); \
   template bool perturbed_sign(void(*const)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,m>>), \
-                                            const int, RawArray<const exact::ImplicitlyPerturbed<m>>); \
+                                            const int, RawArray<const exact::ImplicitlyPerturbed<m>>, int* const); \
   template bool perturbed_ratio(RawArray<Quantized>,void(*const)(RawArray<mp_limb_t,2>, \
                                 RawArray<const Vector<Exact<1>,m>>), const int, \
                                 RawArray<const exact::Perturbed<m>>, bool); \
@@ -587,7 +657,8 @@ INSTANTIATE(2)
 INSTANTIATE(3)
 
 template bool perturbed_sign(void(*const)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,2>>), const int,
-                             RawArray<const exact::ImplicitlyPerturbedCenter>);
+                             RawArray<const exact::ImplicitlyPerturbedCenter>, int* const);
+template Vector<ExactInt,2> seed_perturbation(const int, const exact::ImplicitlyPerturbedCenter);
 }
 using namespace geode;
 
@@ -597,4 +668,5 @@ void wrap_perturb() {
   GEODE_FUNCTION_2(perturbed_sign_test_3,perturbed_sign_test<3>)
   GEODE_FUNCTION(snap_divs_test)
   GEODE_FUNCTION(perturbed_ratio_test)
+  GEODE_FUNCTION(report_predicate_stats)
 }
@@ -4,11 +4,14 @@
 #include <geode/exact/config.h>
 #include <geode/exact/debug.h>
 #include <geode/exact/Exact.h>
+#include <geode/exact/FloatFilter.h>
 #include <geode/exact/Interval.h>
+#include <geode/exact/Intervals.h>
 #include <geode/exact/irreducible.h>
 #include <geode/structure/Tuple.h>
 #include <geode/utility/IRange.h>
 #include <geode/vector/Vector.h>
+#include <atomic>
 namespace geode {
 
 // sys/termios.h on Mac was defining B0 as a macro.  Don't.
@@ -21,9 +24,10 @@ namespace geode {
 //
 // Identically zero polynomials are zero regardless of perturbation; these are detected and an exception is thrown.
 // predicate should compute a quantity of type Exact<degree>, then copy it into result with mpz_set.
+// If depth is nonnull, it receives the number of perturbation levels needed (0 if the unperturbed sign is nonzero).
 template<class PerturbedT> GEODE_CORE_EXPORT GEODE_COLD bool
 perturbed_sign(void(*const predicate)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,PerturbedT::m>>),
-               const int degree, RawArray<const PerturbedT> X);
+               const int degree, RawArray<const PerturbedT> X, int* const depth=0);
 
 // Given polynomial numerator and denominator functions, evaluate numerator(X+epsilon)/denominator(X+epsilon) rounded
 // to int for the same infinitesimal perturbation epsilon as in perturbed_sign.  The numerator and denominator must be
@@ -50,6 +54,10 @@ perturbed_ratio(RawArray<Quantized> result,
 // starts with perturbation<m>.
 template<int m> GEODE_CORE_EXPORT Vector<ExactInt,m> perturbation(const int level, const int i);
 
+// The levelth perturbation of X, exactly as used by perturbed_sign.  This handles implicitly perturbed points too.
+template<class PerturbedT> GEODE_CORE_EXPORT Vector<ExactInt,PerturbedT::m>
+seed_perturbation(const int level, const PerturbedT X);
+
 // The type of a degree d predicate evaluated on vectors of the given type (see usage in predicates.cpp)
 template<int d,class TV> struct PredicateTypeHelper { typedef typename TV::Scalar type; };
 template<int d,int m> struct PredicateTypeHelper<d,Vector<Exact<1>,m>> { typedef Exact<d> type; };
@@ -71,6 +79,90 @@ wrap_predicate(Types<entries...>) -> decltype(&wrapped_predicate<F,d,entries...>
   return &wrapped_predicate<F,d,entries...>;
 }
 
+#if GEODE_FAST_EXACT
+// The exact stages of perturbed_sign for a specific F, running inline on fixed size integers instead of calling through
+// gmp: first the unperturbed sign, then the first perturbation level.  Returns the perturbed sign and sets depth, or
+// returns zero if both stages are degenerate, in which case perturbed_sign must be called.
+template<class F,class PerturbedT,class... entries,int degree> static int
+fixed_perturbed_sign(Types<entries...>, const PerturbedT* X, int& depth, Exact<degree>*) {
+  static const int m = PerturbedT::m,
+                   n = sizeof...(entries);
+  typedef Vector<Exact<1>,m> EV;
+  static_assert(degree<=20,"degree! must fit in one limb");
+  typedef Exact<degree+1> Scaled; // One extra limb for the factor of degree! (see polynomial.h)
+
+  // Check if the predicate is nonsingular without perturbation
+  Vector<ExactInt,m> x[n];
+  for (int i=0;i<n;i++)
+    x[i] = Vector<ExactInt,m>(X[i].value());
+  if (const int s = sign(F::eval(EV(x[entries::value])...))) {
+    depth = 0;
+    return s;
+  }
+
+  // Evaluate the polynomial at epsilon = 1, ..., degree along the first perturbation
+  Vector<ExactInt,m> y[n];
+  for (int i=0;i<n;i++)
+    y[i] = seed_perturbation(1,X[i]);
+  Scaled A[degree];
+  for (int j=0;j<degree;j++) {
+    EV Z[n];
+    for (int i=0;i<n;i++)
+      Z[i] = EV(x[i]+(j+1)*y[i]);
+    A[j] = Scaled(F::eval(Z[entries::value]...));
+  }
+
+  // Interpolate as in scaled_univariate_in_place_interpolating_polynomial.  Since degree <= 20, the running factor
+  // never overflows.
+  for (int pass=1;pass<=degree;pass++)
+    for (int k=degree-1;k>=max(pass-1,1);k--)
+      sub_in_place(A[k],A[k-1]);
+  uint64_t factor = 1;
+  for (int k=degree-2;k>=0;k--) {
+    factor *= k+2;
+    mul_in_place(A[k],factor);
+  }
+  for (int k=0;k<degree;k++)
+    for (int i=degree-1;i>k;i--)
+      submul_in_place(A[i-1],A[i],i-k);
+
+  // The sign of the lowest order nonzero coefficient wins
+  depth = 1;
+  for (int j=0;j<degree;j++)
+    if (const int s = sign(A[j]))
+      return s;
+  return 0;
+}
+
+// Constant predicates are always positive (and are always caught by the filters)
+template<class F,class PerturbedT,class... entries> static inline int
+fixed_perturbed_sign(Types<entries...>, const PerturbedT* X, int& depth, One*) {
+  depth = 0;
+  return 1;
+}
+#endif
+
+// Turn on to count how often each perturbed predicate is resolved by each stage, and how deep the perturbation goes.
+// Counts are reported through Log::stat by report_predicate_stats.
+#ifndef GEODE_PREDICATE_STATS
+#define GEODE_PREDICATE_STATS 0
+#endif
+
+#if GEODE_PREDICATE_STATS
+struct PredicateStats {
+  const char* name; // Mangled type name of the predicate
+  std::atomic<uint64_t> calls, float_filter, interval_filter, unperturbed; // unperturbed: exact, nonzero without perturbation
+  std::atomic<uint64_t> depths[3]; // Perturbation levels 1, 2, and 3 or more
+  GEODE_CORE_EXPORT explicit PredicateStats(const char* name); // Registers with report_predicate_stats
+};
+#define GEODE_PREDICATE_STAT(stat) (stats.stat++)
+#else
+#define GEODE_PREDICATE_STAT(stat) ((void)0)
+#endif
+
+// Report and reset predicate counts via Log::stat.  Does nothing unless GEODE_PREDICATE_STATS is on.
+GEODE_CORE_EXPORT void report_predicate_stats();
+
 // Given F s.t. F::eval exactly computes a polynomial in its input arguments, compute the perturbed sign of F(args).
 // This is the standard way of turning an expression into a perturbed predicate.  For examples, see predicates.cpp.
 template<class F,class... Args> GEODE_ALWAYS_INLINE static inline bool perturbed_predicate(const Args... args) {
@@ -78,19 +170,89 @@ template<class F,class... Args> GEODE_ALWAYS_INLINE static inline bool perturbed
   const int d = PerturbedT::m;
   typedef decltype(F::eval(Vector<Exact<1>,d>(args.value())...)) Result;
   const int degree = Result::degree;
+#if GEODE_PREDICATE_STATS
+  static PredicateStats stats(typeid(F).name());
+#endif
+  GEODE_PREDICATE_STAT(calls);
 
   // Check irreducibility if desired
   const auto f = wrap_predicate<F,d>(IRange<sizeof...(Args)>());
   if (IRREDUCIBLE)
     inexact_assert_irreducible(f,degree,sizeof...(Args),typeid(F).name());
 
+  // Evaluate in ordinary floating point with an error bound, which handles most cases without touching the
+  // rounding mode.
+  if (const int s = weak_sign(F::eval(Vector<FloatFilter,d>(args.value())...))) {
+    GEODE_PREDICATE_STAT(float_filter);
+    return s>0;
+  }
+
   // Evaluate with conservative interval arithmetic, hoping for a clear nonzero
-  if (const int s = weak_sign(F::eval(Vector<Interval,d>(args.value())...)))
+  if (const int s = weak_sign(F::eval(Vector<Interval,d>(args.value())...))) {
+    GEODE_PREDICATE_STAT(interval_filter);
     return s>0;
+  }
 
   // Fall back to exact integer evaluation with symbolic perturbation
   const PerturbedT X[sizeof...(Args)] = {args...};
+#if GEODE_FAST_EXACT
+  // Fixed size integer arithmetic handles the unperturbed value and the first level of perturbation without
+  // allocation or gmp.  gmp is needed only if both are degenerate.
+  {
+    int depth;
+    if (const int s = fixed_perturbed_sign<F>(IRange<sizeof...(Args)>(),X,depth,(Result*)0)) {
+#if GEODE_PREDICATE_STATS
+      if (!depth)
+        stats.unperturbed++;
+      else
+        stats.depths[0]++;
+#endif
+      return s>0;
+    }
+  }
+#endif
+#if GEODE_PREDICATE_STATS
+  int depth;
+  const bool s = perturbed_sign(f,degree,asarray(X),&depth);
+  if (!depth)
+    stats.unperturbed++;
+  else
+    stats.depths[min(depth,3)-1]++;
+  return s;
+#else
   return perturbed_sign(f,degree,asarray(X));
+#endif
+}
+
+// Evaluate perturbed_predicate<F> on many queries at once, setting result[i] = perturbed_predicate<F>(queries[i]...).
+// Queries are filtered GEODE_INTERVALS_WIDTH at a time using wide interval arithmetic, and lanes which the filter
+// cannot decide fall back to the scalar path.  Must be called within an IntervalScope.
+template<class F,class PerturbedT,int n,class... entries> static inline void
+perturbed_predicates_helper(Types<entries...>, RawArray<bool> result, RawArray<const Vector<PerturbedT,n>> queries) {
+  static const int w = GEODE_INTERVALS_WIDTH,
+                   d = PerturbedT::m;
+  GEODE_ASSERT(result.size()==queries.size());
+  const int batched = queries.size()/w*w;
+  for (int i=0;i<batched;i+=w) {
+    Vector<Vector<Intervals<w>,d>,n> X;
+    for (int l=0;l<w;l++)
+      for (int j=0;j<n;j++) {
+        const auto x = queries[i+l][j].value();
+        for (int a=0;a<d;a++)
+          X[j][a].set(l,x[a]);
+      }
+    const auto s = F::eval(X[entries::value]...);
+    for (int l=0;l<w;l++) {
+      const int sl = weak_sign(s,l);
+      result[i+l] = sl ? sl>0 : perturbed_predicate<F>(queries[i+l][entries::value]...);
+    }
+  }
+  for (int i=batched;i<queries.size();i++)
+    result[i] = perturbed_predicate<F>(queries[i][entries::value]...);
+}
+template<class F,class PerturbedT,int n> static inline void
+perturbed_predicates(RawArray<bool> result, RawArray<const Vector<PerturbedT,n>> queries) {
+  perturbed_predicates_helper<F>(IRange<n>(),result,queries);
 }
 
 template<class F,class... Args> struct PerturbedConstruct {
@@ -8,6 +8,8 @@
 #include <geode/exact/quantize.h>
 #include <geode/exact/scope.h>
 #include <geode/array/amap.h>
+#include <geode/array/arange.h>
+#include <geode/array/IndirectArray.h>
 #include <geode/array/sort.h>
 #include <geode/geometry/BoxTree.h>
 #include <geode/geometry/polygon.h>
@@ -16,7 +18,9 @@
 #include <geode/structure/Hashtable.h>
 #include <geode/utility/Log.h>
 #include <geode/utility/str.h>
+#include <geode/utility/openmp.h>
 #include <geode/utility/time.h>
+#include <vector>
 
 namespace geode {
 
@@ -34,6 +38,7 @@ typedef exact::Vec2 EV;
 using exact::Perturbed2;
 using Log::cout;
 using std::endl;
+using std::vector;
 
 static Array<Box<EV>> segment_boxes(RawArray<const int> next, RawArray<const EV> X) {
   Array<Box<EV>> boxes(X.size(),uninit);
@@ -52,7 +57,209 @@ static inline bool local_outwards_x_axis(const Perturbed2 x0, const Perturbed2 x
   return out0==out1 ? out0 : triangle_oriented(x0,x1,x2);
 }
 
-Nested<EV> exact_split_polygons(Nested<const EV> polys, const int depth) {
+namespace {
+// Find nontrivial intersections between segments, as pairs of indices of their first points
+struct Pairs {
+  const BoxTree<EV>& tree;
+  RawArray<const int> segments; // The segment corresponding to each primitive of the tree
+  RawArray<const int> next;
+  RawArray<const EV> X;
+  Array<Vector<int,2>> pairs;
+
+  Pairs(const BoxTree<EV>& tree, RawArray<const int> segments, RawArray<const int> next, RawArray<const EV> X)
+    : tree(tree), segments(segments), next(next), X(X) {}
+
+  bool cull(const int n) const { return false; }
+  bool cull(const int n0, const int box1) const { return false; }
+  void leaf(const int n) const { assert(tree.prims(n).size()==1); }
+
+  void leaf(const int n0, const int n1) {
+    assert(tree.prims(n0).size()==1 && tree.prims(n1).size()==1);
+    const int i0 = segments[tree.prims(n0)[0]], i1 = next[i0],
+              j0 = segments[tree.prims(n1)[0]], j1 = next[j0];
+    if (!(i0==j0 || i0==j1 || i1==j0 || i1==j1)) {
+      const auto a0 = Perturbed2(i0,X[i0]), a1 = Perturbed2(i1,X[i1]),
+                 b0 = Perturbed2(j0,X[j0]), b1 = Perturbed2(j1,X[j1]);
+      if (segments_intersect(a0,a1,b0,b1))
+        pairs.append(vec(i0,j0));
+    }
+  }
+};
+
+// A uniform grid of tiles over the segments, with cells computed in integer arithmetic so that bucketing
+// is consistent regardless of rounding mode.
+struct Tiles {
+  EV lo;
+  int n;
+  Vector<ExactInt,2> width;
+
+  Tiles(const Box<EV> box, const int n)
+    : lo(box.min), n(n) {
+    for (const int a : range(2))
+      width[a] = (ExactInt(box.max[a])-ExactInt(box.min[a]))/n+1;
+  }
+
+  int cell(const int a, const Quantized x) const {
+    return int((ExactInt(x)-ExactInt(lo[a]))/width[a]);
+  }
+
+  int tile(const EV x) const {
+    return cell(0,x.x)*n+cell(1,x.y);
+  }
+};
+}
+
+// Compute all nontrivial intersections between segments.  In parallel mode, segments are bucketed into a grid of
+// tiles by their bounding boxes, and tiles are processed concurrently.  Segments overlapping several tiles appear in
+// each of them, so a pair is reported only by the tile containing the lower corner of the intersection of its boxes.
+static Array<Vector<int,2>> intersection_pairs(const BoxTree<EV>& tree, RawArray<const Box<EV>> boxes,
+                                               RawArray<const int> next, RawArray<const EV> X, const bool parallel) {
+  const int n = X.size(),
+            tile_size = 2048,
+            grid = max(int(ceil(sqrt(real(n)/tile_size))),int(ceil(sqrt(4.*omp_get_max_threads()))));
+  if (!parallel || n<=tile_size) {
+    const auto all = arange(n).copy();
+    Pairs pairs(tree,all,next,X);
+    double_traverse(tree,pairs);
+    return pairs.pairs;
+  }
+
+  // Bucket segments into tiles
+  const Tiles tiles(bounding_box(X),grid);
+  const auto cells = [&](const Box<EV>& box) {
+    return Box<Vector<int,2>>(vec(tiles.cell(0,box.min.x),tiles.cell(1,box.min.y)),
+                              vec(tiles.cell(0,box.max.x),tiles.cell(1,box.max.y)));
+  };
+  Array<int> counts(sqr(grid));
+  for (const auto& box : boxes) {
+    const auto c = cells(box);
+    for (int i=c.min.x;i<=c.max.x;i++)
+      for (int j=c.min.y;j<=c.max.y;j++)
+        counts[i*grid+j]++;
+  }
+  Nested<int> segments(counts,uninit);
+  for (int s=n-1;s>=0;s--) {
+    const auto c = cells(boxes[s]);
+    for (int i=c.min.x;i<=c.max.x;i++)
+      for (int j=c.min.y;j<=c.max.y;j++) {
+        const int t = i*grid+j;
+        segments(t,--counts[t]) = s;
+      }
+  }
+
+  // Find intersections within each tile
+  vector<Array<Vector<int,2>>> found(segments.size());
+  OmpExceptions errors;
+  #pragma omp parallel
+  {
+    IntervalScope scope;
+    #pragma omp for schedule(dynamic,1)
+    for (int t=0;t<segments.size();t++) errors.capture([&]{
+      const auto segs = segments[t];
+      if (segs.size()<2)
+        return;
+      const auto tile_tree = new_<BoxTree<EV>>(boxes.subset(segs).copy(),1);
+      Pairs pairs(tile_tree,segs,next,X);
+      double_traverse(*tile_tree,pairs);
+      for (const auto& p : pairs.pairs)
+        if (tiles.tile(EV::componentwise_max(boxes[p.x].min,boxes[p.y].min))==t)
+          found[t].append(p);
+    });
+  }
+  errors.rethrow();
+
+  Array<Vector<int,2>> pairs;
+  for (const auto& f : found)
+    pairs.extend(f);
+  return pairs;
+}
+
+// Walk around polygon p, recording which subsegments have the desired depth.  Each entry (i,j) -> k means that the
+// output contains the portion of segment j from ij to jk.
+static void walk_polygon(const BoxTree<EV>& tree, Nested<const EV> polys, RawArray<const int> next, Nested<int> others,
+                         const int depth, const int p, Array<Tuple<Vector<int,2>,int>>& graph) {
+  RawArray<const EV> X = polys.flat;
+  const auto poly = range(polys.offsets[p],polys.offsets[p+1]);
+  // Compute the depth of the first point in the polygon by firing a ray along the positive x axis.
+  struct Depth {
+    const BoxTree<EV>& tree;
+    RawArray<const int> next;
+    RawArray<const EV> X;
+    const Perturbed2 start;
+    int depth;
+
+    Depth(const BoxTree<EV>& tree, RawArray<const int> next, RawArray<const EV> X, const int prev, const int i)
+      : tree(tree), next(next), X(X)
+      , start(i,X[i])
+      // If we intersect no other segments, the depth depends on the orientation of direction = (1,0) relative to segments prev and i
+      , depth(-!local_outwards_x_axis(Perturbed2(prev,X[prev]),start,Perturbed2(next[i],X[next[i]]))) {}
+
+    bool cull(const int n) const {
+      const auto box = tree.boxes(n);
+      return box.max.x<start.value().x || box.max.y<start.value().y || box.min.y>start.value().y;
+    }
+
+    void leaf(const int n) {
+      assert(tree.prims(n).size()==1);
+      const int i0 = tree.prims(n)[0], i1 = next[i0];
+      if (start.seed()!=i0 && start.seed()!=i1) {
+        const auto a0 = Perturbed2(i0,X[i0]),
+                   a1 = Perturbed2(i1,X[i1]);
+        const bool above0 = upwards(start,a0),
+                   above1 = upwards(start,a1);
+        if (above0!=above1 && above1==triangle_oriented(a0,a1,start))
+          depth += above1 ? 1 : -1;
+      }
+    }
+  };
+  Depth ray(tree,next,X,poly.back(),poly[0]);
+  single_traverse(tree,ray);
+
+  // Walk around the polygon, recording all subsegments at the desired depth
+  int delta = ray.depth-depth;
+  int prev = poly.back();
+  for (const int i : poly) {
+    const int j = next[i];
+    const Vector<Perturbed2,2> segment(Perturbed2(i,X[i]),Perturbed2(j,X[j]));
+    const auto other = others[i];
+    // Sort intersections along this segment
+    if (other.size() > 1) {
+      struct PairOrder {
+        RawArray<const int> next;
+        RawArray<const EV> X;
+        const Vector<Perturbed2,2> segment;
+
+        PairOrder(RawArray<const int> next, RawArray<const EV> X, const Vector<Perturbed2,2>& segment)
+          : next(next), X(X), segment(segment) {}
+
+        bool operator()(const int j, const int k) const {
+          if (j==k)
+            return false;
+          const int jn = next[j],
+                    kn = next[k];
+          return segment_intersections_ordered(segment.x,segment.y,
+                                               Perturbed2(j,X[j]),Perturbed2(jn,X[jn]),
+                                               Perturbed2(k,X[k]),Perturbed2(kn,X[kn]));
+        }
+      };
+      sort(other,PairOrder(next,X,segment));
+    }
+    // Walk through each intersection of this segment, updating delta as we go and remembering the subsegment if it has the right depth
+    for (const int o : other) {
+      if (!delta)
+        graph.append(tuple(vec(prev,i),o));
+      const int on = next[o];
+      delta += segment_directions_oriented(segment.x,segment.y,Perturbed2(o,X[o]),Perturbed2(on,X[on])) ? -1 : 1;
+      prev = o;
+    }
+    if (!delta)
+      graph.append(tuple(vec(prev,i),next[i]));
+    // Advance to the next segment
+    prev = i;
+  }
+}
+
+Nested<EV> exact_split_polygons(Nested<const EV> polys, const int depth, const bool parallel) {
   IntervalScope scope;
   RawArray<const EV> X = polys.flat;
 
@@ -64,148 +271,76 @@ Nested<EV> exact_split_polygons(Nested<const EV> polys, const int depth) {
   }
 
   // Compute all nontrivial intersections between segments
-  struct Pairs {
-    const BoxTree<EV>& tree;
-    RawArray<const int> next;
-    RawArray<const EV> X;
-    Array<Vector<int,2>> pairs;
-
-    Pairs(const BoxTree<EV>& tree, RawArray<const int> next, RawArray<const EV> X)
-      : tree(tree), next(next), X(X) {}
-
-    bool cull(const int n) const { return false; }
-    bool cull(const int n0, const int box1) const { return false; }
-    void leaf(const int n) const { assert(tree.prims(n).size()==1); }
-
-    void leaf(const int n0, const int n1) {
-      assert(tree.prims(n0).size()==1 && tree.prims(n1).size()==1);
-      const int i0 = tree.prims(n0)[0], i1 = next[i0],
-                j0 = tree.prims(n1)[0], j1 = next[j0];
-      if (!(i0==j0 || i0==j1 || i1==j0 || i1==j1)) {
-        const auto a0 = Perturbed2(i0,X[i0]), a1 = Perturbed2(i1,X[i1]),
-                   b0 = Perturbed2(j0,X[j0]), b1 = Perturbed2(j1,X[j1]);
-        if (segments_intersect(a0,a1,b0,b1))
-          pairs.append(vec(i0,j0));
-      }
-    }
-  };
-  const auto tree = new_<BoxTree<EV>>(segment_boxes(next,X),1);
-  Pairs pairs(tree,next,X);
-  double_traverse(*tree,pairs);
+  const auto boxes = segment_boxes(next,X);
+  const auto tree = new_<BoxTree<EV>>(boxes,1);
+  auto pairs = intersection_pairs(tree,boxes,next,X,parallel);
 
   // Group intersections by segment.  Each pair is added twice: once for each order.
   Array<int> counts(X.size());
-  for (auto pair : pairs.pairs) {
+  for (auto pair : pairs) {
     counts[pair.x]++;
     counts[pair.y]++;
   }
   Nested<int> others(counts,uninit);
-  for (auto pair : pairs.pairs) {
+  for (auto pair : pairs) {
     others(pair.x,--counts[pair.x]) = pair.y;
     others(pair.y,--counts[pair.y]) = pair.x;
   }
-  pairs.pairs.clean_memory();
+  pairs.clean_memory();
   counts.clean_memory();
 
-  // Walk all original polygons, recording which subsegments occur in the final result
-  Hashtable<Vector<int,2>,int> graph; // If (i,j) -> k, the output contains the portion of segment j from ij to jk
-  for (const int p : range(polys.size())) {
-    const auto poly = range(polys.offsets[p],polys.offsets[p+1]);
-    // Compute the depth of the first point in the polygon by firing a ray along the positive x axis.
-    struct Depth {
-      const BoxTree<EV>& tree;
-      RawArray<const int> next;
-      RawArray<const EV> X;
-      const Perturbed2 start;
-      int depth;
-
-      Depth(const BoxTree<EV>& tree, RawArray<const int> next, RawArray<const EV> X, const int prev, const int i)
-        : tree(tree), next(next), X(X)
-        , start(i,X[i])
-        // If we intersect no other segments, the depth depends on the orientation of direction = (1,0) relative to segments prev and i
-        , depth(-!local_outwards_x_axis(Perturbed2(prev,X[prev]),start,Perturbed2(next[i],X[next[i]]))) {}
-
-      bool cull(const int n) const {
-        const auto box = tree.boxes(n);
-        return box.max.x<start.value().x || box.max.y<start.value().y || box.min.y>start.value().y;
-      }
-
-      void leaf(const int n) {
-        assert(tree.prims(n).size()==1);
-        const int i0 = tree.prims(n)[0], i1 = next[i0];
-        if (start.seed()!=i0 && start.seed()!=i1) {
-          const auto a0 = Perturbed2(i0,X[i0]),
-                     a1 = Perturbed2(i1,X[i1]);
-          const bool above0 = upwards(start,a0),
-                     above1 = upwards(start,a1);
-          if (above0!=above1 && above1==triangle_oriented(a0,a1,start))
-            depth += above1 ? 1 : -1;
-        }
-      }
-    };
-    Depth ray(tree,next,X,poly.back(),poly[0]);
-    single_traverse(*tree,ray);
-
-    // Walk around the polygon, recording all subsegments at the desired depth
-    int delta = ray.depth-depth;
-    int prev = poly.back();
-    for (const int i : poly) {
-      const int j = next[i];
-      const Vector<Perturbed2,2> segment(Perturbed2(i,X[i]),Perturbed2(j,X[j]));
-      const auto other = others[i];
-      // Sort intersections along this segment
-      if (other.size() > 1) {
-        struct PairOrder {
-          RawArray<const int> next;
-          RawArray<const EV> X;
-          const Vector<Perturbed2,2> segment;
-
-          PairOrder(RawArray<const int> next, RawArray<const EV> X, const Vector<Perturbed2,2>& segment)
-            : next(next), X(X), segment(segment) {}
-
-          bool operator()(const int j, const int k) const {
-            if (j==k)
-              return false;
-            const int jn = next[j],
-                      kn = next[k];
-            return segment_intersections_ordered(segment.x,segment.y,
-                                                 Perturbed2(j,X[j]),Perturbed2(jn,X[jn]),
-                                                 Perturbed2(k,X[k]),Perturbed2(kn,X[kn]));
-          }
-        };
-        sort(other,PairOrder(next,X,segment));
-      }
-      // Walk through each intersection of this segment, updating delta as we go and remembering the subsegment if it has the right depth
-      for (const int o : other) {
-        if (!delta)
-          graph.set(vec(prev,i),o);
-        const int on = next[o];
-        delta += segment_directions_oriented(segment.x,segment.y,Perturbed2(o,X[o]),Perturbed2(on,X[on])) ? -1 : 1;
-        prev = o;
-      }
-      if (!delta)
-        graph.set(vec(prev,i),next[i]);
-      // Advance to the next segment
-      prev = i;
+  // Walk all original polygons, recording which subsegments occur in the final result.  In parallel, blocks of
+  // polygons are walked concurrently and merged in polygon order, so that the result matches the serial version.
+  const int block = 64,
+            blocks = parallel ? (polys.size()+block-1)/block : 1;
+  vector<Array<Tuple<Vector<int,2>,int>>> entries(blocks);
+  if (parallel) {
+    OmpExceptions errors;
+    #pragma omp parallel
+    {
+      IntervalScope scope;
+      #pragma omp for schedule(dynamic,1)
+      for (int b=0;b<blocks;b++) errors.capture([&]{
+        for (const int p : range(b*block,min(polys.size(),(b+1)*block)))
+          walk_polygon(tree,polys,next,others,depth,p,entries[b]);
+      });
     }
+    errors.rethrow();
+  } else
+    for (const int p : range(polys.size()))
+      walk_polygon(tree,polys,next,others,depth,p,entries[0]);
+  Hashtable<Vector<int,2>,int> graph; // If (i,j) -> k, the output contains the portion of segment j from ij to jk
+  for (auto& e : entries) {
+    for (const auto& ijk : e)
+      graph.set(ijk.x,ijk.y);
+    e.clean_memory();
   }
 
   // Walk the graph to produce output polygons
   Hashtable<Vector<int,2>> seen;
-  Nested<EV,false> output;
+  Nested<Vector<int,2>,false> loops;
   for (const auto& start : graph)
     if (seen.set(start.x)) {
       auto ij = start.x;
       for (;;) {
-        const int i = ij.x, j = ij.y, in = next[i], jn = next[j];
-        output.flat.append(j==next[i] ? X[j] : segment_segment_intersection(Perturbed2(i,X[i]),Perturbed2(in,X[in]),Perturbed2(j,X[j]),Perturbed2(jn,X[jn])));
-        ij = vec(j,graph.get(ij));
+        loops.flat.append(ij);
+        ij = vec(ij.y,graph.get(ij));
         if (ij == start.x)
           break;
         seen.set(ij);
       }
-      output.offsets.append(output.flat.size());
+      loops.offsets.append(loops.flat.size());
+    }
+  Nested<EV> output = Nested<EV>::empty_like(loops);
+  #pragma omp parallel if (parallel)
+  {
+    IntervalScope scope;
+    #pragma omp for
+    for (int k=0;k<loops.flat.size();k++) {
+      const int i = loops.flat[k].x, j = loops.flat[k].y, in = next[i], jn = next[j];
+      output.flat[k] = j==next[i] ? X[j] : segment_segment_intersection(Perturbed2(i,X[i]),Perturbed2(in,X[in]),Perturbed2(j,X[j]),Perturbed2(jn,X[jn]));
     }
+  }
   return output;
 }
 
@@ -218,9 +353,9 @@ static inline bool include_face(const int delta, const FillRule rule) {
   GEODE_UNREACHABLE("Bad enum value");
 }
 
-Nested<Vec2> split_polygons(Nested<const Vec2> polys, const int depth) {
+Nested<Vec2> split_polygons(Nested<const Vec2> polys, const int depth, const bool parallel) {
   const auto quant = quantizer(bounding_box(polys));
-  return amap(quant.inverse,exact_split_polygons(amap(quant,polys),depth));
+  return amap(quant.inverse,exact_split_polygons(amap(quant,polys),depth,parallel));
 }
 
 Nested<Vec2> exact_split_polygons_with_rule(Nested<const Vec2> polys, const int depth, const FillRule rule) {
@@ -293,7 +428,7 @@ Nested<Vec2> compare_splitting_algorithms(Nested<const Vec2> polys, const int de
 using namespace geode;
 
 void wrap_polygon_csg() {
-  GEODE_FUNCTION(split_polygons)
+  GEODE_FUNCTION_2(split_polygons_py,split_polygons)
   GEODE_FUNCTION(split_polygons_greater)
   GEODE_FUNCTION(split_polygons_parity)
   GEODE_FUNCTION(split_polygons_neq)
@@ -16,8 +16,12 @@ namespace geode {
 // Resolve all intersections between polygons, and extract the contour with given *external* depth.
 // Depth starts at 0 at infinity, and increases by 1 when crossing a contour from outside to inside.
 // For example, depth = 0 corresponds to polygon_union.
-GEODE_CORE_EXPORT Nested<Vec2> split_polygons(Nested<const Vec2> polys, const int depth);
-GEODE_CORE_EXPORT Nested<exact::Vec2> exact_split_polygons(Nested<const exact::Vec2> polys, const int depth);
+//
+// If parallel is true, intersections are found in a grid of tiles processed concurrently and polygons are walked
+// in parallel.  The result is identical to the serial version.
+GEODE_CORE_EXPORT Nested<Vec2> split_polygons(Nested<const Vec2> polys, const int depth, const bool parallel=false);
+GEODE_CORE_EXPORT Nested<exact::Vec2> exact_split_polygons(Nested<const exact::Vec2> polys, const int depth,
+                                                           const bool parallel=false);
 
 // The union of possibly intersecting polygons, assuming consistent ordering
 template<class... Polys> static inline Nested<Vec2> polygon_union(const Polys&... polys) {
@@ -199,6 +199,54 @@ bool triangles_oriented(const P3 a0, const P3 a1, const P3 a2,
   return perturbed_predicate<TrianglesOriented>(a0,a1,a2,b0,b1,b2,c0,c1,c2);
 }
 
+// Batched predicates
+
+void batch_triangle_oriented(RawArray<bool> result, RawArray<const Vector<P2,3>> queries) {
+  perturbed_predicates<TriangleOriented>(result,queries);
+}
+
+void batch_incircle(RawArray<bool> result, RawArray<const Vector<P2,4>> queries) {
+  perturbed_predicates<Incircle>(result,queries);
+}
+
+void batch_tetrahedron_oriented(RawArray<bool> result, RawArray<const Vector<P3,4>> queries) {
+  perturbed_predicates<TetrahedronOriented>(result,queries);
+}
+
+void batch_segment_triangle_intersect(RawArray<bool> result, RawArray<const Vector<P3,5>> queries) {
+  GEODE_ASSERT(result.size()==queries.size());
+  // As in segment_triangle_intersect, most queries are rejected by the first two orientation tests, so we process
+  // chunks in two stages and run the last three tests only on the survivors.
+  const int chunk = 256;
+  Array<Vector<P3,4>> tets(3*chunk,uninit);
+  Array<bool> signs(3*chunk,uninit);
+  Array<int> survivors(chunk,uninit);
+  for (int start=0;start<queries.size();start+=chunk) {
+    const int n = min(chunk,queries.size()-start);
+    for (int i=0;i<n;i++) {
+      const auto& q = queries[start+i];
+      tets[2*i  ] = vec(q[0],q[2],q[3],q[4]);
+      tets[2*i+1] = vec(q[1],q[2],q[3],q[4]);
+    }
+    perturbed_predicates<TetrahedronOriented,P3,4>(signs.slice(0,2*n),tets.slice(0,2*n));
+    int m = 0;
+    for (int i=0;i<n;i++) {
+      result[start+i] = false;
+      if (signs[2*i]!=signs[2*i+1])
+        survivors[m++] = i;
+    }
+    for (int j=0;j<m;j++) {
+      const auto& q = queries[start+survivors[j]];
+      tets[3*j  ] = vec(q[0],q[1],q[2],q[3]);
+      tets[3*j+1] = vec(q[0],q[1],q[3],q[4]);
+      tets[3*j+2] = vec(q[0],q[1],q[4],q[2]);
+    }
+    perturbed_predicates<TetrahedronOriented,P3,4>(signs.slice(0,3*m),tets.slice(0,3*m));
+    for (int j=0;j<m;j++)
+      result[start+survivors[j]] = signs[3*j]==signs[3*j+1] && signs[3*j]==signs[3*j+2];
+  }
+}
+
 // Unit tests.  Warning: These do not check the geometric correctness of the predicates, only properties of exact computation and perturbation.
 
 static void predicate_tests() {
@@ -236,6 +284,109 @@ static void predicate_tests() {
     GEODE_ASSERT(!incircle(p0,p1,p2,p3));
     GEODE_ASSERT( incircle(p0,p1,p3,p2));
   }
+
+  // Whenever the floating point filter claims a sign, it must match the exact sign.  Nearly collinear and nearly
+  // cocircular points at all scales make the filter fail often, so both outcomes are exercised.
+  typedef Vector<FloatFilter,2> FV2;
+  typedef Vector<Exact<1>,2> EV2;
+  int decided = 0, undecided = 0;
+  for (int step=0;step<10000;step++) {
+    const int scale = random->uniform<int>(1,exact::log_bound-3);
+    const auto bound = ExactInt(1)<<scale;
+    const auto r = [&](){ return random->uniform<Vector<ExactInt,2>>(-bound,bound); };
+    const auto e = [&](){ return random->uniform<Vector<ExactInt,2>>(-2,3); };
+    const QV2 x0(r()), x1(r());
+    const Quantized t = random->uniform<double>(-1,2);
+    const QV2 x2 = floor(x0+t*(x1-x0))+QV2(e());
+    // Nearly collinear
+    const auto fo = weak_sign(TriangleOriented::eval(FV2(x0),FV2(x1),FV2(x2)));
+    if (fo)
+      GEODE_ASSERT(fo==sign(TriangleOriented::eval(EV2(x0),EV2(x1),EV2(x2))));
+    // Nearly cocircular
+    const Quantized a = random->uniform<double>(0,2*pi);
+    const QV2 x3 = floor(.5*(x0+x1)+.5*magnitude(x1-x0)*QV2(cos(a),sin(a)))+QV2(e()),
+              x4 = floor(.5*(x0+x1)-.5*rotate_left_90(x1-x0))+QV2(e());
+    const auto fi = weak_sign(Incircle::eval(FV2(x0),FV2(x1),FV2(x4),FV2(x3)));
+    if (fi)
+      GEODE_ASSERT(fi==sign(Incircle::eval(EV2(x0),EV2(x1),EV2(x4),EV2(x3))));
+    (fo?decided:undecided)++;
+    (fi?decided:undecided)++;
+  }
+  GEODE_ASSERT(decided && undecided);
+
+  // Batched predicates must agree with their scalar versions, including on degenerate and nearly degenerate input
+  // where the wide filter falls back.  Odd counts exercise the leftover queries after the last full batch.
+  {
+    const auto r2 = [&](const int i, const ExactInt bound) {
+      return P2(i,QV2(random->uniform<Vector<ExactInt,2>>(-bound,bound)));
+    };
+    Array<Vector<P2,3>> tris;
+    Array<Vector<P2,4>> circles;
+    for (int i=0;i<1001;i++) {
+      const auto bound = ExactInt(1)<<random->uniform<int>(1,exact::log_bound);
+      tris.append(vec(r2(4*i,bound),r2(4*i+1,bound),r2(4*i+2,bound)));
+      circles.append(vec(r2(4*i,bound),r2(4*i+1,bound),r2(4*i+2,bound),r2(4*i+3,bound)));
+      if (i%3==0) // Collinear and cocircular
+        tris.back()[2] = P2(4*i+2,tris.back()[0].value());
+      if (i%5==0)
+        circles.back()[3] = P2(4*i+3,circles.back()[1].value());
+    }
+    Array<bool> result(tris.size(),uninit);
+    batch_triangle_oriented(result,tris);
+    for (const int i : range(tris.size()))
+      GEODE_ASSERT(result[i]==triangle_oriented(tris[i][0],tris[i][1],tris[i][2]));
+    batch_incircle(result,circles);
+    for (const int i : range(circles.size()))
+      GEODE_ASSERT(result[i]==incircle(circles[i][0],circles[i][1],circles[i][2],circles[i][3]));
+
+    typedef Vector<Quantized,3> QV3;
+    Array<Vector<P3,5>> segs;
+    for (int i=0;i<1003;i++) {
+      const auto bound = ExactInt(1)<<random->uniform<int>(1,exact::log_bound);
+      Vector<P3,5> q;
+      for (int j=0;j<5;j++)
+        q[j] = P3(5*i+j,QV3(random->uniform<Vector<ExactInt,3>>(-bound,bound)));
+      if (i%4==0) // Segment endpoint on the triangle's plane
+        q[1] = P3(5*i+1,q[2].value());
+      segs.append(q);
+    }
+    Array<Vector<P3,4>> tets;
+    for (const auto& q : segs)
+      tets.append(vec(q[0],q[1],q[2],q[3]));
+    result.resize(segs.size(),uninit);
+    batch_tetrahedron_oriented(result,tets);
+    for (const int i : range(tets.size()))
+      GEODE_ASSERT(result[i]==tetrahedron_oriented(tets[i][0],tets[i][1],tets[i][2],tets[i][3]));
+    batch_segment_triangle_intersect(result,segs);
+    int hits = 0;
+    for (const int i : range(segs.size())) {
+      const auto& q = segs[i];
+      GEODE_ASSERT(result[i]==segment_triangle_intersect(q[0],q[1],q[2],q[3],q[4]));
+      hits += result[i];
+    }
+    GEODE_ASSERT(hits);
+  }
+
+  // Exactly degenerate input is usually resolved inline by the first perturbation level.  Compare against the
+  // general gmp based perturbed_sign.
+  for (int step=0;step<100;step++) {
+    typedef Vector<Quantized,3> QV3;
+    const auto bound = ExactInt(1)<<random->uniform<int>(1,exact::log_bound-2);
+    const QV2 x0(random->uniform<Vector<ExactInt,2>>(-bound,bound)),
+              d(random->uniform<Vector<ExactInt,2>>(-bound,bound));
+    const P2 collinear[3] = {P2(0,x0),P2(1,x0+d),P2(2,x0-d)};
+    GEODE_ASSERT(triangle_oriented(collinear[0],collinear[1],collinear[2])
+                 ==perturbed_sign(wrap_predicate<TriangleOriented,2>(IRange<3>()),2,asarray(collinear)));
+    const P2 cocircular[4] = {P2(0,x0+d),P2(1,x0+rotate_left_90(d)),P2(2,x0-d),P2(3,x0-rotate_left_90(d))};
+    GEODE_ASSERT(incircle(cocircular[0],cocircular[1],cocircular[2],cocircular[3])
+                 ==perturbed_sign(wrap_predicate<Incircle,2>(IRange<4>()),4,asarray(cocircular)));
+    const QV3 z0(random->uniform<Vector<ExactInt,3>>(-bound,bound)),
+              u(random->uniform<Vector<ExactInt,3>>(-bound,bound)),
+              v(random->uniform<Vector<ExactInt,3>>(-bound,bound));
+    const P3 coplanar[4] = {P3(0,z0),P3(1,z0+u),P3(2,z0+v),P3(3,z0-u-v)};
+    GEODE_ASSERT(tetrahedron_oriented(coplanar[0],coplanar[1],coplanar[2],coplanar[3])
+                 ==perturbed_sign(wrap_predicate<TetrahedronOriented,3>(IRange<4>()),3,asarray(coplanar)));
+  }
 }
 
 }
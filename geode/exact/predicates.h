@@ -94,6 +94,17 @@ GEODE_CORE_EXPORT GEODE_PURE bool triangles_oriented(const P3 a0, const P3 a1, c
                                                      const P3 b0, const P3 b1, const P3 b2,
                                                      const P3 c0, const P3 c1, const P3 c2);
 
+/*** Batched predicates ***/
+
+// Evaluate a predicate on many queries at once, setting result[i] to the predicate applied to the entries of
+// queries[i].  Queries are filtered several at a time with wide interval arithmetic (see Intervals.h), and only those
+// the filter cannot decide are evaluated individually.  These must be called within an IntervalScope.
+GEODE_CORE_EXPORT void batch_triangle_oriented(RawArray<bool> result, RawArray<const Vector<P2,3>> queries);
+GEODE_CORE_EXPORT void batch_incircle(RawArray<bool> result, RawArray<const Vector<P2,4>> queries);
+GEODE_CORE_EXPORT void batch_tetrahedron_oriented(RawArray<bool> result, RawArray<const Vector<P3,4>> queries);
+// Each query is (a0,a1,b0,b1,b2)
+GEODE_CORE_EXPORT void batch_segment_triangle_intersect(RawArray<bool> result, RawArray<const Vector<P3,5>> queries);
+
 #undef P3
 #undef P2
 
@@ -0,0 +1,389 @@
+// Quality constrained Delaunay refinement
+
+#include <geode/exact/refine_delaunay.h>
+#include <geode/array/amap.h>
+#include <geode/exact/delaunay.h>
+#include <geode/exact/Exact.h>
+#include <geode/exact/predicates.h>
+#include <geode/exact/scope.h>
+#include <geode/geometry/Box.h>
+#include <geode/python/Class.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/interrupts.h>
+namespace geode {
+
+typedef real T;
+typedef Vector<T,2> TV;
+typedef Vector<Quantized,2> EV;
+using exact::Perturbed2;
+
+// For details, see
+//
+//   Jim Ruppert, "A Delaunay refinement algorithm for quality 2-dimensional mesh generation".
+//   Jonathan Richard Shewchuk, "Delaunay refinement algorithms for triangular mesh generation".
+//
+// Encroached segments are split first.  A bad triangle is then fixed by inserting its circumcenter, unless the
+// circumcenter lies beyond a segment or encroaches upon segments of its insertion cavity, in which case those
+// segments are split instead.  Segments are split at their midpoints, except that a segment with exactly one input
+// endpoint is split at a power of two distance from it (concentric shells), so that splits on segments meeting at a
+// small input angle stay in sync.  Following Shewchuk, we skip triangles whose shortest edge spans two such shells,
+// since no algorithm can improve them.
+//
+// Vertex i has perturbation seed i, so every Steiner point is perturbed consistently before and after insertion.
+// Encroachment and quality are decided in floating point: they affect only where points go, not the validity of
+// the triangulation.  Each Steiner point is rounded to the quantized grid, which may move a segment split point off
+// its segment by half a unit; the subsegments are constrained regardless, and the perturbed predicates keep the
+// triangulation consistent.
+
+GEODE_DEFINE_TYPE(DelaunayRefiner)
+
+// Triangles and segments shorter than this (in quantized units) are never split further.  Since quantized
+// coordinates are 53 bit integers, this is far below any resolution of interest.
+static const T resolution = 1<<10;
+
+// Are three points exactly collinear, ignoring perturbation?
+static bool flat(const EV a, const EV b, const EV c) {
+  const auto d = [](const Quantized x, const Quantized y) { return Exact<1>(ExactInt(x)-ExactInt(y)); };
+  return !is_nonzero(d(b.x,a.x)*d(c.y,a.y)-d(b.y,a.y)*d(c.x,a.x));
+}
+
+DelaunayRefiner::DelaunayRefiner(RawArray<const TV> X, RawArray<const Vector<int,2>> edges)
+  : quant(quantizer(bounding_box(X)))
+  , mesh(exact_delaunay_points(amap(quant,X).copy(),edges)->mutate())
+  , n_input(X.size())
+  , X(amap(quant,X).copy())
+  , parent(X.size()) {
+  // Collinear points on the convex hull produce flat triangles, which no Steiner point can fix.  Peel them off.
+  for (;;) {
+    Array<FaceId> peel;
+    for (const auto e : mesh->boundary_edges()) {
+      const auto f = mesh->face(mesh->reverse(e));
+      const auto v = mesh->vertices(f);
+      if (flat(this->X[v.x.id],this->X[v.y.id],this->X[v.z.id]))
+        peel.append(f);
+    }
+    if (!peel.size())
+      break;
+    for (const auto f : peel)
+      if (!mesh->erased(f))
+        mesh->erase(f);
+  }
+  mesh->collect_garbage();
+  for (const auto e : edges)
+    segments.set(vec(VertexId(e.x),VertexId(e.y)).sorted());
+  for (const auto e : mesh->boundary_edges())
+    segments.set(mesh->vertices(e).sorted());
+}
+
+DelaunayRefiner::~DelaunayRefiner() {}
+
+Array<TV> DelaunayRefiner::positions() const {
+  return amap(quant.inverse,X).copy();
+}
+
+Array<Vector<int,2>> DelaunayRefiner::constraint_edges() const {
+  Array<Vector<int,2>> edges;
+  for (const auto s : segments)
+    edges.append(vec(s.x.id,s.y.id));
+  return edges;
+}
+
+struct DelaunayRefiner::Refine {
+  DelaunayRefiner& self;
+  MutableTriangleTopology& mesh;
+  const T sin_min_angle, max_area;
+  Array<Vector<VertexId,2>> bad_segments; // Possibly encroached segments, sorted
+  Array<Vector<VertexId,3>> bad_faces; // Possibly bad triangles
+  Array<Vector<VertexId,2>> flips; // Directed link edges to check during insertion
+  int inserted;
+
+  Refine(DelaunayRefiner& self, const T min_angle, const T max_area)
+    : self(self), mesh(self.mesh), sin_min_angle(sin(min_angle))
+    , max_area(sqr(self.quant.scale)*max_area), inserted(0) {}
+
+  Perturbed2 P(const VertexId v) const {
+    return Perturbed2(v.id,self.X[v.id]);
+  }
+
+  TV x(const VertexId v) const {
+    return TV(self.X[v.id]);
+  }
+
+  bool is_segment(const VertexId a, const VertexId b) const {
+    return self.segments.contains(vec(a,b).sorted());
+  }
+
+  // Is c strictly inside the diametral circle of (a,b)?
+  bool encroaches(const TV c, const VertexId a, const VertexId b) const {
+    return dot(x(a)-c,x(b)-c) < 0;
+  }
+
+  // Is segment (a,b) encroached by the apex of either adjacent triangle?
+  bool encroached(const Vector<VertexId,2> s) const {
+    const auto e = mesh.halfedge(s.x,s.y);
+    if (!e.valid())
+      return false;
+    for (const auto h : vec(e,mesh.reverse(e)))
+      if (!mesh.is_boundary(h) && encroaches(x(mesh.dst(mesh.next(h))),s.x,s.y))
+        return true;
+    return false;
+  }
+
+  // The input segment containing a vertex, or an invalid pair for free vertices
+  Vector<VertexId,2> input_segment(const VertexId v) const {
+    return v.id<self.n_input ? Vector<VertexId,2>() : self.parent[v.id];
+  }
+
+  bool is_bad(const Vector<VertexId,3> f) const {
+    const TV x0 = x(f.x), x1 = x(f.y), x2 = x(f.z);
+    const T area2 = cross(x1-x0,x2-x0);
+    Vector<T,3> sqr_lengths(sqr_magnitude(x2-x1),sqr_magnitude(x0-x2),sqr_magnitude(x1-x0));
+    const int i = sqr_lengths.argmin();
+    if (area2<=0 || sqr_lengths[i] < sqr(resolution))
+      return false;
+    // The smallest angle is opposite the shortest edge
+    const T sin_angle_sqr = sqr(area2)/(sqr_lengths[(i+1)%3]*sqr_lengths[(i+2)%3]);
+    if (sin_angle_sqr >= sqr(sin_min_angle) && area2 <= 2*max_area)
+      return false;
+    // If the shortest edge joins two segments at matching shells about a shared input vertex, leave it alone
+    const auto a = f[(i+1)%3], b = f[(i+2)%3];
+    const auto sa = input_segment(a), sb = input_segment(b);
+    if (sa.x.valid() && sb.x.valid() && sa!=sb) {
+      for (const auto o : sa)
+        if (sb.contains(o)) {
+          const T da = magnitude(x(a)-x(o)),
+                  db = magnitude(x(b)-x(o));
+          if (abs(da-db) <= .01*max(da,db))
+            return false;
+        }
+    }
+    return true;
+  }
+
+  void check_face(const FaceId f) {
+    const auto vs = mesh.vertices(f);
+    if (is_bad(vs))
+      bad_faces.append(vs);
+    for (const int i : range(3)) {
+      const auto s = vec(vs[i],vs[(i+1)%3]).sorted();
+      if (self.segments.contains(s) && encroached(s))
+        bad_segments.append(s);
+    }
+  }
+
+  // Restore the constrained Delaunay property around a new vertex by flipping, then queue anything it broke
+  void finish_insert(const VertexId v) {
+    flips.clear();
+    for (const auto e : mesh.outgoing(v))
+      if (!mesh.is_boundary(e))
+        flips.append(mesh.vertices(mesh.next(e)));
+    while (flips.size()) {
+      const auto ab = flips.pop();
+      const auto e = mesh.halfedge(ab.x,ab.y);
+      if (!e.valid() || is_segment(ab.x,ab.y))
+        continue;
+      const auto r = mesh.reverse(e);
+      if (mesh.is_boundary(r))
+        continue;
+      const auto d = mesh.dst(mesh.next(r));
+      if (!incircle(P(ab.x),P(ab.y),P(v),P(d)))
+        continue;
+      // Our mesh is linearly embedded in the plane, so edge flips are always safe
+      GEODE_UNUSED const auto flipped = mesh.unsafe_flip_edge(e);
+      flips.append(vec(ab.x,d));
+      flips.append(vec(d,ab.y));
+    }
+    for (const auto e : mesh.outgoing(v))
+      if (!mesh.is_boundary(e))
+        check_face(mesh.face(e));
+    inserted++;
+  }
+
+  VertexId new_vertex(const EV c) {
+    const auto v = mesh.add_vertex();
+    GEODE_ASSERT(v.id==self.X.size());
+    self.X.append(c);
+    self.parent.append(Vector<VertexId,2>());
+    return v;
+  }
+
+  // Split a segment, returning true if successful
+  bool split_segment(const Vector<VertexId,2> s) {
+    const auto e = mesh.halfedge(s.x,s.y);
+    if (!e.valid() || !self.segments.contains(s) || sqr_magnitude(x(s.y)-x(s.x)) < sqr(4*resolution))
+      return false;
+
+    // Split at the midpoint, or at a power of two shell around a lone input endpoint
+    const bool in0 = s.x.id<self.n_input,
+               in1 = s.y.id<self.n_input;
+    auto o = s.x, w = s.y;
+    T t = .5;
+    if (in0 != in1) {
+      if (in1)
+        swap(o,w);
+      const T length = magnitude(x(w)-x(o));
+      t = exp2(round(log2(.5*length)))/length;
+    }
+    const TV m = x(o)+t*(x(w)-x(o));
+    const EV c(round(m.x),round(m.y));
+    const Perturbed2 pc(self.X.size(),c);
+
+    // The rounded point may have moved off the segment, so make sure both sides stay positively oriented
+    for (const auto h : vec(e,mesh.reverse(e)))
+      if (!mesh.is_boundary(h)) {
+        const auto a = mesh.src(h), b = mesh.dst(h), d = mesh.dst(mesh.next(h));
+        if (!triangle_oriented(P(a),pc,P(d)) || !triangle_oriented(pc,P(b),P(d)))
+          return false;
+      }
+
+    const auto v = new_vertex(c);
+    self.parent[v.id] = input_segment(s.x).x.valid() ? input_segment(s.x)
+                      : input_segment(s.y).x.valid() ? input_segment(s.y)
+                                                     : s;
+    mesh.split_edge(e,v);
+    self.segments.erase(s);
+    self.segments.set(vec(s.x,v).sorted());
+    self.segments.set(vec(v,s.y).sorted());
+    finish_insert(v);
+    return true;
+  }
+
+  // Walk from f towards c.  Returns the face containing c, or a segment blocking the way, or neither on failure.
+  Tuple<FaceId,Vector<VertexId,2>> locate(FaceId f, const Perturbed2 c) const {
+    HalfedgeId from;
+    for (int step=0;step<=mesh.n_faces();step++) {
+      const auto es = mesh.halfedges(f);
+      for (const int k : range(3)) {
+        const auto e = es[(k+step)%3];
+        if (e==from)
+          continue;
+        const auto a = mesh.src(e), b = mesh.dst(e);
+        if (!triangle_oriented(P(a),P(b),c)) {
+          if (is_segment(a,b))
+            return tuple(FaceId(),vec(a,b).sorted());
+          from = mesh.reverse(e);
+          f = mesh.face(from);
+          goto next;
+        }
+      }
+      return tuple(f,Vector<VertexId,2>());
+      next:;
+    }
+    return tuple(FaceId(),Vector<VertexId,2>());
+  }
+
+  // Try to fix a bad triangle.  Returns true if something was inserted.
+  bool fix(const Vector<VertexId,3> vs) {
+    const auto e = mesh.halfedge(vs.x,vs.y);
+    if (!e.valid() || mesh.is_boundary(e) || mesh.dst(mesh.next(e))!=vs.z || !is_bad(vs))
+      return false;
+
+    // Compute the circumcenter and round to the quantized grid
+    const TV x0 = x(vs.x), b = x(vs.y)-x0, c = x(vs.z)-x0;
+    const T d = 2*cross(b,c);
+    const TV u = x0+TV(c.y*sqr_magnitude(b)-b.y*sqr_magnitude(c),b.x*sqr_magnitude(c)-c.x*sqr_magnitude(b))/d;
+    const T limit = T(exact::bound);
+    const EV center(clamp(round(u.x),-limit,limit),clamp(round(u.y),-limit,limit));
+    const Perturbed2 pc(self.X.size(),center);
+
+    // Circumcenters beyond a segment split that segment instead
+    const auto found = locate(mesh.face(e),pc);
+    if (!found.x.valid())
+      return found.y.x.valid() && split_segment(found.y);
+    const auto fvs = mesh.vertices(found.x);
+    for (const auto v : fvs)
+      if (self.X[v.id]==center)
+        return false;
+
+    // Circumcenters which encroach upon segments of their cavity split those segments instead
+    const TV cx(center);
+    Array<FaceId> cavity(1,uninit);
+    cavity[0] = found.x;
+    Hashtable<FaceId> seen;
+    seen.set(found.x);
+    Array<Vector<VertexId,2>> blocking;
+    for (int i=0;i<cavity.size();i++)
+      for (const auto h : mesh.halfedges(cavity[i])) {
+        const auto a = mesh.src(h), b = mesh.dst(h);
+        if (is_segment(a,b)) {
+          if (encroaches(cx,a,b))
+            blocking.append(vec(a,b).sorted());
+          continue;
+        }
+        const auto r = mesh.reverse(h);
+        if (!mesh.is_boundary(r) && !seen.contains(mesh.face(r))) {
+          const auto rv = mesh.vertices(mesh.face(r));
+          if (incircle(P(rv.x),P(rv.y),P(rv.z),pc)) {
+            seen.set(mesh.face(r));
+            cavity.append(mesh.face(r));
+          }
+        }
+      }
+    if (blocking.size()) {
+      bool split = false;
+      for (const auto s : blocking)
+        split |= split_segment(s);
+      return split;
+    }
+
+    // Insert the circumcenter
+    const auto v = new_vertex(center);
+    mesh.split_face(found.x,v);
+    finish_insert(v);
+    return true;
+  }
+
+  void run() {
+    IntervalScope scope;
+    for (const auto s : self.segments)
+      if (encroached(s))
+        bad_segments.append(s);
+    for (const auto f : mesh.faces())
+      check_face(f);
+    for (;;) {
+      check_interrupts();
+      // Split encroached segments first
+      if (bad_segments.size()) {
+        const auto s = bad_segments.pop();
+        if (self.segments.contains(s) && encroached(s))
+          split_segment(s);
+      } else if (bad_faces.size()) {
+        const auto vs = bad_faces.pop();
+        if (fix(vs))
+          bad_faces.append(vs);
+      } else
+        break;
+    }
+  }
+};
+
+int DelaunayRefiner::refine(const T min_angle, const T max_area) {
+  GEODE_ASSERT(0<=min_angle && min_angle<pi/3,"DelaunayRefiner::refine: min_angle must be in [0,pi/3)");
+  GEODE_ASSERT(max_area>0);
+  Refine r(*this,min_angle,max_area);
+  r.run();
+  return r.inserted;
+}
+
+Tuple<Ref<const TriangleTopology>,Array<const TV>>
+refine_delaunay(RawArray<const TV> X, RawArray<const Vector<int,2>> edges, const T min_angle, const T max_area) {
+  const auto refiner = new_<DelaunayRefiner>(X,edges);
+  refiner->refine(min_angle,max_area);
+  return tuple(Ref<const TriangleTopology>(refiner->mesh),Array<const TV>(refiner->positions()));
+}
+
+}
+using namespace geode;
+
+void wrap_refine_delaunay() {
+  typedef DelaunayRefiner Self;
+  Class<Self>("DelaunayRefiner")
+    .GEODE_INIT(RawArray<const TV>,RawArray<const Vector<int,2>>)
+    .GEODE_FIELD(mesh)
+    .GEODE_FIELD(n_input)
+    .GEODE_METHOD(refine)
+    .GEODE_METHOD(positions)
+    .GEODE_METHOD(constraint_edges)
+    ;
+  GEODE_FUNCTION_2(refine_delaunay_py,refine_delaunay)
+}
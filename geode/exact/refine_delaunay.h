@@ -0,0 +1,59 @@
+// Quality constrained Delaunay refinement
+#pragma once
+
+#include <geode/exact/config.h>
+#include <geode/exact/quantize.h>
+#include <geode/mesh/TriangleTopology.h>
+#include <geode/structure/Hashtable.h>
+namespace geode {
+
+// DelaunayRefiner owns a constrained Delaunay triangulation and inserts Steiner points in place until all
+// triangles satisfy a minimum angle and maximum area bound, following Ruppert's algorithm with Shewchuk's
+// concentric shell segment splitting.  The edges of the convex hull are treated as segments.  Points are located by
+// walking from the offending triangle, and all topological decisions use the same exact perturbed predicates as
+// delaunay_points, so refine may be called repeatedly with tighter bounds without rebuilding the triangulation.
+//
+// Termination is guaranteed for min_angle up to about 20.7 degrees (asin(1/(2 sqrt 2))), and bounds up to about
+// 33 degrees almost always succeed in practice.  Triangles which cannot be improved due to small input angles or the
+// quantization resolution are left alone.
+class DelaunayRefiner : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef real T;
+  typedef Vector<T,2> TV;
+  typedef Vector<Quantized,2> EV;
+
+  const Quantizer<T,2> quant;
+  const Ref<MutableTriangleTopology> mesh;
+  const int n_input; // Vertices below n_input are input points, and later ones are Steiner points
+  Array<EV> X; // Quantized vertex positions
+  Array<Vector<VertexId,2>> parent; // For Steiner points on segments, the input segment containing them
+  Hashtable<Vector<VertexId,2>> segments; // Sorted constrained edges, including the convex hull
+
+protected:
+  // If two edges intersect, DelaunayConstraintConflict is thrown as in delaunay_points.
+  GEODE_CORE_EXPORT DelaunayRefiner(RawArray<const TV> X, RawArray<const Vector<int,2>> edges);
+public:
+  ~DelaunayRefiner();
+
+  // Insert Steiner points until every triangle has minimum angle at least min_angle (in radians) and area at most
+  // max_area.  Returns the number of points inserted.
+  GEODE_CORE_EXPORT int refine(const T min_angle, const T max_area=inf);
+
+  // Unquantized vertex positions
+  GEODE_CORE_EXPORT Array<TV> positions() const;
+
+  // The current constrained edges, split by any Steiner points
+  GEODE_CORE_EXPORT Array<Vector<int,2>> constraint_edges() const;
+
+private:
+  struct Refine;
+};
+
+// Triangulate and refine a point set with optional constraint edges.  See DelaunayRefiner for details.
+GEODE_CORE_EXPORT Tuple<Ref<const TriangleTopology>,Array<const Vector<real,2>>>
+refine_delaunay(RawArray<const Vector<real,2>> X, RawArray<const Vector<int,2>> edges,
+                const real min_angle, const real max_area=inf);
+
+}
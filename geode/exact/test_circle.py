@@ -381,6 +381,70 @@ def test_negative_offsets(seed=7056389):
   unit_circle = to_arcs([[((1.,0.),1.),((-1.,0.),1.)]]) # Unit circle
   check_negative_offsets(unit_circle)
 
+def test_arc_csg():
+  random.seed(18311)
+  arcs0 = circle_arc_union(random_circle_arcs(10,5))
+  arcs1 = circle_arc_union(random_circle_arcs(10,5))
+  csg = ArcCSG(Box((-20,-20),(20,20)))
+  a = csg.add(arcs0)
+  b = csg.add(arcs1)
+  assert allclose(circle_arc_area(csg.arcs(a)),circle_arc_area(arcs0))
+  assert allclose(circle_arc_area(csg.arcs(csg.union(a,b))),circle_arc_area(circle_arc_union(arcs0,arcs1)))
+  assert allclose(circle_arc_area(csg.arcs(csg.intersection(a,b))),circle_arc_area(circle_arc_intersection(arcs0,arcs1)))
+  assert allclose(circle_arc_area(csg.arcs(csg.difference(a,b)))+circle_arc_area(csg.arcs(b)),
+                  circle_arc_area(csg.arcs(csg.union(a,b))))
+  for d in .2,-.1:
+    assert allclose(circle_arc_area(csg.arcs(csg.offset(a,d))),circle_arc_area(offset_arcs(arcs0,d)))
+  # Repeating an offset reuses all cached intersections
+  pairs = csg.n_intersected_pairs
+  csg.offset(a,.2)
+  assert csg.n_intersected_pairs==pairs
+  # Releasing everything but a drops circles and intersections only the released shapes used
+  circles = csg.n_circles
+  for s in xrange(csg.n_shapes):
+    if s!=a:
+      csg.release(s)
+  assert csg.n_circles<circles and csg.n_intersected_pairs<pairs
+  assert allclose(circle_arc_area(csg.arcs(a)),circle_arc_area(arcs0))
+  assert allclose(circle_arc_area(csg.arcs(csg.offset(a,.2))),circle_arc_area(offset_arcs(arcs0,.2)))
+  for bad in lambda:csg.arcs(b),lambda:csg.offset(a,30):
+    try:
+      bad()
+      failed = False
+    except AssertionError:
+      failed = True
+    assert failed
+
+def test_offset_shell_components():
+  random.seed(7113)
+  arcs = circle_arc_union(random_circle_arcs(10,10))
+  d = -.05
+  shells = offset_shells(arcs,d,-1)
+  flat,components = offset_shell_components(arcs,d,-1)
+  assert len(flat)==len(shells) and len(components)>1
+  for shell,ref in zip(flat,shells):
+    assert allclose(circle_arc_area(shell),circle_arc_area(ref))
+  # Components tile each flat shell, and start right after their parent ends
+  areas = zeros(len(flat))
+  for parent,first,chain in components:
+    assert parent<0 or components[parent][1]+len(components[parent][2])==first
+    for i,shell in enumerate(chain):
+      areas[first+i] += circle_arc_area(shell)
+  assert allclose(areas,map(circle_arc_area,flat))
+  assert len(offset_shell_components(arcs,d,3)[0])==3
+
+def test_simplify_closed_arcs():
+  random.seed(9131)
+  arcs = plain = circle_arc_union(random_circle_arcs(10,10))
+  for i in xrange(8):
+    d = (.1,-.07,.05,-.08)[i%4]
+    plain = offset_arcs(plain,d)
+    arcs = simplify_closed_arcs(offset_arcs(arcs,d),1e-4)
+    # Simplification never introduces overlaps, so the result is its own union
+    assert allclose(circle_arc_area(circle_arc_union(arcs)),circle_arc_area(arcs))
+    assert allclose(circle_arc_area(arcs),circle_arc_area(plain),atol=1e-3)
+  assert len(arcs.flat) < len(plain.flat)
+
 # Endlessly test offset code for different pseudo-random circle arcs
 def fuzz_offsets():
   # Start with an actually random seed so that multiple tests aren't redundant
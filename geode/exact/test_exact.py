@@ -56,6 +56,145 @@ def test_delaunay(benchmark=False,cgal=False,origin=True,circle=False,constrain=
             if n>0 and mesh.n_faces!=nf:
               Log.write('expected %d faces, got %d'%(mesh.n_faces,nf))
 
+def test_delaunay_parallel():
+  def faces(mesh):
+    tris = mesh.elements()
+    # Rotate each triangle to start at its smallest vertex, then sort
+    tris = asarray([roll(t,-argmin(t)) for t in tris])
+    return tris[lexsort(tris.T[::-1])]
+  random.seed(7)
+  grid = asarray([(i,j) for i in range(40) for j in range(40)],dtype=float)
+  for name,X in ('gaussian',random.randn(5000,2)),('grid',grid),('origin',zeros((1000,2))):
+    serial = delaunay_points(X)
+    parallel = delaunay_points(X,validate=True,parallel=True)
+    parallel.assert_consistent(True)
+    assert all(faces(serial)==faces(parallel)),name
+
+def test_refine_delaunay():
+  def angles(mesh,X):
+    tris = X[mesh.elements()]
+    e = tris[:,[1,2,0]]-tris
+    cos = -(e*e[:,[2,0,1]]).sum(axis=-1)/sqrt((e*e).sum(axis=-1)*(e[:,[2,0,1]]**2).sum(axis=-1))
+    return arccos(clip(cos,-1,1)).min(axis=-1)
+  def areas(mesh,X):
+    tris = X[mesh.elements()]
+    return cross(tris[:,1]-tris[:,0],tris[:,2]-tris[:,0])/2
+  random.seed(3)
+  square = asarray([(0,0),(1,0),(1,1),(0,1)],dtype=float)
+  t = 2*pi*arange(20)/20
+  loop = .5+.2*(1+.3*sin(3*t))[:,None]*polar(t)
+  X = concatenate([square,loop,random.uniform(0,1,(30,2))])
+  edges = concatenate([[(i,(i+1)%4) for i in range(4)],[(4+i,4+(i+1)%20) for i in range(20)]]).astype(int32)
+  for min_angle in pi/180*asarray([20,25,30]):
+    mesh,Y = refine_delaunay(X,edges,min_angle)
+    mesh.assert_consistent(True)
+    assert allclose(Y[:len(X)],X)
+    assert angles(mesh,Y).min()>=min_angle*(1-1e-6)
+    assert all(areas(mesh,Y)>0)
+    assert allclose(areas(mesh,Y).sum(),1)
+
+  # Repeated refinement of the same triangulation
+  refiner = DelaunayRefiner(X,edges)
+  total = 0
+  for max_area in 1e-2,1e-3,1e-4:
+    total += refiner.refine(pi/8,max_area)
+    mesh,Y = refiner.mesh,refiner.positions()
+    assert mesh.n_vertices==len(X)+total==len(Y)
+    assert angles(mesh,Y).min()>=pi/8*(1-1e-6)
+    assert areas(mesh,Y).max()<=max_area*(1+1e-6)
+  # The split constraint edges still bound the loop
+  E = refiner.constraint_edges()
+  assert len(E)>len(edges)
+
+def test_point_locator():
+  random.seed(5)
+  X = random.uniform(0,1,(2000,2))
+  mesh = delaunay_points(X)
+  locator = PointLocator(mesh,X)
+  assert locator.convex
+  Q = concatenate([random.uniform(-.2,1.2,(10000,2)),X[:100]])
+  faces,weights = locator.locate_barycentric(Q)
+  inside = faces>=0
+  assert all(inside[-100:])
+  assert all(weights[inside]>=-1e-10)
+  assert allclose(weights[inside].sum(axis=-1),1)
+  assert all(weights[~inside]==0)
+  assert all(faces==[locator.locate_point(q) for q in Q])
+  # Points outside the convex hull are not found
+  tris = X[mesh.elements()]
+  def strictly_inside(q):
+    e = tris[:,[1,2,0]]-tris
+    return (cross(e,q-tris)>1e-10).all(axis=-1).any()
+  for q in Q[~inside][:200]:
+    assert not strictly_inside(q)
+
+def test_collision_detector():
+  # A small triangle above a large one, and a vertical triangle whose bottom edge straddles it
+  mesh = TriangleTopology([(0,1,2),(3,4,5),(6,7,8)])
+  X = asarray([(0,0,0),(1,0,0),(0,1,0),
+               (.2,.2,1),(.3,.2,1),(.2,.3,1),
+               (.5,-1,.5),(.5,2,.5),(.5,.5,1.5)])
+  down = X.copy()
+  down[3:,2] -= 1.1
+  detector = CollisionDetector(mesh,X,X)
+  assert not len(detector.edge_edge_collisions())
+  assert not len(detector.vertex_face_collisions()[0])
+  # Moving both upper triangles down passes the small one through the large one, and the straddling edge across two edges
+  detector.update(X,down)
+  def edge(h):
+    return tuple(sorted(mesh.halfedge_vertices(h)))
+  ee = sorted(tuple(sorted(map(edge,p))) for p in detector.edge_edge_collisions())
+  assert ee==[((0,1),(6,7)),((1,2),(6,7))]
+  vertices,faces = detector.vertex_face_collisions()
+  assert sorted(zip(vertices,faces))==[(3,0),(4,0),(5,0)]
+  # Moving back up finds the same collisions
+  detector.update(down,X)
+  assert len(detector.edge_edge_collisions())==2
+  assert len(detector.vertex_face_collisions()[0])==3
+
+def test_collision_detector_brute_force():
+  # Compare against testing all pairs on a randomly deforming grid, refitting each step, for several thread counts
+  from geode.geometry.platonic import grid_topology
+  random.seed(8131)
+  n = 8
+  mesh = TriangleTopology(grid_topology(n-1,n-1).elements)
+  i,j = divmod(arange(n*n),n)
+  X = [asarray([i,j,.3*random.randn(n*n)]).T.copy()]
+  for step in xrange(4):
+    X.append(X[-1]+.5*random.randn(n*n,3))
+  detector = CollisionDetector(mesh,X[0],X[0])
+  edges = [(h,tuple(mesh.halfedge_vertices(h))) for h in detector.edges]
+  faces = [(f,tuple(mesh.face_vertices(f))) for f in detector.faces]
+  def brute_force(X0,X1):
+    ee = []
+    for k,(h0,e0) in enumerate(edges):
+      for h1,e1 in edges[k+1:]:
+        if not set(e0)&set(e1) and edge_edge_collision_parity(*[Y[v] for Y in (X0,X1) for v in e0+e1]):
+          ee.append((min(h0,h1),max(h0,h1)))
+    vf = [(v,f) for v in detector.vertices for f,t in faces
+          if v not in t and point_triangle_collision_parity(*[Y[u] for Y in (X0,X1) for u in (v,)+t])]
+    return sorted(ee),sorted(vf)
+  expected = [brute_force(X[s],X[s+1]) for s in xrange(len(X)-1)]
+  assert all(len(ee) and len(vf) for ee,vf in expected[1:])
+  threads = omp_max_threads()
+  try:
+    results = []
+    for nt in 1,2,4:
+      set_omp_max_threads(nt)
+      detector = CollisionDetector(mesh,X[0],X[1])
+      found = []
+      for s,(ee,vf) in enumerate(expected):
+        if s:
+          detector.update(X[s],X[s+1])
+        found.append((map(tuple,detector.edge_edge_collisions()),zip(*detector.vertex_face_collisions())))
+        assert sorted(found[-1][0])==ee
+        assert sorted(found[-1][1])==vf
+      results.append(found)
+    # Results come back in the same order for every thread count
+    assert results[0]==results[1]==results[2]
+  finally:
+    set_omp_max_threads(threads)
+
 def draw_polygons(polys):
   import pylab
   for p,points in enumerate(polys):
@@ -101,6 +240,17 @@ def test_polygon():
       print 'error = %g'%error
       assert False
 
+def test_polygon_parallel():
+  random.seed(8271)
+  n,k = 3000,6
+  polys = 10*random.rand(n,1,2)+polar(sort(random.uniform(2*pi,size=n*k).reshape(n,k),axis=1))*abs(random.randn(n,k,1))/4
+  polys = Nested.concatenate(polys)
+  for depth in 0,1,2:
+    serial = split_polygons(polys,depth)
+    parallel = split_polygons(polys,depth,parallel=True)
+    assert all(serial.offsets==parallel.offsets)
+    assert all(canonicalize_polygons(serial).flat==canonicalize_polygons(parallel).flat)
+
 if __name__=='__main__':
   Log.configure('exact tests',0,0,100)
   if '-i' in sys.argv:
@@ -53,6 +53,42 @@ def test_csg():
           assert allclose(Is[name],Is[name[4:]])
   print('Success!')
 
+def test_csg_deterministic():
+  # Faces are split in parallel, but vertex numbering must not depend on the number of threads
+  sphere,X = sphere_mesh(3)
+  meshes = [(sphere,X+.4*k) for k in xrange(3)]
+  threads = omp_max_threads()
+  try:
+    set_omp_max_threads(1)
+    m0,Z0 = split_soups(meshes,depth=None)
+    for n in 2,4,max(8,threads):
+      set_omp_max_threads(n)
+      m1,Z1 = split_soups(meshes,depth=None)
+      assert all(m0.elements==m1.elements)
+      assert all(Z0==Z1)
+  finally:
+    set_omp_max_threads(threads)
+
+def test_csg_session():
+  # Incremental CSG should agree with resplitting everything after each operation
+  random.seed(71)
+  sphere,X = sphere_mesh(3)
+  tool,Y = sphere_mesh(2)
+  session = MeshCSGSession(sphere,X,Box(-2*ones(3),2*ones(3)))
+  m,Z = sphere,X
+  for i in xrange(8):
+    W = .3*Y+.8*random.randn(3)/sqrt(3)
+    if i%3==2:
+      session.add(tool,W)
+      m,Z = soup_union((m,Z),(tool,W))
+    else:
+      session.subtract(tool,W)
+      m,Z = soup_union((m,Z),(TriangleSoup(tool.elements[:,::-1].copy()),W))
+    s,S = session.soup()
+    assert s.nodes()==len(S)
+    assert not len(s.boundary_mesh().elements)
+    assert allclose(mesh_signature(s,S),mesh_signature(m,Z),atol=1e-6)
+
 def test_depth_weight():
   tet,X0 = tetrahedron_mesh()
   X0 *= tet.volume(X0)**(-1/3)
@@ -8,6 +8,7 @@
 #include <geode/geometry/Box.h>
 #include <geode/geometry/Sphere.h>
 #include <geode/geometry/traverse.h>
+#include <geode/math/constants.h>
 #include <geode/math/integer_log.h>
 #include <geode/python/Class.h>
 namespace geode {
@@ -52,8 +53,66 @@ Array<const Range<int>> ranges(int prims, int leaf_size) {
   return ranges;
 }
 
+// Subtrees with at least this many primitives are built as separate tasks
+const int parallel_build_threshold = 1<<14;
+
+// Bins per axis for the surface area heuristic
+const int sah_bins = 16;
+
+template<class T> inline T sah_area(const Box<Vector<T,2>>& box) {
+  const auto s = box.sizes();
+  return s.x+s.y;
+}
+
+template<class T> inline T sah_area(const Box<Vector<T,3>>& box) {
+  return box.surface_area();
+}
+
+template<class TV> inline TV split_center(const TV& x) { return x; }
+template<class TV> inline TV split_center(const Box<TV>& box) { return box.center(); }
+
+// Pick the split axis minimizing the binned surface area heuristic, given that the first left primitives
+// (in axis order) go to the left child.  Bins straddling the split contribute to both sides.
+template<class Geo,class TV> int
+sah_axis(RawArray<const Geo> geo, RawArray<const int> p, const int left, const Box<TV>& box) {
+  typedef typename TV::Scalar T;
+  Box<TV> centers;
+  for (const int i : p)
+    centers.enlarge(split_center(geo[i]));
+  int best_axis = box.sizes().argmax();
+  T best_cost = inf;
+  for (int axis=0;axis<TV::m;axis++) {
+    const T lo = centers.min[axis],
+            size = centers.max[axis]-lo;
+    if (!(size>0))
+      continue;
+    const T scale = sah_bins/size;
+    int counts[sah_bins] = {0};
+    Box<TV> bins[sah_bins];
+    for (const int i : p) {
+      const int b = min(sah_bins-1,int(scale*(split_center(geo[i])[axis]-lo)));
+      counts[b]++;
+      bins[b].enlarge(geo[i]);
+    }
+    // Find the bin containing the split
+    int split = 0;
+    for (int count=counts[0];count<left;count+=counts[++split]);
+    Box<TV> lo_box, hi_box;
+    for (int b=0;b<=split;b++)
+      lo_box.enlarge(bins[b]);
+    for (int b=split;b<sah_bins;b++)
+      hi_box.enlarge(bins[b]);
+    const T cost = left*sah_area(lo_box)+(p.size()-left)*sah_area(hi_box);
+    if (best_cost>cost) {
+      best_cost = cost;
+      best_axis = axis;
+    }
+  }
+  return best_axis;
+}
+
 template<class Geo,class TV> void
-build(BoxTree<TV>& self, RawArray<const Range<int>> ranges, RawArray<const Geo> geo, int node) {
+build(BoxTree<TV>& self, RawArray<const Range<int>> ranges, RawArray<const Geo> geo, const BoxTreeSplit split, int node) {
   // Compute box
   const auto r = ranges[node];
   Box<TV>& box = self.boxes[node];
@@ -61,17 +120,38 @@ build(BoxTree<TV>& self, RawArray<const Range<int>> ranges, RawArray<const Geo>
   for (int i=r.lo+1;i<r.hi;i++)
     box.enlarge_nonempty(geo[self.p[i]]);
 
-  // Recursively split along largest axis if necessary
+  // Recursively split if necessary
   if (self.is_leaf(node))
     sort(self.p.slice(r.lo,r.hi).const_cast_());
   else {
-    const int axis = box.sizes().argmax();
+    const int mid = ranges[2*node+1].hi;
+    const int axis = split==BoxTreeSplit::sah ? sah_axis(geo,self.p.slice(r.lo,r.hi),mid-r.lo,box)
+                                              : box.sizes().argmax();
     int* pp = const_cast<int*>(self.p.data());
-    std::nth_element(pp+r.lo,
-                     pp+ranges[2*node+1].hi,
-                     pp+r.hi,indirect_comparison(geo,CenterCompare(axis)));
-    build(self,ranges,geo,2*node+1);
-    build(self,ranges,geo,2*node+2);
+    std::nth_element(pp+r.lo,pp+mid,pp+r.hi,indirect_comparison(geo,CenterCompare(axis)));
+    if (r.size()>=parallel_build_threshold) {
+      // Children touch disjoint slices of p and disjoint subtrees of boxes, so they can be built concurrently
+      #pragma omp task shared(self)
+      build(self,ranges,geo,split,2*node+1);
+      build(self,ranges,geo,split,2*node+2);
+      #pragma omp taskwait
+    } else {
+      build(self,ranges,geo,split,2*node+1);
+      build(self,ranges,geo,split,2*node+2);
+    }
+  }
+}
+
+template<class Geo,class TV> void
+build(BoxTree<TV>& self, RawArray<const Geo> geo, const BoxTreeSplit split) {
+  if (!self.leaves.size())
+    return;
+  if (geo.size()<parallel_build_threshold)
+    build(self,self.ranges,geo,split,0);
+  else {
+    #pragma omp parallel
+    #pragma omp single
+    build(self,self.ranges,geo,split,0);
   }
 }
 
@@ -97,7 +177,7 @@ static inline Range<int> leaf_range(int prims, int leaf_size) {
   return range(leaves-1,2*leaves-1);
 }
 
-template<class TV> BoxTree<TV>::BoxTree(RawArray<const TV> geo, const int leaf_size)
+template<class TV> BoxTree<TV>::BoxTree(RawArray<const TV> geo, const int leaf_size, const BoxTreeSplit split)
   : leaf_size(check_leaf_size(leaf_size))
   , leaves(leaf_range(geo.size(),leaf_size))
   , depth(geode::depth(leaves.size()))
@@ -105,11 +185,10 @@ template<class TV> BoxTree<TV>::BoxTree(RawArray<const TV> geo, const int leaf_s
   , ranges(geode::ranges(geo.size(),leaf_size))
   , boxes(max(0,leaves.hi),uninit)
 {
-  if (leaves.size())
-    build(*this,ranges,geo,0);
+  build(*this,geo,split);
 }
 
-template<class TV> BoxTree<TV>::BoxTree(RawArray<const Box<TV>> geo, const int leaf_size)
+template<class TV> BoxTree<TV>::BoxTree(RawArray<const Box<TV>> geo, const int leaf_size, const BoxTreeSplit split)
   : leaf_size(check_leaf_size(leaf_size))
   , leaves(leaf_range(geo.size(),leaf_size))
   , depth(geode::depth(leaves.size()))
@@ -117,8 +196,7 @@ template<class TV> BoxTree<TV>::BoxTree(RawArray<const Box<TV>> geo, const int l
   , ranges(geode::ranges(geo.size(),leaf_size))
   , boxes(max(0,leaves.hi),uninit)
 {
-  if (leaves.size())
-    build(*this,ranges,geo,0);
+  build(*this,geo,split);
 }
 
 template<class TV> BoxTree<TV>::BoxTree(const BoxTree<TV>& other)
@@ -186,6 +264,71 @@ any_box_intersection(const Shape& shape) const {
   return any_box_intersection_helper(*this,shape,0);
 }
 
+// Build trees with each split strategy, check their consistency, and return their surface area heuristic costs:
+// the expected number of node visits plus primitive tests for a random ray hitting the root box.
+template<class TV> static Vector<real,2> box_tree_split_test(RawArray<const TV> x, const int leaf_size) {
+  Vector<real,2> costs;
+  for (const int i : range(2)) {
+    const auto tree = new_<BoxTree<TV>>(x,leaf_size,i ? BoxTreeSplit::sah : BoxTreeSplit::longest_axis);
+    tree->check(x);
+    const auto root = tree->boxes.size() ? sah_area(tree->boxes[0]) : 0;
+    if (!(root>0))
+      continue;
+    for (const int n : range(tree->boxes.size()))
+      costs[i] += sah_area(tree->boxes[n])/root*(tree->is_leaf(n) ? 1+tree->prims(n).size() : 1);
+  }
+  return costs;
+}
+
+namespace {
+template<class TV> struct PairVisitor {
+  const BoxTree<TV>& tree0;
+  const BoxTree<TV>& tree1;
+  Array<Vector<int,2>> pairs;
+
+  PairVisitor(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1)
+    : tree0(tree0), tree1(tree1) {}
+
+  bool cull(const int n) const { return false; }
+  bool cull(const int n0, const int n1) const { return false; }
+
+  void leaf(const int n) {
+    const auto prims = tree0.prims(n);
+    for (const int i : range(prims.size()))
+      for (const int j : range(i))
+        pairs.append(vec(prims[j],prims[i]));
+  }
+
+  void leaf(const int n0, const int n1) {
+    for (const int i : tree0.prims(n0))
+      for (const int j : tree1.prims(n1))
+        pairs.append(vec(i,j));
+  }
+};
+}
+
+// Check that parallel traversal produces exactly the serial sequence of leaf pairs
+template<class TV> static int parallel_traverse_test(RawArray<const TV> x0, RawArray<const TV> x1, const int leaf_size,
+                                                     const typename TV::Scalar thickness) {
+  const auto tree0 = new_<BoxTree<TV>>(x0,leaf_size),
+             tree1 = new_<BoxTree<TV>>(x1,leaf_size);
+  const auto new_visitor = [&]() { return PairVisitor<TV>(tree0,tree1); };
+  const auto new_self_visitor = [&]() { return PairVisitor<TV>(tree0,tree0); };
+  const auto flatten = [](const std::vector<PairVisitor<TV>>& visitors) {
+    Array<Vector<int,2>> pairs;
+    for (const auto& v : visitors)
+      pairs.extend(v.pairs);
+    return pairs;
+  };
+  auto serial = new_visitor();
+  double_traverse(*tree0,*tree1,serial,thickness);
+  GEODE_ASSERT(serial.pairs==flatten(parallel_double_traverse(*tree0,*tree1,new_visitor,thickness)));
+  auto serial_self = new_self_visitor();
+  double_traverse(*tree0,serial_self,thickness);
+  GEODE_ASSERT(serial_self.pairs==flatten(parallel_double_traverse(*tree0,new_self_visitor,thickness)));
+  return serial.pairs.size()+serial_self.pairs.size();
+}
+
 #define INSTANTIATE(T,d) \
   template class BoxTree<Vector<T,d>>; \
   template GEODE_CORE_EXPORT bool BoxTree<Vector<T,d>>::any_box_intersection(const Box<Vector<T,d>>&) const; \
@@ -211,4 +354,7 @@ void wrap_box_tree() {
     .GEODE_FIELD(p)
     .GEODE_METHOD(check)
     ;}
+
+  GEODE_FUNCTION_2(box_tree_split_test,box_tree_split_test<Vector<real,3>>)
+  GEODE_FUNCTION_2(parallel_traverse_test,parallel_traverse_test<Vector<real,3>>)
 }
@@ -10,6 +10,11 @@
 //
 // For templatized visitor-based traversal, include traversal.h.
 //
+// Since the layout fixes the number of primitives below each node, construction only chooses
+// the axis along which each node is split.  By default this is the longest axis of the node box;
+// BoxTreeSplit::sah instead picks the axis minimizing a binned surface area heuristic, which
+// produces tighter trees for ray queries.  Subtrees above a size threshold are built in parallel.
+//
 //#####################################################################
 #pragma once
 
@@ -20,6 +25,8 @@
 #include <geode/utility/range.h>
 namespace geode {
 
+enum class BoxTreeSplit { longest_axis, sah };
+
 template<class TV> class BoxTree : public Object
 {
   typedef typename TV::Scalar T;
@@ -35,8 +42,8 @@ public:
   const Array<Box<TV>> boxes;
 
 protected:
-  GEODE_CORE_EXPORT BoxTree(RawArray<const TV> geo, const int leaf_size);
-  GEODE_CORE_EXPORT BoxTree(RawArray<const Box<TV>> geo, const int leaf_size);
+  GEODE_CORE_EXPORT BoxTree(RawArray<const TV> geo, const int leaf_size, const BoxTreeSplit split=BoxTreeSplit::longest_axis);
+  GEODE_CORE_EXPORT BoxTree(RawArray<const Box<TV>> geo, const int leaf_size, const BoxTreeSplit split=BoxTreeSplit::longest_axis);
   GEODE_CORE_EXPORT BoxTree(const BoxTree<TV>& other); // Shares ownership with everything except boxes
 public:
   ~BoxTree();
@@ -3,6 +3,7 @@
 //#####################################################################
 #include <geode/geometry/Implicit.h>
 #include <geode/python/Class.h>
+#include <geode/utility/range.h>
 namespace geode {
 
 typedef real T;
@@ -20,6 +21,14 @@ template<class TV> Implicit<TV>::
 ~Implicit()
 {}
 
+template<class TV> Array<typename TV::Scalar> Implicit<TV>::
+phis(RawArray<const TV> X) const {
+  Array<T> phi(X.size(),uninit);
+  for (const int i : range(X.size()))
+    phi[i] = this->phi(X[i]);
+  return phi;
+}
+
 template class Implicit<Vector<T,1> >;
 template class Implicit<Vector<T,2> >;
 template class Implicit<Vector<T,3> >;
@@ -34,6 +43,7 @@ template<int d> static void wrap_helper() {
   Class<Self>("Implicit")
     .GEODE_FIELD(d)
     .GEODE_METHOD(phi)
+    .GEODE_METHOD(phis)
     .GEODE_METHOD(normal)
     .GEODE_METHOD(lazy_inside)
     .GEODE_METHOD(surface)
@@ -3,6 +3,7 @@
 //#####################################################################
 #pragma once
 
+#include <geode/array/Array.h>
 #include <geode/geometry/Box.h>
 #include <geode/python/Object.h>
 #include <geode/vector/Vector.h>
@@ -20,6 +21,7 @@ public:
   virtual ~Implicit();
 
   virtual T phi(const TV& X) const=0;
+  virtual Array<T> phis(RawArray<const TV> X) const; // Batched phi, for subclasses that can do better than a loop
   virtual TV normal(const TV& X) const=0;
   virtual TV surface(const TV& X) const=0;
   virtual bool lazy_inside(const TV& X) const=0;
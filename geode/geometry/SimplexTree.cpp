@@ -9,6 +9,7 @@
 #include <geode/geometry/Triangle2d.h>
 #include <geode/geometry/Triangle3d.h>
 #include <geode/array/IndirectArray.h>
+#include <geode/array/Nested.h>
 #include <geode/python/Class.h>
 #include <geode/random/Random.h>
 
@@ -26,13 +27,15 @@ template<class TV,int d_> const int SimplexTree<TV,d_>::d;
 template<class Mesh,class TV> static Array<Box<TV>> boxes(const Mesh& mesh, Array<const TV> X) {
   GEODE_ASSERT(mesh.nodes()<=X.size());
   Array<Box<TV>> boxes(mesh.elements.size(),uninit);
+  #pragma omp parallel for
   for(int t=0;t<mesh.elements.size();t++)
     boxes[t] = bounding_box(X.subset(mesh.elements[t]));
   return boxes;
 }
 
-template<class TV,int d> SimplexTree<TV,d>::SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size)
-  : Base(RawArray<const Box<TV>>(geode::boxes(mesh,X)),leaf_size), mesh(ref(mesh)), X(X), simplices(mesh.elements.size(),uninit) {
+template<class TV,int d> SimplexTree<TV,d>::SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size, BoxTreeSplit split)
+  : Base(RawArray<const Box<TV>>(geode::boxes(mesh,X)),leaf_size,split), mesh(ref(mesh)), X(X), simplices(mesh.elements.size(),uninit) {
+  #pragma omp parallel for
   for (int t=0;t<mesh.elements.size();t++)
     simplices[t] = Simplex(X.subset(mesh.elements[t]));
 }
@@ -256,6 +259,173 @@ template<class TV,int d> Array<RayIntersection<TV>> SimplexTree<TV,d>::intersect
 template<> Array<RayIntersection<Vector<real,2>>> SimplexTree<Vector<real,2>,2>::intersections(const RayIntersection<Vector<real,2>>& ray, const real half_thickness) const { GEODE_NOT_IMPLEMENTED(); }
 template<> Array<RayIntersection<Vector<real,3>>> SimplexTree<Vector<real,3>,1>::intersections(const RayIntersection<Vector<real,3>>& ray, const real half_thickness) const { GEODE_NOT_IMPLEMENTED(); }
 
+// Rays are traced together in packets of up to this many rays, all in the same octant
+static const int ray_packet_size = 16;
+
+// Trace a packet of rays through the tree together, sharing node visits.  Each stack entry holds a node, the mask of
+// rays whose slabs hit it, and the smallest entry parameter among those rays.
+template<int signs,class TV,int d> static void packet_intersection_helper(const SimplexTree<TV,d>& self, RawArray<RayIntersection<TV>> rays, const typename TV::Scalar half_thickness) {
+  typedef typename TV::Scalar T;
+  typedef FastRay<TV,signs> Fast;
+  const int n = rays.size();
+  assert(n<=ray_packet_size);
+  const auto fast = GEODE_RAW_ALLOCA(n,Fast);
+  for (int i=0;i<n;i++)
+    new(&fast[i]) Fast(rays[i]);
+
+  // Find the subset of active rays which hit the box of a node
+  const auto hits = [&](const int node, const int active, T& t_min) -> int {
+    int mask = 0;
+    t_min = inf;
+    for (int i=0;i<n;i++)
+      if (active&1<<i) {
+        const auto range = fast[i].range(self.boxes[node],half_thickness);
+        if (range.min<=range.max && range.max>=0 && range.min<=fast[i].t_max) {
+          mask |= 1<<i;
+          t_min = min(t_min,range.min);
+        }
+      }
+    return mask;
+  };
+
+  T root_tmin;
+  const int root = hits(0,(1<<n)-1,root_tmin);
+  if (!root)
+    return;
+  const int internal = self.leaves.lo;
+  RawStack<Tuple<int,int,T>> stack(GEODE_RAW_ALLOCA(self.depth,Tuple<int,int,T>)); // Each entry is (node,mask,t_min)
+  stack.push(tuple(0,root,root_tmin));
+  while (stack.size()) {
+    const auto entry = stack.pop();
+    const int node = entry.x,
+              active = entry.y;
+    // Skip the node if every active ray has since found a closer hit
+    T t_max = -inf;
+    for (int i=0;i<n;i++)
+      if (active&1<<i)
+        t_max = max(t_max,fast[i].t_max);
+    if (entry.z>t_max)
+      continue;
+    if (node < internal) {
+      // Visit the child with smaller t_min first
+      int child0 = 2*node+1,
+          child1 = 2*node+2;
+      T tmin0, tmin1;
+      int mask0 = hits(child0,active,tmin0),
+          mask1 = hits(child1,active,tmin1);
+      if (tmin0>tmin1) {
+        swap(child0,child1);
+        swap(mask0,mask1);
+        swap(tmin0,tmin1);
+      }
+      if (mask1)
+        stack.push(tuple(child1,mask1,tmin1));
+      if (mask0)
+        stack.push(tuple(child0,mask0,tmin0));
+    } else {
+      // Test all simplices in this leaf against all active rays
+      for (int i=0;i<n;i++)
+        if (active&1<<i)
+          for (const int t : self.prims(node))
+            if (self.simplices[t].intersection(rays[i],half_thickness)) {
+              fast[i].t_max = rays[i].t_max;
+              rays[i].aggregate_id = t;
+            }
+    }
+  }
+}
+
+template<class TV,int d> static void packet_intersection_dispatch(const SimplexTree<TV,d>& self, RawArray<RayIntersection<TV>> rays, const int signs, const typename TV::Scalar half_thickness);
+
+template<> void packet_intersection_dispatch(const SimplexTree<Vector<real,2>,1>& self, RawArray<RayIntersection<Vector<real,2>>> rays, const int signs, const real half_thickness) {
+  switch (signs) {
+    case 0: packet_intersection_helper<0>(self,rays,half_thickness); break;
+    case 1: packet_intersection_helper<1>(self,rays,half_thickness); break;
+    case 2: packet_intersection_helper<2>(self,rays,half_thickness); break;
+    case 3: packet_intersection_helper<3>(self,rays,half_thickness); break;
+  }
+}
+
+template<> void packet_intersection_dispatch(const SimplexTree<Vector<real,3>,2>& self, RawArray<RayIntersection<Vector<real,3>>> rays, const int signs, const real half_thickness) {
+  switch (signs) {
+    case 0: packet_intersection_helper<0>(self,rays,half_thickness); break;
+    case 1: packet_intersection_helper<1>(self,rays,half_thickness); break;
+    case 2: packet_intersection_helper<2>(self,rays,half_thickness); break;
+    case 3: packet_intersection_helper<3>(self,rays,half_thickness); break;
+    case 4: packet_intersection_helper<4>(self,rays,half_thickness); break;
+    case 5: packet_intersection_helper<5>(self,rays,half_thickness); break;
+    case 6: packet_intersection_helper<6>(self,rays,half_thickness); break;
+    case 7: packet_intersection_helper<7>(self,rays,half_thickness); break;
+  }
+}
+
+template<class TV,int d> template<int e>
+typename enable_if_c<e==TV::m-1,Tuple<Array<typename TV::Scalar>,Array<int>,Array<typename SimplexTree<TV,d>::Weights>>>::type
+SimplexTree<TV,d>::batch_intersection(RawArray<const TV> starts, RawArray<const TV> directions, const T half_thickness, const T t_max) const {
+  GEODE_ASSERT(starts.size()==directions.size());
+  const int n = starts.size();
+  Array<T> ts(n,uninit);
+  Array<int> hits(n,uninit);
+  Array<Weights> weights(n,uninit);
+  if (!boxes.size()) {
+    ts.fill(inf);
+    hits.fill(-1);
+    weights.fill(Weights());
+    return tuple(ts,hits,weights);
+  }
+
+  // Bucket rays by octant, so that all rays in a packet can share one FastRay instantiation
+  const int octants = 1<<TV::m;
+  Array<int> signs(n,uninit);
+  Array<int> counts(octants);
+  for (int i=0;i<n;i++)
+    counts[signs[i] = fast_ray_signs(Ray<TV>(starts[i],directions[i]))]++;
+  Nested<int> octant_rays(counts,uninit);
+  for (int i=n-1;i>=0;i--)
+    octant_rays(signs[i],--counts[signs[i]]) = i;
+
+  // Within each octant, order rays spatially by start point.  The leaves of a BoxTree with leaf size equal to the packet size
+  // are exactly the consecutive packet sized chunks of its permutation, so each packet is a spatially coherent cluster.
+  Array<int> order(n,uninit);
+  Array<Vector<int,3>> packets; // (lo,hi,signs) ranges of order
+  for (const int s : range(octants)) {
+    const auto ids = octant_rays[s];
+    const int offset = octant_rays.offsets[s];
+    const auto tree = new_<BoxTree<TV>>(starts.subset(ids).copy(),ray_packet_size);
+    for (const int i : range(ids.size()))
+      order[offset+i] = ids[tree->p[i]];
+    for (int i=0;i<ids.size();i+=ray_packet_size)
+      packets.append(vec(offset+i,offset+min(i+ray_packet_size,ids.size()),s));
+  }
+
+  // Trace packets in parallel
+  Array<RayIntersection<TV>> rays(n,uninit);
+  #pragma omp parallel for schedule(dynamic)
+  for (int k=0;k<packets.size();k++) {
+    const int lo = packets[k].x,
+              hi = packets[k].y;
+    for (int j=lo;j<hi;j++) {
+      const int i = order[j];
+      rays[j] = RayIntersection<TV>(starts[i],directions[i]);
+      rays[j].t_max = t_max;
+    }
+    packet_intersection_dispatch(*this,rays.slice(lo,hi),packets[k].z,half_thickness);
+    for (int j=lo;j<hi;j++) {
+      const auto& ray = rays[j];
+      const int i = order[j];
+      hits[i] = ray.aggregate_id;
+      if (hits[i]>=0) {
+        ts[i] = ray.t_max;
+        weights[i] = barycentric_coordinates(simplices[hits[i]],ray.point(ray.t_max));
+      } else {
+        ts[i] = inf;
+        weights[i] = Weights();
+      }
+    }
+  }
+  return tuple(ts,hits,weights);
+}
+
 // Random directions courtesy of numpy.random.randn.
 template<class T> static RawArray<const Vector<T,2>> directions_helper_2() {
   typedef Vector<T,2> TV;
@@ -366,6 +536,13 @@ INSTANTIATE(2,2)
 INSTANTIATE(3,1)
 INSTANTIATE(3,2)
 
+#define INSTANTIATE_BATCH(m) \
+  template GEODE_CORE_EXPORT Tuple<Array<real>,Array<int>,Array<SimplexTree<Vector<real,m>,m-1>::Weights>> \
+  SimplexTree<Vector<real,m>,m-1>::batch_intersection<m-1>(RawArray<const Vector<real,m>>,RawArray<const Vector<real,m>>, \
+                                                           const real,const real) const;
+INSTANTIATE_BATCH(2)
+INSTANTIATE_BATCH(3)
+
 template<class T, int d> static int ray_traversal_test(const SimplexTree<Vector<T,d>,d-1>& tree, const int rays, const T half_thickness) {
   typedef Vector<T,d> TV;
   const auto box = tree.bounding_box();
@@ -389,14 +566,44 @@ template<class T, int d> static int ray_traversal_test(const SimplexTree<Vector<
   return hits;
 }
 
+// Check batch_intersection against one ray at a time
+template<class T, int d> static int batch_ray_traversal_test(const SimplexTree<Vector<T,d>,d-1>& tree, const int rays, const T half_thickness) {
+  typedef Vector<T,d> TV;
+  const auto box = tree.bounding_box();
+  const auto random = new_<Random>(819371111);
+  Array<TV> starts(rays,uninit), directions(rays,uninit);
+  for (int i=0;i<rays;i++) {
+    starts[i] = random->uniform(box);
+    directions[i] = random->direction<TV>();
+  }
+  const auto batch = tree.batch_intersection(starts,directions,half_thickness,2);
+  int hits = 0;
+  for (int i=0;i<rays;i++) {
+    RayIntersection<TV> ray(starts[i],directions[i]);
+    ray.t_max = 2;
+    const bool hit = tree.intersection(ray,half_thickness);
+    GEODE_ASSERT(hit==(batch.y[i]>=0));
+    if (hit) {
+      GEODE_ASSERT(ray.aggregate_id==batch.y[i] && abs(ray.t_max-batch.x[i])<1e-12);
+      hits++;
+    }
+  }
+  return hits;
+}
+
 }
 using namespace geode;
 
+template<class Self> static void wrap_batch_intersection(Class<Self>& cls, mpl::false_) {}
+template<class Self> static void wrap_batch_intersection(Class<Self>& cls, mpl::true_) {
+  cls.method("batch_intersection",&Self::template batch_intersection<Self::d>);
+}
+
 template<class TV,int d> static void wrap_helper() {
   typedef SimplexTree<TV,d> Self;
   static const string name = format("%sTree%dd",(d==1?"Segment":"Triangle"),TV::m);
-  Class<Self>(name.c_str())
-    .GEODE_INIT(const typename Self::Mesh&,Array<const TV>,int)
+  Class<Self> cls(name.c_str());
+  cls.GEODE_INIT(const typename Self::Mesh&,Array<const TV>,int)
     .GEODE_FIELD(mesh)
     .GEODE_FIELD(X)
     .GEODE_FIELD(d)
@@ -404,6 +611,7 @@ template<class TV,int d> static void wrap_helper() {
     .GEODE_METHOD(closest_point)
     .GEODE_METHOD(distance)
     ;
+  wrap_batch_intersection(cls,mpl::bool_<d==TV::m-1>());
 }
 
 void wrap_simplex_tree() {
@@ -412,4 +620,5 @@ void wrap_simplex_tree() {
   wrap_helper<Vector<real,3>,1>();
   wrap_helper<Vector<real,3>,2>();
   GEODE_FUNCTION_2(ray_traversal_test,ray_traversal_test<real,3>)
+  GEODE_FUNCTION_2(batch_ray_traversal_test,batch_ray_traversal_test<real,3>)
 }
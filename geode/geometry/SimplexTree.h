@@ -28,7 +28,7 @@ public:
   const Array<Simplex> simplices;
 
 protected:
-  GEODE_CORE_EXPORT SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size);
+  GEODE_CORE_EXPORT SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size, BoxTreeSplit split=BoxTreeSplit::longest_axis);
   GEODE_CORE_EXPORT SimplexTree(const SimplexTree& other, Array<const TV> X); // Shares ownership for topology (mesh, tree structure, etc.) but not geometry (X,boxes,simplices)
 public:
   ~SimplexTree();
@@ -36,6 +36,12 @@ public:
   GEODE_CORE_EXPORT void update(); // Call whenever X changes
   GEODE_CORE_EXPORT bool intersection(RayIntersection<TV>& ray, const T thickness_over_two) const;
   GEODE_CORE_EXPORT Array<RayIntersection<TV> > intersections(const RayIntersection<TV>& ray, const T thickness_over_two) const;
+
+  // Cast many rays at once, grouped into coherent packets which are traced in parallel.  Directions need not be normalized.
+  // Returns t,simplex,weights for each ray.  If a ray hits nothing, t = inf and simplex = -1.  Available only for segments
+  // in 2D and triangles in 3D.
+  template<int e=d_> GEODE_CORE_EXPORT typename enable_if_c<e==TV::m-1,Tuple<Array<T>,Array<int>,Array<Weights>>>::type
+  batch_intersection(RawArray<const TV> starts, RawArray<const TV> directions, const T thickness_over_two, const T t_max=inf) const;
   GEODE_CORE_EXPORT void intersection(const Sphere<TV>& sphere, Array<int>& hits) const;
   GEODE_CORE_EXPORT void intersections(const Plane<T>& plane, Array<Segment<TV>>& result) const;
   GEODE_CORE_EXPORT bool inside(TV point) const;
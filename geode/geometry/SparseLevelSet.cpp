@@ -0,0 +1,293 @@
+// Sparse narrow band signed distance fields
+
+#include <geode/geometry/SparseLevelSet.h>
+#include <geode/geometry/ParticleTree.h>
+#include <geode/geometry/surface_levelset.h>
+#include <geode/math/constants.h>
+#include <geode/python/Class.h>
+#include <geode/utility/openmp.h>
+#include <geode/utility/str.h>
+#include <geode/vector/normalize.h>
+#include <cmath>
+namespace geode {
+
+typedef real T;
+typedef Vector<T,3> TV;
+typedef Vector<int,3> IV;
+GEODE_DEFINE_TYPE(SparseLevelSet)
+const int SparseLevelSet::block;
+const int SparseLevelSet::block_nodes;
+const int SparseLevelSet::far_outside;
+const int SparseLevelSet::far_inside;
+
+static const int bn = SparseLevelSet::block+1; // Nodes per block along each axis
+
+static inline int node_index(const IV& n) {
+  return (n.x*bn+n.y)*bn+n.z;
+}
+
+SparseLevelSet::SparseLevelSet(const SimplexTree<TV,2>& surface, const T dx, const T band)
+  : dx(dx)
+  , band(band)
+  , box(surface.bounding_box()) {
+  GEODE_ASSERT(dx>0 && band>dx);
+  GEODE_ASSERT(surface.simplices.size());
+
+  // Pad the grid so that the outermost layer of blocks is always far from the surface
+  const T block_size = block*dx,
+          half_diagonal = .5*sqrt(3.)*block_size;
+  const T pad = band+2*block_size;
+  const TV sizes = box.sizes()+2*pad;
+  const_cast_(origin) = box.min-pad;
+  IV counts;
+  for (int a=0;a<3;a++) {
+    const T n = ceil(sizes[a]/block_size);
+    GEODE_ASSERT(n<(1<<20),format("SparseLevelSet: grid too large (%g blocks along axis %d)",n,a));
+    counts[a] = int(n);
+  }
+  GEODE_ASSERT(double(counts.product())*block_nodes<(1u<<31),"SparseLevelSet: grid too large");
+  Array<int,3> blocks(counts,uninit);
+  const auto block_center = [=](const IV& b) {
+    return origin+block_size*(TV(b)+.5);
+  };
+
+  // Allocate blocks whose nodes might be within the band.  Any node with |phi| < band lies in such a block.
+  const int nb = blocks.flat.size();
+  OmpExceptions errors;
+  #pragma omp parallel for schedule(dynamic,64)
+  for (int i=0;i<nb;i++) errors.capture([&]{
+    const IV b(i/(counts.y*counts.z),i/counts.z%counts.y,i%counts.z);
+    blocks.flat[i] = surface.distance(block_center(b),band+half_diagonal)<=band+half_diagonal ? 0 : far_outside;
+  });
+  errors.rethrow();
+  int allocated = 0;
+  for (auto& k : blocks.flat)
+    if (k==0)
+      k = allocated++;
+
+  // Compute exact signed distances at the nodes of all allocated blocks at once, since surface_levelset is
+  // parallel internally and has setup cost proportional to the size of the surface.
+  Array<TV> X(allocated*block_nodes,uninit);
+  #pragma omp parallel for
+  for (int i=0;i<nb;i++) {
+    const int k = blocks.flat[i];
+    if (k>=0) {
+      const IV b(i/(counts.y*counts.z),i/counts.z%counts.y,i%counts.z);
+      const TV base = origin+block_size*TV(b);
+      TV* x = X.data()+k*block_nodes;
+      for (int n0=0;n0<bn;n0++)
+        for (int n1=0;n1<bn;n1++)
+          for (int n2=0;n2<bn;n2++)
+            x[node_index(IV(n0,n1,n2))] = base+dx*TV(n0,n1,n2);
+    }
+  }
+  // Distances are needed only within the band, and surface_levelset is much faster with a tight max_distance.
+  // Nodes outside the band get signs from their neighbors: since band > dx, a grid edge touching such a node
+  // cannot cross the surface, so signs flow across these edges unchanged.
+  const auto close = surface_levelset(new_<ParticleTree<TV>>(X,8),surface,band,true);
+  const auto& simplex = close.z;
+  Array<T> values = close.x;
+  #pragma omp parallel for schedule(dynamic,16)
+  for (int k=0;k<allocated;k++) errors.capture([&]{
+    const auto V = values.slice(k*block_nodes,(k+1)*block_nodes);
+    const auto S = simplex.slice(k*block_nodes,(k+1)*block_nodes);
+    Array<bool> signed_(block_nodes,uninit);
+    Array<int> stack;
+    for (const int i : range(block_nodes)) {
+      signed_[i] = S[i]>=0;
+      if (signed_[i])
+        stack.append(i);
+    }
+    if (!stack.size()) { // No node is within the band, so the whole block has one sign
+      V.fill(surface.inside(X[k*block_nodes]) ? -band : band);
+      return;
+    }
+    while (stack.size()) {
+      const int i = stack.pop();
+      const IV n(i/(bn*bn),i/bn%bn,i%bn);
+      for (int a=0;a<3;a++)
+        for (const int s : {-1,1}) {
+          IV m = n;
+          m[a] += s;
+          if (unsigned(m[a])<unsigned(bn)) {
+            const int j = node_index(m);
+            if (!signed_[j]) {
+              signed_[j] = true;
+              V[j] = V[i]<0 ? -band : band;
+              stack.append(j);
+            }
+          }
+        }
+    }
+    for (auto& v : V)
+      v = clamp(v,-band,band);
+  });
+  errors.rethrow();
+
+  // Far blocks form connected components separated by the band.  Components touching the boundary of the grid are
+  // outside.  Any other component is enclosed by the surface, but may still be outside (e.g., the cavity of a hollow
+  // shell), so it is signed by a single inside query at one of its blocks, which is far from the surface.
+  Array<bool,3> seen(counts);
+  Array<IV> component, stack;
+  for (int i=0;i<nb;i++) {
+    if (blocks.flat[i]!=far_outside || seen.flat[i])
+      continue;
+    component.clear();
+    bool border = false;
+    const auto visit = [&](const IV& b) {
+      if (!blocks.valid(b))
+        border = true;
+      else if (blocks(b)==far_outside && !seen(b)) {
+        seen(b) = true;
+        component.append(b);
+        stack.append(b);
+      }
+    };
+    visit(IV(i/(counts.y*counts.z),i/counts.z%counts.y,i%counts.z));
+    while (stack.size()) {
+      const IV b = stack.pop();
+      for (int a=0;a<3;a++)
+        for (const int s : {-1,1}) {
+          IV c = b;
+          c[a] += s;
+          visit(c);
+        }
+    }
+    if (!border && surface.inside(block_center(component[0])))
+      for (const auto& b : component)
+        blocks(b) = far_inside;
+  }
+
+  const_cast_(this->blocks) = blocks;
+  const_cast_(this->values) = values;
+}
+
+SparseLevelSet::~SparseLevelSet() {}
+
+// The block containing a point, the point's cell within that block, and its fractional position in that cell
+struct SparseLevelSet::Cell {
+  int block; // Offset into values, or far_outside or far_inside
+  IV cell;
+  TV w;
+};
+
+// Find the block, cell and weights of a point, leaving c.block unset.  Returns false outside the grid.
+inline bool SparseLevelSet::locate(const TV& X, IV& b, Cell& c) const {
+  const TV Y = (X-origin)/dx;
+  for (int a=0;a<3;a++) {
+    const T f = floor(Y[a]);
+    if (!(0<=f && f<block*blocks.sizes()[a])) // Outside the grid (or NaN)
+      return false;
+    const int i = int(f);
+    b[a] = i/block;
+    c.cell[a] = i-block*b[a];
+    c.w[a] = Y[a]-f;
+  }
+  return true;
+}
+
+SparseLevelSet::Cell SparseLevelSet::cell(const TV& X) const {
+  Cell c;
+  IV b;
+  if (!locate(X,b,c)) {
+    c.block = far_outside;
+    return c;
+  }
+  const int k = blocks(b);
+  c.block = k<0 ? k : k*block_nodes;
+  return c;
+}
+
+inline T SparseLevelSet::value(const Cell& c) const {
+  if (c.block<0)
+    return c.block==far_inside ? -band : band;
+  const T* v = values.data()+c.block+node_index(c.cell);
+  const int sx = bn*bn, sy = bn;
+  const T x00 = v[0]    +c.w.z*(v[1]      -v[0]),
+          x01 = v[sy]   +c.w.z*(v[sy+1]   -v[sy]),
+          x10 = v[sx]   +c.w.z*(v[sx+1]   -v[sx]),
+          x11 = v[sx+sy]+c.w.z*(v[sx+sy+1]-v[sx+sy]);
+  const T x0 = x00+c.w.y*(x01-x00),
+          x1 = x10+c.w.y*(x11-x10);
+  return x0+c.w.x*(x1-x0);
+}
+
+T SparseLevelSet::phi(const TV& X) const {
+  return value(cell(X));
+}
+
+Array<T> SparseLevelSet::phis(RawArray<const TV> X) const {
+  // Batches are usually spatially coherent, so remember the last block looked up
+  Array<T> phi(X.size(),uninit);
+  IV last(-1,-1,-1);
+  int last_block = far_outside;
+  for (const int i : range(X.size())) {
+    Cell c;
+    IV b;
+    if (!locate(X[i],b,c))
+      c.block = far_outside;
+    else {
+      if (b!=last) {
+        last = b;
+        const int k = blocks(b);
+        last_block = k<0 ? k : k*block_nodes;
+      }
+      c.block = last_block;
+    }
+    phi[i] = value(c);
+  }
+  return phi;
+}
+
+TV SparseLevelSet::normal(const TV& X) const {
+  const auto c = cell(X);
+  if (c.block<0)
+    return TV();
+  const T* v = values.data()+c.block+node_index(c.cell);
+  const int sx = bn*bn, sy = bn;
+  // Gradient of the trilinear interpolant
+  TV g;
+  const T wx = c.w.x, wy = c.w.y, wz = c.w.z;
+  for (int i=0;i<2;i++)
+    for (int j=0;j<2;j++)
+      for (int k=0;k<2;k++) {
+        const T f = v[i*sx+j*sy+k];
+        const T ax = i?wx:1-wx, ay = j?wy:1-wy, az = k?wz:1-wz;
+        g.x += (i?1:-1)*ay*az*f;
+        g.y += (j?1:-1)*ax*az*f;
+        g.z += (k?1:-1)*ax*ay*f;
+      }
+  return normalized(g);
+}
+
+TV SparseLevelSet::surface(const TV& X) const {
+  return X-phi(X)*normal(X);
+}
+
+bool SparseLevelSet::lazy_inside(const TV& X) const {
+  return phi(X)<=0;
+}
+
+Box<TV> SparseLevelSet::bounding_box() const {
+  return box;
+}
+
+string SparseLevelSet::repr() const {
+  return format("SparseLevelSet(dx=%g,band=%g,blocks=%s,allocated=%d)",dx,band,str(blocks.sizes()),allocated_blocks());
+}
+
+}
+using namespace geode;
+
+void wrap_sparse_levelset() {
+  typedef SparseLevelSet Self;
+  Class<Self>("SparseLevelSet")
+    .GEODE_INIT(const SimplexTree<TV,2>&,T,T)
+    .GEODE_FIELD(dx)
+    .GEODE_FIELD(band)
+    .GEODE_FIELD(origin)
+    .GEODE_FIELD(blocks)
+    .GEODE_FIELD(values)
+    .GEODE_METHOD(allocated_blocks)
+    ;
+}
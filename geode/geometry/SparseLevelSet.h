@@ -0,0 +1,57 @@
+// Sparse narrow band signed distance fields
+//
+// SparseLevelSet samples the signed distance to a closed triangle mesh on a regular grid, storing values only in
+// blocks of cells near the surface.  Each allocated block stores its own (block+1)^3 nodes, so every cell can be
+// interpolated from a single block.  Values are clamped to [-band,band]; blocks away from the surface store only
+// whether they are inside or outside, so phi and lazy_inside are constant time lookups everywhere.
+#pragma once
+
+#include <geode/geometry/Implicit.h>
+#include <geode/geometry/SimplexTree.h>
+#include <geode/array/Array3d.h>
+namespace geode {
+
+class SparseLevelSet : public Implicit<Vector<real,3>> {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef real T;
+  typedef Vector<T,3> TV;
+  typedef Vector<int,3> IV;
+  typedef Implicit<TV> Base;
+  static const int block = 8; // Cells per block along each axis
+  static const int block_nodes = (block+1)*(block+1)*(block+1);
+  static const int far_outside = -1, far_inside = -2;
+
+  const T dx; // Cell size
+  const T band; // Half width of the narrow band
+  const Box<TV> box; // Bounding box of the surface
+  const TV origin; // Position of node (0,0,0)
+  const Array<const int,3> blocks; // Offset into values in units of block_nodes, or far_outside or far_inside
+  const Array<const T> values;
+
+protected:
+  // The surface must be closed and consistently oriented, and band must exceed dx.  Blocks are built in parallel.
+  GEODE_CORE_EXPORT SparseLevelSet(const SimplexTree<TV,2>& surface, const T dx, const T band);
+public:
+  ~SparseLevelSet();
+
+  int allocated_blocks() const {
+    return values.size()/block_nodes;
+  }
+
+  T phi(const TV& X) const;
+  Array<T> phis(RawArray<const TV> X) const; // Batched phi, reusing block lookups between nearby points
+  TV normal(const TV& X) const; // Normalized gradient of the interpolant, or zero outside the band
+  TV surface(const TV& X) const;
+  bool lazy_inside(const TV& X) const;
+  Box<TV> bounding_box() const;
+  string repr() const;
+
+private:
+  struct Cell;
+  bool locate(const TV& X, IV& b, Cell& c) const;
+  Cell cell(const TV& X) const;
+  T value(const Cell& c) const; // Interpolated phi within a cell
+};
+
+}
@@ -52,3 +52,6 @@ def FrameImplicit(frame,object):
 surface_levelsets = {1:surface_levelset_c3d,2:surface_levelset_s3d}
 def surface_levelset(particles,surface,max_distance=inf,compute_signs=True):
   return surface_levelsets[surface.d](particles,surface,max_distance,compute_signs)
+
+def mesh_implicit(implicit,dx,lipschitz=1):
+  return geode_wrap.mesh_implicit(implicit,dx,lipschitz)
@@ -0,0 +1,305 @@
+// Surface extraction from implicit surfaces
+
+#include <geode/geometry/mesh_implicit.h>
+#include <geode/array/RawField.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/openmp.h>
+#include <geode/utility/range.h>
+#include <algorithm>
+#include <vector>
+namespace geode {
+
+typedef real T;
+typedef Vector<T,3> TV;
+typedef Vector<int,3> IV;
+using std::vector;
+
+/*
+ * We use marching tetrahedra rather than marching cubes or dual contouring since it is the simplest
+ * scheme which always produces manifold output.  Each grid cell is split into six tetrahedra around its
+ * main diagonal (the Kuhn triangulation), which is translation invariant and therefore conforming across
+ * cells.  Every tetrahedron edge runs from a node n to n+d for one of the seven nonzero d in {0,1}^3, so an
+ * edge is identified by the key 8*index(n)+mask(d).  Nodes with phi < 0 are inside and all others are
+ * outside, so no surface vertex ever lies on a node and the extracted surface is a 2-manifold.
+ *
+ * The grid is divided into bricks of 8^3 cells, which are found by descending an octree over the bricks
+ * and discarding boxes that are far from the surface.  Each brick evaluates phi at its nodes in one batch
+ * and extracts its piece of the surface independently, keyed by global edge key.  A final sort merges
+ * vertices shared between bricks, and the topology is built in one pass.
+ */
+
+static const int brick = 8; // Cells per brick along each axis
+static const int bn = brick+1; // Nodes per brick along each axis
+
+namespace {
+struct Piece {
+  Array<uint64_t> keys; // Global edge key of each local vertex
+  Array<TV> X; // Position of each local vertex
+  Array<Vector<int,3>> tris; // Triangles in local vertex indices
+  Array<int> shared; // Local vertices on the brick boundary, which other bricks may also have
+  Array<int> ids; // Final index of each local vertex
+};
+}
+
+static inline int parity(const int i, const int j, const int k, const int l) {
+  return ((i>j)+(i>k)+(i>l)+(j>k)+(j>l)+(k>l))&1;
+}
+
+// Might the cube [min,min+size]^3, whose center has already passed the Lipschitz test, contain part of the surface?
+// Octants are tested in one batch and subdivided down to cubes of min_size.  Clamped distances such as SparseLevelSet
+// can only rule out cubes whose half diagonal is below their clamp value, so a single test per brick is not enough.
+static bool may_contain_surface(const Implicit<TV>& implicit, const TV min, const T size, const T min_size,
+                                const T lipschitz, const T slack) {
+  if (size<=min_size)
+    return true;
+  const T half = size/2;
+  Vector<TV,8> corners, centers;
+  for (int c=0;c<8;c++) {
+    corners[c] = min+half*TV(c>>2,c>>1&1,c&1);
+    centers[c] = corners[c]+half/2;
+  }
+  const auto phi = implicit.phis(RawArray<const TV>(8,centers.data()));
+  const T bound = lipschitz*(.5*sqrt(3.)*half+slack);
+  for (int c=0;c<8;c++)
+    if (abs(phi[c])<=bound && may_contain_surface(implicit,corners[c],half,min_size,lipschitz,slack))
+      return true;
+  return false;
+}
+
+Tuple<Ref<const TriangleTopology>,Field<const TV,VertexId>>
+mesh_implicit(const Implicit<TV>& implicit, const T dx, const T lipschitz) {
+  GEODE_ASSERT(dx>0 && lipschitz>0);
+  const auto box = implicit.bounding_box().thickened(2*dx);
+  GEODE_ASSERT(!box.empty() && isfinite(box.sizes().max()),"mesh_implicit: implicit surface must be bounded");
+
+  // Lay out the grid of nodes, cells and bricks
+  IV cells, bricks;
+  for (int a=0;a<3;a++) {
+    const T n = ceil(box.sizes()[a]/dx);
+    GEODE_ASSERT(n<(1<<20),format("mesh_implicit: grid too large (%g cells along axis %d)",n,a));
+    cells[a] = max(1,int(n));
+    bricks[a] = (cells[a]+brick-1)/brick;
+  }
+  const IV nodes = cells+1;
+  const TV origin = box.min;
+  const auto node_key = [=](const IV& n) {
+    return (uint64_t(n.x)*nodes.y+n.y)*nodes.z+n.z;
+  };
+
+  // Descend an octree over the bricks, keeping boxes which might contain part of the surface.  A cell with a
+  // sign change contains a zero of phi, so the Lipschitz bound suffices; the slack of two cells covers implicits
+  // which are only approximately distances.  Bricks which survive are subdivided further before being kept.
+  const T half_diagonal = .5*sqrt(3.)*brick*dx,
+          slack = 2*dx;
+  int size = 1;
+  while (size<bricks.max())
+    size *= 2;
+  Array<IV> frontier(1);
+  for (;;) {
+    const int n = frontier.size();
+    Array<bool> keep(n,uninit);
+    OmpExceptions errors;
+    #pragma omp parallel for schedule(dynamic,64)
+    for (int i=0;i<n;i++) errors.capture([&]{
+      const TV min = origin+brick*dx*TV(frontier[i]);
+      keep[i] =    abs(implicit.phi(min+.5*size*brick*dx)) <= lipschitz*(size*half_diagonal+slack)
+                && (size>1 || may_contain_surface(implicit,min,brick*dx,2*dx,lipschitz,slack));
+    });
+    errors.rethrow();
+    Array<IV> next;
+    for (const int i : range(n))
+      if (keep[i]) {
+        if (size==1)
+          next.append(frontier[i]);
+        else
+          for (const int c : range(8)) {
+            const IV b = frontier[i]+size/2*IV(c>>2,c>>1&1,c&1);
+            if (b.x<bricks.x && b.y<bricks.y && b.z<bricks.z)
+              next.append(b);
+          }
+      }
+    frontier = next;
+    if (size==1)
+      break;
+    size /= 2;
+  }
+  const auto& kept = frontier;
+
+  // The six tetrahedra of the Kuhn triangulation, one per permutation of the axes, with their orientations.
+  // Tetrahedron vertex i is the cell corner with offset mask chain[i], and each mask contains the previous one.
+  static const int perms[6][3] = {{0,1,2},{1,2,0},{2,0,1},{0,2,1},{2,1,0},{1,0,2}};
+
+  // Extract the surface within each brick
+  vector<Piece> pieces(kept.size());
+  OmpExceptions errors;
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int p=0;p<kept.size();p++) errors.capture([&]{
+    const IV lo = brick*kept[p];
+    const IV hi = IV::componentwise_min(lo+brick,cells); // Cell range is [lo,hi)
+
+    // Evaluate phi at all nodes of the brick in one batch
+    Array<TV> X(bn*bn*bn,uninit);
+    for (int i=0;i<bn;i++)
+      for (int j=0;j<bn;j++)
+        for (int k=0;k<bn;k++)
+          X[(i*bn+j)*bn+k] = origin+dx*TV(lo+IV(i,j,k));
+    const auto phi = implicit.phis(X);
+    GEODE_ASSERT(phi.size()==X.size());
+
+    auto& piece = pieces[p];
+    Array<int> vertex(8*bn*bn*bn); // Local vertex of each local edge key, plus one
+    const auto edge_vertex = [&](const int n0, const int n1, const int mask) {
+      int& v = vertex[8*n0+mask];
+      if (!v) {
+        const T t = phi[n0]/(phi[n0]-phi[n1]);
+        const int i = n0/(bn*bn), j = n0/bn%bn, k = n0%bn;
+        piece.keys.append(8*node_key(lo+IV(i,j,k))+mask);
+        piece.X.append(X[n0]+t*(X[n1]-X[n0]));
+        v = piece.keys.size();
+        // An edge is interior to the brick unless it lies within a face of the brick
+        const IV local(i,j,k);
+        for (int a=0;a<3;a++)
+          if (!(mask>>a&1) && (local[a]==0 || local[a]==brick)) {
+            piece.shared.append(v-1);
+            break;
+          }
+      }
+      return v-1;
+    };
+    static const int stride[3] = {bn*bn,bn,1};
+    for (int i=0;i<hi.x-lo.x;i++)
+      for (int j=0;j<hi.y-lo.y;j++)
+        for (int k=0;k<hi.z-lo.z;k++) {
+          const int n = (i*bn+j)*bn+k;
+          int corners[8];
+          int inside = 0;
+          for (int c=0;c<8;c++) {
+            corners[c] = n+(c&1?stride[0]:0)+(c&2?stride[1]:0)+(c&4?stride[2]:0);
+            inside += phi[corners[c]]<0;
+          }
+          if (!inside || inside==8)
+            continue;
+          for (const auto& perm : perms) {
+            const int chain[4] = {0,1<<perm[0],1<<perm[0]|1<<perm[1],7};
+            const bool positive = !parity(perm[0],perm[1],perm[2],3);
+            int tet[4];
+            bool in[4];
+            int count = 0;
+            for (int a=0;a<4;a++) {
+              tet[a] = corners[chain[a]];
+              in[a] = phi[tet[a]]<0;
+              count += in[a];
+            }
+            if (!count || count==4)
+              continue;
+            const auto E = [&](int a, int b) {
+              if (a>b)
+                swap(a,b);
+              return edge_vertex(tet[a],tet[b],chain[b]^chain[a]);
+            };
+            if (count==1 || count==3) {
+              // Vertex a is alone on its side.  For an even permutation (a,b,c,d) of a positive tetrahedron,
+              // triangle (ab,ac,ad) points away from a.
+              int a = 0;
+              while (in[a]!=(count==1))
+                a++;
+              int b = (a+1)&3, c = (a+2)&3, d = (a+3)&3;
+              if (parity(a,b,c,d)!=!positive)
+                swap(c,d);
+              if (count==3)
+                swap(c,d);
+              piece.tris.append(vec(E(a,b),E(a,c),E(a,d)));
+            } else {
+              // Inside a,b and outside c,d.  For an even permutation of a positive tetrahedron,
+              // quad (ac,ad,bd,bc) points away from a and b.
+              int s[4], m = 0;
+              for (int a=0;a<4;a++)
+                if (in[a])
+                  s[m++] = a;
+              for (int a=0;a<4;a++)
+                if (!in[a])
+                  s[m++] = a;
+              if (parity(s[0],s[1],s[2],s[3])!=!positive)
+                swap(s[2],s[3]);
+              const int q0 = E(s[0],s[2]), q1 = E(s[0],s[3]),
+                        q2 = E(s[1],s[3]), q3 = E(s[1],s[2]);
+              // Split along the shorter diagonal
+              if (sqr_magnitude(piece.X[q0]-piece.X[q2]) <= sqr_magnitude(piece.X[q1]-piece.X[q3]))
+                piece.tris.extend(vec(vec(q0,q1,q2),vec(q0,q2,q3)));
+              else
+                piece.tris.extend(vec(vec(q0,q1,q3),vec(q1,q2,q3)));
+            }
+          }
+        }
+  });
+  errors.rethrow();
+
+  // Vertices interior to bricks are unique, so only those on brick boundaries need to be merged
+  Array<int> offsets(kept.size()+1), shared_offsets(kept.size()+1);
+  for (const int p : range(kept.size())) {
+    const auto& piece = pieces[p];
+    offsets[p+1] = offsets[p]+piece.keys.size()-piece.shared.size();
+    shared_offsets[p+1] = shared_offsets[p]+piece.shared.size();
+  }
+  const int interior = offsets.back();
+  Array<Tuple<uint64_t,int,int>> order(shared_offsets.back(),uninit);
+  #pragma omp parallel for schedule(dynamic,16)
+  for (int p=0;p<kept.size();p++) {
+    auto& piece = pieces[p];
+    piece.ids.resize(piece.keys.size(),uninit);
+    piece.ids.fill(-1);
+    for (const int i : range(piece.shared.size())) {
+      const int v = piece.shared[i];
+      piece.ids[v] = -2;
+      order[shared_offsets[p]+i] = tuple(piece.keys[v],p,v);
+    }
+    int next = offsets[p];
+    for (auto& id : piece.ids)
+      if (id==-1)
+        id = next++;
+  }
+  std::sort(order.begin(),order.end(),[](const Tuple<uint64_t,int,int>& a, const Tuple<uint64_t,int,int>& b) {
+    return a.x<b.x;
+  });
+  int count = interior;
+  for (const int i : range(order.size()))
+    count += !i || order[i].x!=order[i-1].x;
+  Array<TV> X(count,uninit);
+  count = interior;
+  for (const int i : range(order.size())) {
+    const auto& piece = pieces[order[i].y];
+    const int v = order[i].z;
+    if (!i || order[i].x!=order[i-1].x)
+      X[count++] = piece.X[v];
+    piece.ids.const_cast_()[v] = count-1;
+  }
+  #pragma omp parallel for schedule(dynamic,16)
+  for (int p=0;p<kept.size();p++) {
+    const auto& piece = pieces[p];
+    for (const int v : range(piece.keys.size()))
+      if (piece.ids[v]<interior)
+        X[piece.ids[v]] = piece.X[v];
+  }
+
+  // Build the mesh in one pass
+  Array<int> face_offsets(kept.size()+1);
+  for (const int p : range(kept.size()))
+    face_offsets[p+1] = face_offsets[p]+pieces[p].tris.size();
+  Array<Vector<int,3>> tris(face_offsets.back(),uninit);
+  #pragma omp parallel for schedule(dynamic,16)
+  for (int p=0;p<kept.size();p++) {
+    const auto& m = pieces[p].ids;
+    for (const int f : range(pieces[p].tris.size())) {
+      const auto t = pieces[p].tris[f];
+      tris[face_offsets[p]+f] = vec(m[t.x],m[t.y],m[t.z]);
+    }
+  }
+  return tuple(new_<const TriangleTopology>(tris,X.size()),Field<const TV,VertexId>(X));
+}
+
+}
+using namespace geode;
+
+void wrap_mesh_implicit() {
+  GEODE_FUNCTION(mesh_implicit)
+}
@@ -0,0 +1,17 @@
+// Surface extraction from implicit surfaces
+#pragma once
+
+#include <geode/geometry/Implicit.h>
+#include <geode/mesh/TriangleTopology.h>
+namespace geode {
+
+// Mesh the zero level set of an implicit surface at resolution dx, using marching tetrahedra on the Kuhn
+// triangulation of a regular grid covering implicit.bounding_box().  The result is always manifold (with boundary
+// only where the surface leaves the grid).  Empty space is skipped using an octree of 8^3 cell bricks: a box is
+// discarded if |phi| at its center exceeds lipschitz times its half diagonal, so phi must be Lipschitz with that
+// constant.  Distances, including clamped ones such as SparseLevelSet, are 1-Lipschitz; pass lipschitz=inf to
+// disable culling for other implicits.  Bricks are processed in parallel, so phi must be thread safe.
+GEODE_EXPORT Tuple<Ref<const TriangleTopology>,Field<const Vector<real,3>,VertexId>>
+mesh_implicit(const Implicit<Vector<real,3>>& implicit, const real dx, const real lipschitz=1);
+
+}
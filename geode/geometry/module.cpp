@@ -19,5 +19,8 @@ void wrap_geometry() {
   GEODE_WRAP(bezier)
   GEODE_WRAP(segment)
   GEODE_WRAP(surface_levelset)
+  GEODE_WRAP(sparse_levelset)
   GEODE_WRAP(offset_mesh)
+  GEODE_WRAP(mesh_implicit)
+  GEODE_WRAP(simplify_arcs)
 }
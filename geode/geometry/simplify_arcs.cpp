@@ -2,7 +2,14 @@
 
 #include <geode/array/sort.h>
 #include <geode/exact/circle_csg.h>
+#include <geode/exact/circle_quantization.h>
+#include <geode/exact/PlanarArcGraph.h>
 #include <geode/geometry/arc_fitting.h>
+#include <geode/geometry/ArcSegment.h>
+#include <geode/geometry/BoxTree.h>
+#include <geode/geometry/traverse.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/openmp.h>
 
 #include <queue>
 namespace geode {
@@ -213,4 +220,148 @@ Nested<CircleArc> simplify_arcs(const Nested<const CircleArc> input, const real
   return result.freeze();
 }
 
+static constexpr auto PS = Pb::Implicit;
+
+// Approximate positions of vertices around faces of closed contours with winding number other than 0 or sign.  There are none if the
+// contours bound a valid region.
+static Array<Vec2> bad_vertices(const Quantizer<real,2>& quant, const Nested<const CircleArc> arcs, const int sign) {
+  Array<Vec2> result;
+  const auto g = quantize_circle_arcs<PS>(quant, arcs);
+  const auto& t = *g->topology;
+  if(!t.n_faces())
+    return result;
+  const auto depths = compute_winding_numbers(t, g->boundary_face(), g->edge_windings);
+  for(const FaceId f : t.faces()) {
+    if(depths[f] != 0 && depths[f] != sign) {
+      for(const BorderId b : t.face_borders(f))
+        for(const HalfedgeId h : t.border_edges(b))
+          result.append(quant.inverse(g->vertices.approx(g->src(h)).guess()));
+    }
+  }
+  return result;
+}
+
+static Nested<CircleArc> single_contour(const RawArray<const CircleArc> contour) {
+  Nested<CircleArc,false> result;
+  result.append(contour);
+  return result.freeze();
+}
+
+// Bounding boxes of the arcs of a closed contour from simplify_arcs that don't appear unchanged in the original.  Crossings between
+// unchanged arcs were already present in the original, so only these arcs can introduce new ones.
+static Array<Box<Vec2>> changed_arc_boxes(const RawArray<const CircleArc> original, const RawArray<const CircleArc> simple) {
+  Array<Box<Vec2>> result;
+  const int n = original.size(), m = simple.size();
+  int k = 0;
+  for(const int j : range(m)) {
+    // simplify_arcs only erases vertices, so simple is a subsequence of original
+    while(k < n && original[k].x != simple[j].x)
+      ++k;
+    const auto& next = simple[(j+1)%m];
+    if(k == n || original[k].q != simple[j].q || original[(k+1)%n].x != next.x)
+      result.append(arc_bounding_box(simple[j].x, next.x, simple[j].q));
+  }
+  return result;
+}
+
+namespace {
+// Marks contours with changed arcs near a point as no longer simplified
+struct RevertNear {
+  const BoxTree<Vec2>& tree;
+  RawArray<const int> arc_contours;
+  RawArray<bool> simplified;
+  const Box<Vec2> query;
+  int reverted;
+  bool cull(const int n) const { return !query.intersects(tree.boxes[n]); }
+  void leaf(const int n) {
+    for(const int a : tree.prims(n)) {
+      bool& s = simplified[arc_contours[a]];
+      if(s) {
+        s = false;
+        ++reverted;
+      }
+    }
+  }
+};
+} // anonymous namespace
+
+Nested<CircleArc> simplify_closed_arcs(const Nested<const CircleArc> arcs, const real tolerance) {
+  auto bounds = approximate_bounding_box(arcs);
+  if(bounds.empty()) bounds = Box<Vec2>::unit_box(); // We generate a non-degenerate box in case input was empty
+  const auto quant = make_arc_quantizer(bounds.thickened(tolerance));
+  // Vertices of bad faces lie on their arcs up to quantization error
+  const real slop = tolerance + 2*quant.inverse.unquantize_length(constructed_arc_endpoint_error_bound());
+  const int n = arcs.size();
+
+  // Simplify each contour on its own, retrying with smaller tolerances if it would intersect itself or flip orientation
+  vector<Array<const CircleArc>> contours(n);
+  Array<bool> simplified(n);
+  OmpExceptions errors;
+  #pragma omp parallel for schedule(dynamic,1)
+  for(int c=0;c<n;c++) errors.capture([&]{
+    const auto original = arcs[c];
+    const int s = int(sign(circle_arc_area(original)));
+    contours[c] = original.copy();
+    real t = tolerance;
+    for(int attempt = 0; attempt < 4; ++attempt, t *= .25) {
+      const auto simple = simplify_arcs(original, t, true);
+      if(simple.size() == original.size())
+        break; // Smaller tolerances won't do any better
+      if(int(sign(circle_arc_area(simple))) != s)
+        continue;
+      const auto changed = changed_arc_boxes(original, simple);
+      bool ok = true;
+      for(const auto& x : bad_vertices(quant, single_contour(simple), s))
+        for(const auto& box : changed)
+          ok &= !box.thickened(slop).lazy_inside(x);
+      if(ok) {
+        contours[c] = simple;
+        simplified[c] = true;
+        break;
+      }
+    }
+  });
+  errors.rethrow();
+
+  // Simplified contours may now cross their neighbors.  Any new crossing is a vertex of a face with bad winding lying on a changed arc,
+  // so we restore the simplified contours with changed arcs near such vertices until there are none left.
+  for(;;) {
+    Nested<CircleArc,false> result;
+    for(const auto& c : contours)
+      result.append(c);
+    const auto bad = bad_vertices(quant, result, 1);
+    Array<Box<Vec2>> arc_boxes;
+    Array<int> arc_contours;
+    if(bad.size()) {
+      for(const int c : range(n)) {
+        if(simplified[c]) {
+          for(const auto& box : changed_arc_boxes(arcs[c], contours[c])) {
+            arc_boxes.append(box);
+            arc_contours.append(c);
+          }
+        }
+      }
+    }
+    int reverted = 0;
+    if(arc_boxes.size()) {
+      const auto tree = new_<BoxTree<Vec2>>(arc_boxes, 1);
+      for(const auto& x : bad) {
+        RevertNear revert({*tree, arc_contours, simplified, Box<Vec2>(x).thickened(slop), 0});
+        single_traverse(*tree, revert);
+        reverted += revert.reverted;
+      }
+    }
+    if(!reverted)
+      return result.freeze();
+    for(const int c : range(n))
+      if(!simplified[c])
+        contours[c] = arcs[c].copy();
+  }
+}
+
 } // namespace geode
+using namespace geode;
+
+void wrap_simplify_arcs() {
+  GEODE_FUNCTION(simplify_closed_arcs)
+}
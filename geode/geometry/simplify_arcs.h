@@ -3,8 +3,14 @@
 namespace geode {
 
 // This will collapse arc segments if it can ensure that no point moves by more than max_allowed_change.
-// It currently doesn't try to refit q values or combine arcs that are nearly 'co-circular'
+// Pairs of arcs that are nearly 'co-circular' are merged into the single arc through all three of their endpoints.
 Array<CircleArc> simplify_arcs(const RawArray<const CircleArc> input, const real max_allowed_change, const bool is_closed);
 Nested<CircleArc> simplify_arcs(const Nested<const CircleArc> input, const real max_point_movement, const bool is_closed=false);
 
+// Simplify the closed contours of a region (such as the output of circle_arc_union or offset_arcs) using simplify_arcs, which merges
+// consecutive arcs that lie on nearly the same circle.  Crossings are checked with exact predicates: a contour that would cross itself is
+// retried with smaller tolerances, and contours that would cross their neighbors are left unchanged, so the result never overlaps itself
+// anywhere the input didn't.  Calling this between iterations keeps repeated offset_arcs from growing exponentially.
+Nested<CircleArc> simplify_closed_arcs(const Nested<const CircleArc> arcs, const real tolerance);
+
 } // namespace geode
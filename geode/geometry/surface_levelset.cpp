@@ -10,6 +10,7 @@
 #include <geode/array/ConstantMap.h>
 #include <geode/python/wrap.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/openmp.h>
 #include <limits>
 namespace geode {
 
@@ -32,9 +33,119 @@ static inline T lower_bound_sqr_phi(const Box<TV>& n1, const Box<TV>& n2) {
   return sqr_magnitude((n1-n2).clamp(TV()));
 }
 
+// Structure-of-arrays copy of the surface simplices in tree order (surface.p), so that the leaf kernel can compute
+// lower bounds on the squared distances from a point to a whole run of simplices at once.  The bounds are
+// computed branch free so that the lane loops vectorize.  They are conservative by a wide relative margin, so
+// culling with them never skips a simplex the exact Simplex::closest_point would have accepted.
+static const int lanes = 16;
+static const T slop = 1e-10; // Relative error allowance for the lower bounds
+
+template<int d> struct SimplexSoA;
+
+template<> struct SimplexSoA<1> {
+  Array<T> x0[3], e[3], inv_ee, scale;
+
+  SimplexSoA(const SimplexTree<TV,1>& surface) {
+    const int n = surface.p.size();
+    for (int a=0;a<3;a++) {
+      x0[a].resize(n,uninit);
+      e[a].resize(n,uninit);
+    }
+    inv_ee.resize(n,uninit);
+    scale.resize(n,uninit);
+    for (const int k : range(n)) {
+      const auto& S = surface.simplices[surface.p[k]];
+      const TV v = S.x1-S.x0;
+      for (int a=0;a<3;a++) {
+        x0[a][k] = S.x0[a];
+        e[a][k] = v[a];
+      }
+      const T ee = sqr_magnitude(v);
+      inv_ee[k] = ee ? 1/ee : 0;
+      scale[k] = ee;
+    }
+  }
+
+  void lower_bounds(const TV x, const int lo, const int n, T* bound) const {
+    #pragma omp simd
+    for (int i=0;i<n;i++) {
+      const int k = lo+i;
+      const T dx = x.x-x0[0][k], dy = x.y-x0[1][k], dz = x.z-x0[2][k];
+      const T t = max(T(0),min(T(1),(dx*e[0][k]+dy*e[1][k]+dz*e[2][k])*inv_ee[k]));
+      const T sd = sqr(dx-t*e[0][k])+sqr(dy-t*e[1][k])+sqr(dz-t*e[2][k]);
+      bound[i] = sd-slop*(dx*dx+dy*dy+dz*dz+scale[k]);
+    }
+  }
+};
+
+template<> struct SimplexSoA<2> {
+  // Vertex x0, edges e1 = x1-x0, e2 = x2-x0, e3 = x2-x1, and normal n = cross(e1,e2)
+  Array<T> x0[3], e1[3], e2[3], e3[3], n[3];
+  Array<T> d11, d12, d22, inv_det, inv11, inv22, inv33, inv_nn, scale;
+
+  SimplexSoA(const SimplexTree<TV,2>& surface) {
+    const int size = surface.p.size();
+    for (auto A : {x0,e1,e2,e3,n})
+      for (int a=0;a<3;a++)
+        A[a].resize(size,uninit);
+    for (auto A : {&d11,&d12,&d22,&inv_det,&inv11,&inv22,&inv33,&inv_nn,&scale})
+      A->resize(size,uninit);
+    for (const int k : range(size)) {
+      const auto& S = surface.simplices[surface.p[k]];
+      const TV u1 = S.x1-S.x0, u2 = S.x2-S.x0, u3 = S.x2-S.x1, un = cross(u1,u2);
+      for (int a=0;a<3;a++) {
+        x0[a][k] = S.x0[a];
+        e1[a][k] = u1[a];
+        e2[a][k] = u2[a];
+        e3[a][k] = u3[a];
+        n[a][k] = un[a];
+      }
+      const T a11 = sqr_magnitude(u1), a12 = dot(u1,u2), a22 = sqr_magnitude(u2), a33 = sqr_magnitude(u3),
+              det = a11*a22-sqr(a12), nn = sqr_magnitude(un);
+      d11[k] = a11;
+      d12[k] = a12;
+      d22[k] = a22;
+      inv_det[k] = det>1e-6*a11*a22 ? 1/det : 0; // Slivers have unreliable normals, so they are never culled
+      inv11[k] = a11 ? 1/a11 : 0;
+      inv22[k] = a22 ? 1/a22 : 0;
+      inv33[k] = a33 ? 1/a33 : 0;
+      inv_nn[k] = nn ? 1/nn : 0;
+      scale[k] = a11+a22;
+    }
+  }
+
+  void lower_bounds(const TV x, const int lo, const int size, T* bound) const {
+    #pragma omp simd
+    for (int i=0;i<size;i++) {
+      const int k = lo+i;
+      const T dx = x.x-x0[0][k], dy = x.y-x0[1][k], dz = x.z-x0[2][k];
+      const T de1 = dx*e1[0][k]+dy*e1[1][k]+dz*e1[2][k],
+              de2 = dx*e2[0][k]+dy*e2[1][k]+dz*e2[2][k];
+      // Near the interior of the triangle, distance to the plane is a lower bound.  Elsewhere the closest
+      // point is on an edge.
+      const T b1 = (d22[k]*de1-d12[k]*de2)*inv_det[k],
+              b2 = (d11[k]*de2-d12[k]*de1)*inv_det[k];
+      const bool inside = b1>=-1e-6 && b2>=-1e-6 && b1+b2<=1+1e-6;
+      const T sd_plane = sqr(dx*n[0][k]+dy*n[1][k]+dz*n[2][k])*inv_nn[k];
+      // Edges x0-x1 and x0-x2
+      const T t1 = max(T(0),min(T(1),de1*inv11[k])),
+              t2 = max(T(0),min(T(1),de2*inv22[k]));
+      const T sd1 = sqr(dx-t1*e1[0][k])+sqr(dy-t1*e1[1][k])+sqr(dz-t1*e1[2][k]),
+              sd2 = sqr(dx-t2*e2[0][k])+sqr(dy-t2*e2[1][k])+sqr(dz-t2*e2[2][k]);
+      // Edge x1-x2
+      const T fx = dx-e1[0][k], fy = dy-e1[1][k], fz = dz-e1[2][k];
+      const T t3 = max(T(0),min(T(1),(fx*e3[0][k]+fy*e3[1][k]+fz*e3[2][k])*inv33[k]));
+      const T sd3 = sqr(fx-t3*e3[0][k])+sqr(fy-t3*e3[1][k])+sqr(fz-t3*e3[2][k]);
+      const T sd = inside ? sd_plane : min(sd1,min(sd2,sd3));
+      bound[i] = inv_det[k] ? sd-slop*(dx*dx+dy*dy+dz*dz+scale[k]) : -inf;
+    }
+  }
+};
+
 template<int d> struct Helper {
   const ParticleTree<TV>& particles;
   const SimplexTree<TV,d>& surface;
+  const SimplexSoA<d>& soa;
   RawArray<T> sqr_phi_node;
   RawArray<CloseInfo<d>> info; // phi = sqr_phi, normal = delta
 
@@ -46,17 +157,25 @@ template<int d> struct Helper {
     if (pleaf && sleaf) { // Two leaves: compute all pairwise distances
       sqr_phi_node[pn] = 0;
       const auto particle_prims = particles.prims(pn);
-      const auto surface_prims = surface.prims(sn);
+      const auto surface_range = surface.ranges[sn];
+      T bound[lanes];
       for (const int p : particle_prims) {
         if (info[p].phi > lower_bound_sqr_phi(particles.X[p],sbox))
-          for (const int t : surface_prims) {
-            if (profile)
-              evaluation_count++;
-            const auto close = surface.simplices[t].closest_point(particles.X[p]);
-            const TV delta = particles.X[p] - close.x;
-            const T sd = sqr_magnitude(delta);
-            if (info[p].phi > sd)
-              info[p] = CloseInfo<d>({sd,delta,t,close.y});
+          for (int lo=surface_range.lo;lo<surface_range.hi;lo+=lanes) {
+            // Cull the run of simplices with the vectorized lower bounds, then evaluate survivors exactly in order
+            const int n = min(lanes,surface_range.hi-lo);
+            soa.lower_bounds(particles.X[p],lo,n,bound);
+            for (int i=0;i<n;i++)
+              if (info[p].phi > bound[i]) {
+                const int t = surface.p[lo+i];
+                if (profile)
+                  evaluation_count++;
+                const auto close = surface.simplices[t].closest_point(particles.X[p]);
+                const TV delta = particles.X[p] - close.x;
+                const T sd = sqr_magnitude(delta);
+                if (info[p].phi > sd)
+                  info[p] = CloseInfo<d>({sd,delta,t,close.y});
+              }
           }
         sqr_phi_node[pn] = max(sqr_phi_node[pn],info[p].phi);
       }
@@ -112,8 +231,31 @@ template<int d> void surface_levelset(const ParticleTree<TV>& particles, const S
   if (profile)
     evaluation_count = 0;
   const auto sqr_phi_node = constant_map(particles.nodes(),sqr_max_distance).copy();
-  if (particles.X.size() && surface.simplices.size())
-    Helper<d>({particles,surface,sqr_phi_node,info}).eval(0,0);
+  if (particles.X.size() && surface.simplices.size()) {
+    const SimplexSoA<d> soa(surface);
+    const Helper<d> helper({particles,surface,soa,sqr_phi_node,info});
+    // Split the particle tree into a fixed set of subtrees, independent of the thread count so that ties between
+    // equidistant simplices resolve the same way everywhere.  Each subtree writes only its own particles and nodes.
+    Array<int> roots(1);
+    for (bool split=true;split && roots.size()<256;) {
+      split = false;
+      Array<int> next;
+      for (const int n : roots) {
+        if (particles.is_leaf(n))
+          next.append(n);
+        else {
+          next.extend(particles.children(n));
+          split = true;
+        }
+      }
+      roots = next;
+    }
+    OmpExceptions errors;
+    #pragma omp parallel for schedule(dynamic,1)
+    for (int i=0;i<roots.size();i++)
+      errors.capture([&]{ helper.eval(roots[i],0); });
+    errors.rethrow();
+  }
   if (profile) {
     long slow_count = (long)particles.X.size()*surface.simplices.size();
     cout << "particles = "<<particles.X.size()<<", per particle "<<evaluation_count/particles.X.size()<<endl;
@@ -129,8 +271,10 @@ template<int d> void surface_levelset(const ParticleTree<TV>& particles, const S
                : (I.phi > epsilon) ? I.normal / I.phi
                                    : normal_flip(surface.simplices[I.simplex],I.normal);
     }
-  else // compute_signs
-    for (const int i : range(info.size())) {
+  else { // compute_signs
+    OmpExceptions errors;
+    #pragma omp parallel for schedule(dynamic,256)
+    for (int i=0;i<info.size();i++) errors.capture([&]{
       auto& I = info[i];
       I.phi = sqrt(I.phi);
       if ((I.simplex) < 0) // Parentheses needed for parse error in gcc 4.9
@@ -149,7 +293,9 @@ template<int d> void surface_levelset(const ParticleTree<TV>& particles, const S
           I.normal = normal_noflip(surface.simplices[I.simplex]);
         }
       }
-    }
+    });
+    errors.rethrow();
+  }
 }
 
 template<int d> Tuple<Array<T>,Array<TV>,Array<int>,Array<typename SimplexTree<TV,d>::Weights>>
@@ -12,6 +12,26 @@ def test_box_tree():
     tree = BoxTree(x,10)
     tree.check(x)
 
+def test_box_tree_split():
+  random.seed(10098331)
+  for n in 0,1,35,99,100,101,199,200,201,40000:
+    x = random.randn(n,3).astype(real)
+    box_tree_split_test(x,10)
+  # A slab spread along y, with a few outliers far away along x.  The outliers make x the longest axis, so median
+  # splits cut the slab into wide overlapping boxes, while the surface area heuristic splits it along y.
+  x = random.randn(1000,3)*(1,10,.1)
+  x[::100] = random.randn(10,3)*(100,1,1)
+  longest,sah = box_tree_split_test(x.astype(real),10)
+  print 'longest axis cost = %g, sah cost = %g'%(longest,sah)
+  assert sah<.75*longest
+
+def test_parallel_traverse():
+  random.seed(10098331)
+  for n in 0,1,35,201,5000:
+    x0 = random.randn(n,3).astype(real)
+    x1 = random.randn(n//2+1,3).astype(real)
+    parallel_traverse_test(x0,x1,4,.05)
+
 def test_particle_tree():
   random.seed(10098331)
   for n in 0,1,35,99,100,101,199,200,201:
@@ -30,6 +50,7 @@ def test_simplex_tree():
   hits = ray_traversal_test(tree,rays,1e-6)
   print 'rays = %d, hits = %d'%(rays,hits)
   assert hits==642
+  assert batch_ray_traversal_test(tree,rays,1e-6)==hits
 
 if __name__=='__main__':
   test_simplex_tree()
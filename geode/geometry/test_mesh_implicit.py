@@ -0,0 +1,38 @@
+#!/usr/bin/env python
+
+from __future__ import division
+from geode import *
+from geode.geometry.platonic import *
+
+def test_mesh_implicit():
+  center = asarray([.1,.2,.3])
+  for dx in .2,.05:
+    mesh,X = mesh_implicit(Sphere3d(center,1),dx)
+    assert mesh.is_manifold()
+    assert not mesh.has_boundary()
+    assert mesh.n_vertices-mesh.n_edges+mesh.n_faces==2
+    assert maxabs(magnitudes(X-center)-1) < dx*dx
+    volume = (dots(X[mesh.elements()[:,0]],cross(X[mesh.elements()[:,1]],X[mesh.elements()[:,2]]))/6).sum()
+    assert abs(volume-4/3*pi) < 4*dx*dx
+
+def test_mesh_sparse_levelset():
+  # Recover a sampled mesh
+  m,X = sphere_mesh(3)
+  levelset = SparseLevelSet(SimplexTree(m,X,4),.05,.2)
+  mesh,Y = mesh_implicit(levelset,.05)
+  assert mesh.is_manifold()
+  assert not mesh.has_boundary()
+  assert maxabs(magnitudes(Y)-1) < .02
+
+  # Culling empty bricks must not change the result, even though the band is narrower than a brick
+  mesh2,Y2 = mesh_implicit(levelset,.05,inf)
+  assert mesh2.n_faces==mesh.n_faces
+  assert all(sort(magnitudes(Y2))==sort(magnitudes(Y)))
+
+  # Batched evaluation agrees with pointwise evaluation
+  P = 1.5*random.randn(100,3)
+  assert all(levelset.phis(P)==[levelset.phi(p) for p in P])
+
+if __name__=='__main__':
+  test_mesh_implicit()
+  test_mesh_sparse_levelset()
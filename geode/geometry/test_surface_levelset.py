@@ -39,3 +39,53 @@ def test_surface_levelset():
     print 'i %d, phi %g, phi2 %g'%(i,phi[i],phi2[i])
   assert relative_error(abs(phi),phi2) < 1e-7
   assert all(magnitudes(cross(normal,normal2))<1e-7)
+
+def test_surface_levelset_degenerate():
+  # Zero area triangles (repeated and collinear vertices) must still be found through their edges
+  random.seed(127131)
+  mesh,X = sphere_mesh(2)
+  X = concatenate([X,[(0,0,2),(0,0,2),(0,0,3),(1,1,1),(2,2,2),(3,3,3)]])
+  n = len(X)
+  mesh = TriangleSoup(concatenate([mesh.elements,[(n-6,n-5,n-4),(n-3,n-2,n-1)]]).astype(int32))
+  surface = SimplexTree(mesh,X,4)
+  particles = ParticleTree(3*random.randn(2000,3),10)
+  phi,normal,triangles,weights = surface_levelset(particles,surface,inf,False)
+  phi2,normal2,_,_ = slow_surface_levelset(particles,surface)
+  assert relative_error(phi,phi2) < 1e-7
+
+def test_sparse_levelset():
+  random.seed(127132)
+  mesh,X = sphere_mesh(4)
+  surface = SimplexTree(mesh,X,4)
+  band = .2
+  levelset = SparseLevelSet(surface,.05,band)
+  print levelset
+  for x in 2*random.uniform(-1,1,size=(2000,3)):
+    phi = levelset.phi(x)
+    exact = magnitudes(x)-1
+    if abs(exact)<band-.05:
+      assert abs(phi-exact) < .005
+      assert magnitudes(levelset.normal(x)-normalized(x)) < .1
+    elif abs(exact)>band+.01:
+      assert phi==(-band if exact<0 else band)
+    assert levelset.lazy_inside(x)==(phi<=0)
+
+def test_sparse_levelset_hollow():
+  # A shell between spheres of radius 1 and 3.  The cavity is sealed off from the grid boundary but is outside.
+  random.seed(127133)
+  mesh,X = sphere_mesh(4)
+  tris = concatenate([mesh.elements,mesh.elements[:,::-1]+len(X)])
+  surface = SimplexTree(TriangleSoup(tris),concatenate([3*X,X]),4)
+  band = .2
+  levelset = SparseLevelSet(surface,.05,band)
+  assert levelset.phi(zeros(3))==band
+  assert not levelset.lazy_inside(zeros(3))
+  for x in 4*random.uniform(-1,1,size=(2000,3)):
+    phi = levelset.phi(x)
+    r = magnitudes(x)
+    exact = max(1-r,r-3)
+    if abs(exact)<band-.05:
+      assert abs(phi-exact) < .01
+    elif abs(exact)>band+.06:
+      assert phi==(-band if exact<0 else band)
+    assert levelset.lazy_inside(x)==(phi<=0)
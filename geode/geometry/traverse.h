@@ -7,6 +7,8 @@
 #include <geode/array/RawStack.h>
 #include <geode/array/view.h>
 #include <geode/geometry/BoxTree.h>
+#include <geode/utility/openmp.h>
+#include <vector>
 namespace geode {
 
 // Traverse one box tree.  There is no automatic culling: the visitor is responsible for everything.
@@ -72,14 +74,14 @@ double_traverse_helper(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visit
   double_traverse_helper(tree0,tree1,visitor,stack,0,0,thickness);
 }
 
-// Helper function traversing a hierarchy against itself starting at the roots.
+// Helper function traversing a hierarchy against itself starting at the given node, using a buffer of at least
+// 6*tree.depth ints for the stack.
 template<class Visitor,class Thickness,class TV> static void
-double_traverse_helper(const BoxTree<TV>& tree, Visitor&& visitor, Thickness thickness) {
-  if (!tree.nodes())
-    return;
+double_traverse_helper(const BoxTree<TV>& tree, Visitor&& visitor, Thickness thickness, RawArray<int> buffer,
+                       const int root) {
   const int internal = tree.leaves.lo;
-  RawStack<int> stack(GEODE_RAW_ALLOCA(6*tree.depth,int));
-  stack.push(0);
+  RawStack<int> stack(buffer);
+  stack.push(root);
   while (stack.size()) {
     const int n = stack.pop();
     if (visitor.cull(n))
@@ -95,6 +97,15 @@ double_traverse_helper(const BoxTree<TV>& tree, Visitor&& visitor, Thickness thi
   }
 }
 
+// Same as above, allocating the stack
+template<class Visitor,class Thickness,class TV> static void
+double_traverse_helper(const BoxTree<TV>& tree, Visitor&& visitor, Thickness thickness, const int root=0) {
+  if (!tree.nodes())
+    return;
+  const RawArray<int> buffer = GEODE_RAW_ALLOCA(6*tree.depth,int);
+  double_traverse_helper(tree,visitor,thickness,buffer,root);
+}
+
 // Traverse all intersecting pairs of leaf boxes between two distinct hierarchies.  Box/box intersection culling
 // is automatic, but the visitor can provide additional culling by returning true from visitor.cull(...).
 template<class Visitor,class TV> static void
@@ -123,4 +134,151 @@ template<class Visitor,class TV> static void double_traverse(const BoxTree<TV>&
   double_traverse_helper(tree,visitor,Zero());
 }
 
+// Parallel double traversal
+//
+// The top of the recursion is expanded serially into independent subtraversals, listed in the order the serial
+// traversal would visit them.  Each subtraversal then runs in parallel with its own visitor from new_visitor().
+// The visitors are returned in order, so concatenating their results reproduces the serial traversal exactly,
+// independent of the number of threads.  The expansion calls cull on a separate visitor, so cull should be pure.
+// An optional Scope is constructed on each thread for the duration of the traversal; e.g., exact predicates
+// use parallel_double_traverse<IntervalScope>(...) since the rounding mode is local to each thread.
+
+struct NoTraverseScope {};
+
+// A pending subtraversal: a pair of nodes, a node against itself, or a pair of leaves / a single leaf already checked
+struct TraverseTask {
+  enum Kind { Pair, Self, PairLeaf, SelfLeaf };
+  int n0, n1;
+  Kind kind;
+};
+
+// Expand a pair task into next, in the order the serial stack pops its children.  Returns false if culled.
+template<class Visitor,class Thickness,class TV> static bool
+expand_traverse_task(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor&& visitor, Thickness thickness,
+                     const TraverseTask t, std::vector<TraverseTask>& next, mpl::false_ self) {
+  const int internal0 = tree0.leaves.lo,
+            internal1 = tree1.leaves.lo;
+  if (visitor.cull(t.n0,t.n1) || !tree0.boxes[t.n0].intersects(tree1.boxes[t.n1],thickness))
+    return false;
+  if (t.n0 < internal0) {
+    for (const int c0 : {2*t.n0+2,2*t.n0+1}) {
+      if (t.n1 < internal1)
+        for (const int c1 : {2*t.n1+2,2*t.n1+1})
+          next.push_back({c0,c1,TraverseTask::Pair});
+      else
+        next.push_back({c0,t.n1,TraverseTask::Pair});
+    }
+  } else if (t.n1 < internal1) {
+    for (const int c1 : {2*t.n1+2,2*t.n1+1})
+      next.push_back({t.n0,c1,TraverseTask::Pair});
+  } else
+    next.push_back({t.n0,t.n1,TraverseTask::PairLeaf});
+  return true;
+}
+
+// Same as above, but for a traversal of a hierarchy against itself, which generates both pair and self tasks
+template<class Visitor,class Thickness,class TV> static bool
+expand_traverse_task(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor&& visitor, Thickness thickness,
+                     const TraverseTask t, std::vector<TraverseTask>& next, mpl::true_ self) {
+  if (t.kind==TraverseTask::Pair)
+    return expand_traverse_task(tree0,tree1,visitor,thickness,t,next,mpl::false_());
+  if (visitor.cull(t.n0))
+    return false;
+  if (t.n0 < tree0.leaves.lo) {
+    next.push_back({2*t.n0+1,2*t.n0+2,TraverseTask::Pair});
+    next.push_back({2*t.n0+2,-1,TraverseTask::Self});
+    next.push_back({2*t.n0+1,-1,TraverseTask::Self});
+  } else
+    next.push_back({t.n0,-1,TraverseTask::SelfLeaf});
+  return true;
+}
+
+// Expand tasks until there are enough to keep all threads busy, preserving serial visit order
+template<class Visitor,class Thickness,class TV,class Self> static std::vector<TraverseTask>
+parallel_traverse_tasks(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor&& visitor,
+                        Thickness thickness, const TraverseTask root, Self self) {
+  const int threads = omp_get_max_threads(),
+            enough = threads>1 ? 16*threads : 1;
+  std::vector<TraverseTask> tasks(1,root), next;
+  for (bool expanded=true;expanded && int(tasks.size())<enough;) {
+    expanded = false;
+    next.clear();
+    for (const auto& t : tasks) {
+      if (t.kind==TraverseTask::Pair || t.kind==TraverseTask::Self)
+        expanded |= expand_traverse_task(tree0,tree1,visitor,thickness,t,next,self);
+      else
+        next.push_back(t);
+    }
+    swap(tasks,next);
+  }
+  return tasks;
+}
+
+// Run a single task to completion.  buffer holds the traversal stack, and must have at least
+// 6*max(tree0.depth,tree1.depth) ints.
+template<class Visitor,class Thickness,class TV> static void
+run_traverse_task(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor& visitor, Thickness thickness,
+                  const TraverseTask t, RawArray<int> buffer, mpl::false_ self) {
+  if (t.kind==TraverseTask::PairLeaf)
+    visitor.leaf(t.n0,t.n1);
+  else
+    double_traverse_helper(tree0,tree1,visitor,RawStack<Vector<int,2>>(vector_view<2>(buffer)),t.n0,t.n1,thickness);
+}
+
+template<class Visitor,class Thickness,class TV> static void
+run_traverse_task(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor& visitor, Thickness thickness,
+                  const TraverseTask t, RawArray<int> buffer, mpl::true_ self) {
+  if (t.kind==TraverseTask::Self)
+    double_traverse_helper(tree0,visitor,thickness,buffer,t.n0);
+  else if (t.kind==TraverseTask::SelfLeaf)
+    visitor.leaf(t.n0);
+  else
+    run_traverse_task(tree0,tree1,visitor,thickness,t,buffer,mpl::false_());
+}
+
+template<class Scope,class NewVisitor,class Thickness,class TV,class Self> static auto
+parallel_double_traverse_helper(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, const NewVisitor& new_visitor,
+                                Thickness thickness, const TraverseTask root, Self self)
+  -> std::vector<decltype(new_visitor())> {
+  typedef decltype(new_visitor()) Visitor;
+  std::vector<Visitor> visitors;
+  if (!tree0.nodes() || !tree1.nodes())
+    return visitors;
+  const auto tasks = parallel_traverse_tasks(tree0,tree1,new_visitor(),thickness,root,self);
+  visitors.reserve(tasks.size());
+  for (int i=0;i<int(tasks.size());i++)
+    visitors.push_back(new_visitor());
+  OmpExceptions errors;
+  #pragma omp parallel
+  {
+    Scope scope;
+    Array<int> buffer(6*max(tree0.depth,tree1.depth),uninit); // Stack space for every task on this thread
+    #pragma omp for schedule(dynamic)
+    for (int i=0;i<int(tasks.size());i++) errors.capture([&]() {
+      run_traverse_task(tree0,tree1,visitors[i],thickness,tasks[i],buffer,self);
+    });
+  }
+  errors.rethrow();
+  return visitors;
+}
+
+// Parallel traversal of all intersecting pairs of leaf boxes between two distinct hierarchies.
+template<class Scope=NoTraverseScope,class NewVisitor,class TV> static auto
+parallel_double_traverse(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, const NewVisitor& new_visitor,
+                         typename TV::Scalar thickness=0) -> std::vector<decltype(new_visitor())> {
+  GEODE_ASSERT(&tree0 != &tree1,"Identical trees should use the dedicated routine below");
+  const TraverseTask root = {0,0,TraverseTask::Pair};
+  return thickness ? parallel_double_traverse_helper<Scope>(tree0,tree1,new_visitor,thickness,root,mpl::false_())
+                   : parallel_double_traverse_helper<Scope>(tree0,tree1,new_visitor,Zero(),root,mpl::false_());
+}
+
+// Parallel traversal of all intersecting pairs of leaf boxes between a hierarchy and itself.
+template<class Scope=NoTraverseScope,class NewVisitor,class TV> static auto
+parallel_double_traverse(const BoxTree<TV>& tree, const NewVisitor& new_visitor,
+                         typename TV::Scalar thickness=0) -> std::vector<decltype(new_visitor())> {
+  const TraverseTask root = {0,-1,TraverseTask::Self};
+  return thickness ? parallel_double_traverse_helper<Scope>(tree,tree,new_visitor,thickness,root,mpl::true_())
+                   : parallel_double_traverse_helper<Scope>(tree,tree,new_visitor,Zero(),root,mpl::true_());
+}
+
 }
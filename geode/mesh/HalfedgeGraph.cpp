@@ -851,5 +851,30 @@ Nested<HalfedgeId> extract_region(const HalfedgeGraph& g, const RawField<const b
   return contours.freeze();
 }
 
+Array<int> region_components(const HalfedgeGraph& g, const RawField<const bool, FaceId> interior_faces, const Nested<const HalfedgeId> contours) {
+  assert(g.n_faces() == interior_faces.size());
+  // Interior faces are connected across edges with interior on both sides.  Holes are borders of the face they
+  // are inside of, so they join the component of that face automatically.
+  UnionFind union_find(g.n_faces());
+  for(const EdgeId eid : g.edges()) {
+    const FaceId f0 = g.face(g.halfedge(eid, false));
+    const FaceId f1 = g.face(g.halfedge(eid, true));
+    if(f0.valid() && f1.valid() && interior_faces[f0] && interior_faces[f1])
+      union_find.merge(f0.idx(), f1.idx());
+  }
+  Array<int> component_of_root(g.n_faces());
+  component_of_root.fill(-1);
+  Array<int> result(contours.size(), uninit);
+  int n_components = 0;
+  for(const int i : range(contours.size())) {
+    assert(!contours[i].empty() && interior_faces[g.face(contours[i].front())]);
+    int& c = component_of_root[union_find.find(g.face(contours[i].front()).idx())];
+    if(c < 0)
+      c = n_components++;
+    result[i] = c;
+  }
+  return result;
+}
+
 } // namespace geode
 
@@ -275,4 +275,8 @@ Field<int, FaceId> compute_winding_numbers(const HalfedgeGraph& g, const FaceId
 // Requires face(he).valid() == face(reverse(he)).valid() and will ignore components with invalid faces
 Nested<HalfedgeId> extract_region(const HalfedgeGraph& g, const RawField<const bool, FaceId> interior_faces);
 
+// For each contour returned by extract_region, find which connected component of the region it bounds
+// Components are numbered in order of first appearance in contours
+Array<int> region_components(const HalfedgeGraph& g, const RawField<const bool, FaceId> interior_faces, const Nested<const HalfedgeId> contours);
+
 } // namespace geode
\ No newline at end of file
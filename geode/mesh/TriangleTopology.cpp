@@ -14,6 +14,8 @@
 #include <geode/structure/Hashtable.h>
 #include <geode/structure/Tuple.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/openmp.h>
+#include <geode/utility/time.h>
 #include <geode/vector/convert.h>
 #include <geode/structure/UnionFind.h>
 namespace geode {
@@ -271,14 +273,183 @@ FaceId TriangleTopology::internal_add_face(const Vector<VertexId,3> v) {
   return f;
 }
 
+// Add many faces in one pass, provided all their vertices are isolated.  Outgoing halfedges are bucketed by
+// source vertex, reverses are found by scanning the destination's bucket, and boundary loops are linked by
+// walking the triangle fans around each vertex.  Returns false without making any changes if the batch is
+// unsuitable or would not form a valid mesh, in which case the caller should add faces one at a time.
+static bool add_isolated_faces(TriangleTopology& mesh, RawArray<const Vector<int,3>> vs) {
+  const int nf = vs.size(),
+            nh = 3*nf,
+            nv = mesh.vertex_to_edge_.size();
+  if (!nf || nh/3 != nf)
+    return false;
+  const auto v2e = mesh.vertex_to_edge_.flat.raw();
+
+  // All vertices must be valid, isolated, and distinct within each face.  Bail if the vertices
+  // are spread too thinly over the existing mesh for bucketing to be cheap.
+  bool ok = true;
+  int lo = nv, hi = -1;
+  #pragma omp parallel for reduction(&&:ok) reduction(min:lo) reduction(max:hi)
+  for (int f=0;f<nf;f++) {
+    const auto v = vs[f];
+    for (int i=0;i<3;i++) {
+      ok = ok && unsigned(v[i])<unsigned(nv) && !v2e[v[i]].valid();
+      lo = min(lo,v[i]);
+      hi = max(hi,v[i]);
+    }
+    ok = ok && v.x!=v.y && v.y!=v.z && v.z!=v.x;
+  }
+  if (!ok || hi-lo >= 4*nh)
+    return false;
+  const int nr = hi-lo+1;
+
+  // Bucket halfedges by source vertex, storing (dst,halfedge) pairs
+  Array<int> start(nr+1);
+  for (const auto& v : vs)
+    for (int i=0;i<3;i++)
+      start[v[i]-lo+1]++;
+  for (const int v : range(nr))
+    start[v+1] += start[v];
+  Array<Vector<int,2>> out(nh,uninit);
+  {
+    Array<int> next = start.slice(0,nr).copy();
+    for (const int f : range(nf)) {
+      const auto v = vs[f]-lo;
+      out[next[v.x]++] = vec(v.y,3*f+0);
+      out[next[v.y]++] = vec(v.z,3*f+1);
+      out[next[v.z]++] = vec(v.x,3*f+2);
+    }
+  }
+
+  // Find reverses, and make sure no directed edge occurs twice.  Each pair is found from its lower vertex.
+  Array<int> reverse(nh,uninit);
+  reverse.fill(-1);
+  #pragma omp parallel for reduction(&&:ok)
+  for (int u=0;u<nr;u++) {
+    const auto out_u = out.slice(start[u],start[u+1]);
+    for (const int i : range(out_u.size())) {
+      const int w = out_u[i].x;
+      for (const int j : range(i))
+        ok = ok && out_u[j].x!=w;
+      if (u < w)
+        for (const auto& e : out.slice(start[w],start[w+1]))
+          if (e.x == u) {
+            reverse[out_u[i].y] = e.y;
+            reverse[e.y] = out_u[i].y;
+          }
+    }
+  }
+  if (!ok)
+    return false;
+
+  // Allocate boundary halfedges opposite unmatched halfedges, in halfedge order
+  Array<int> boundary(nh,uninit);
+  int nb = 0;
+  for (const int h : range(nh))
+    boundary[h] = reverse[h]<0 ? nb++ : -1;
+
+  // Walk the fans around each vertex.  The boundary opposite an unmatched h = u->w ends at u, and is followed by the
+  // boundary at the far end of some fan around u, with fans chained into a single cycle.  Every vertex must be either
+  // interior with a single closed fan, or a union of open fans; anything else (e.g., a closed fan plus extra triangles)
+  // is left to add_face to reject.
+  Array<int> next_boundary(nb,uninit),
+             vertex_edge(nr,uninit); // Boundary b is stored as -1-b
+
+  #pragma omp parallel for reduction(&&:ok)
+  for (int u=0;u<nr;u++) {
+    const int degree = start[u+1]-start[u];
+    if (!ok || !degree)
+      continue;
+    const auto prev = [](const int e) { return e%3==0 ? e+2 : e-1; };
+    int covered = 0, edge = -1, last = -1;
+    bool open = false;
+    for (const auto& o : out.slice(start[u],start[u+1])) {
+      const int h = o.y;
+      if (reverse[h] >= 0)
+        continue;
+      int e = h, n = 1;
+      while (reverse[prev(e)]>=0 && n<=degree) {
+        e = reverse[prev(e)];
+        n++;
+      }
+      // Link the previous fan's incoming boundary to this fan's outgoing boundary, so that all fans
+      // around u are reachable by swinging.
+      const int p = prev(e);
+      if (!open)
+        edge = boundary[p];
+      else
+        next_boundary[boundary[last]] = boundary[p];
+      last = h;
+      open = true;
+      covered += n;
+    }
+    if (open)
+      next_boundary[boundary[last]] = edge;
+    else { // Interior vertex
+      edge = out[start[u]].y;
+      for (int e=edge;covered<=degree;) {
+        covered++;
+        e = reverse[prev(e)];
+        if (e<0 || e==edge)
+          break;
+      }
+    }
+    vertex_edge[u] = open ? -1-edge : edge;
+    ok = ok && covered==degree;
+  }
+  if (!ok)
+    return false;
+
+  // All checks have passed, so fill in the new faces, boundaries, and vertex to edge pointers
+  const int f0 = mesh.faces_.size(),
+            b0 = mesh.boundaries_.size();
+  const auto interior = [=](const int h) { return HalfedgeId(3*f0+h); };
+  const auto exterior = [=](const int b) { return HalfedgeId(-1-b0-b); };
+  auto& faces = const_cast_(mesh.faces_).const_cast_().flat;
+  auto& boundaries = const_cast_(mesh.boundaries_).const_cast_();
+  faces.resize(f0+nf,uninit);
+  boundaries.resize(b0+nb,uninit);
+  #pragma omp parallel for
+  for (int f=0;f<nf;f++) {
+    auto& F = faces[f0+f];
+    for (int i=0;i<3;i++) {
+      const int h = 3*f+i,
+                b = boundary[h];
+      F.vertices[i] = VertexId(vs[f][i]);
+      if (b < 0)
+        F.neighbors[i] = interior(reverse[h]);
+      else {
+        F.neighbors[i] = exterior(b);
+        auto& B = boundaries[b0+b];
+        B.src = VertexId(vs[f][i==2?0:i+1]);
+        B.reverse = interior(h);
+        B.next = exterior(next_boundary[b]);
+        boundaries[b0+next_boundary[b]].prev = exterior(b);
+      }
+    }
+  }
+  auto& vertex_to_edge = const_cast_(mesh.vertex_to_edge_).const_cast_().flat;
+  #pragma omp parallel for
+  for (int u=0;u<nr;u++)
+    if (start[u] < start[u+1]) {
+      const int e = vertex_edge[u];
+      vertex_to_edge[lo+u] = e>=0 ? interior(e) : exterior(-1-e);
+    }
+  const_cast_(mesh.n_faces_) += nf;
+  const_cast_(mesh.n_boundary_edges_) += nb;
+  return true;
+}
+
 FaceId TriangleTopology::internal_add_faces(RawArray<const Vector<int,3>> vs) {
-  // TODO: We desperately need a batch insertion routine.
   if (vs.empty()) {
     return FaceId();
   } else {
     FaceId first(faces_.size());
-    for (auto& v : vs)
-      internal_add_face(Vector<VertexId,3>(v));
+    // If the batch can't be linked in one pass, add faces one at a time.  This either succeeds
+    // or throws the appropriate error.
+    if (!add_isolated_faces(*this,vs))
+      for (auto& v : vs)
+        internal_add_face(Vector<VertexId,3>(v));
     return first;
   }
 }
@@ -1671,6 +1842,131 @@ void MutableTriangleTopology::permute_vertices(RawArray<const int> permutation,
     inplace_partial_permute(s,permutation,work);
 }
 
+void MutableTriangleTopology::permute_faces(RawArray<const int> permutation, bool check) {
+  GEODE_ASSERT(n_faces()==permutation.size());
+  GEODE_ASSERT(n_faces()==faces_.size()); // Require no erased faces
+
+  // Permute faces_ out of place
+  Array<FaceInfo> new_faces(faces_.size(),uninit);
+  if (check) {
+    Array<bool> seen(faces_.size());
+    for (const int f : range(faces_.size())) {
+      const int pf = permutation[f];
+      GEODE_ASSERT(seen.valid(pf) && !seen[pf]);
+      seen[pf] = true;
+      new_faces[pf] = faces_.flat[f];
+    }
+  } else
+    for (const int f : range(faces_.size()))
+      new_faces[permutation[f]] = faces_.flat[f];
+  mutable_faces_.flat = new_faces;
+
+  // Interior halfedge ids move with their faces, boundary ids stay put
+  const auto permute = [permutation](HalfedgeId& h) {
+    if (h.id>=0)
+      h = HalfedgeId(3*permutation[h.id/3]+h.id%3);
+  };
+  for (auto& f : mutable_faces_.flat)
+    for (auto& h : f.neighbors)
+      permute(h);
+  for (auto& h : mutable_vertex_to_edge_.flat)
+    if (h.id!=erased_id)
+      permute(h);
+  for (auto& b : mutable_boundaries_)
+    if (b.src.id!=erased_id)
+      permute(b.reverse);
+
+  // Permute fields
+  Array<char> work;
+  for (auto& s : face_fields)
+    inplace_partial_permute(s,permutation,work);
+  for (auto& s : halfedge_fields)
+    inplace_partial_permute(s,permutation,work,3);
+}
+
+Vector<Array<int>,3> MutableTriangleTopology::reorder_for_locality(const int cache_size) {
+  GEODE_ASSERT(cache_size>0);
+  const auto perms = collect_garbage();
+  const int nv = n_vertices(),
+            nf = n_faces();
+
+  // Tipsify: emit the fan around the current vertex, then continue from a recently used vertex that is
+  // likely still in cache and still has faces left, falling back to a stack of recent vertices and finally
+  // to the lowest numbered vertex with faces left.
+  Array<int> vertex_order(nv,uninit), face_order(nf,uninit), live(nv), cache_time(nv);
+  vertex_order.fill(-1);
+  face_order.fill(-1);
+  for (const auto& f : faces_.flat)
+    for (const auto v : f.vertices)
+      live[v.id]++;
+  Array<VertexId> fan, dead_end;
+  int next_vertex = 0, next_face = 0,
+      time = cache_size+1,
+      cursor = 0;
+  for (;;) {
+    VertexId v;
+    int best = -1;
+    for (const auto u : fan)
+      if (live[u.id]) {
+        // Prefer vertices that will still be in cache after their remaining faces are emitted, and among those the oldest
+        const int age = time-cache_time[u.id],
+                  priority = age+2*live[u.id]<=cache_size ? age : 0;
+        if (best<priority) {
+          best = priority;
+          v = u;
+        }
+      }
+    while (!v.valid() && dead_end.size()) {
+      const auto u = dead_end.pop();
+      if (live[u.id])
+        v = u;
+    }
+    if (!v.valid()) {
+      while (cursor<nv && !live[cursor])
+        cursor++;
+      if (cursor==nv)
+        break;
+      v = VertexId(cursor);
+    }
+
+    // Emit all remaining faces around v
+    fan.clear();
+    for (const auto e : outgoing(v)) {
+      const auto f = face(e);
+      if (f.valid() && face_order[f.id]<0) {
+        face_order[f.id] = next_face++;
+        for (const auto u : faces_[f].vertices) {
+          if (vertex_order[u.id]<0)
+            vertex_order[u.id] = next_vertex++;
+          fan.append(u);
+          dead_end.append(u);
+          live[u.id]--;
+          if (time-cache_time[u.id]>cache_size)
+            cache_time[u.id] = time++;
+        }
+      }
+    }
+  }
+  GEODE_ASSERT(next_face==nf);
+
+  // Isolated vertices go at the end
+  for (auto& v : vertex_order)
+    if (v<0)
+      v = next_vertex++;
+
+  permute_vertices(vertex_order);
+  permute_faces(face_order);
+
+  // Compose with the garbage collection permutations
+  for (auto& v : perms[0])
+    if (v>=0)
+      v = vertex_order[v];
+  for (auto& f : perms[1])
+    if (f>=0)
+      f = face_order[f];
+  return perms;
+}
+
 // erase the given vertex. erases all incident faces. If erase_isolated is true, also erase other vertices that are now isolated.
 void MutableTriangleTopology::erase(VertexId id, bool erase_isolated) {
   // TODO: Make a better version of this. For now, just erase all incident faces
@@ -2202,6 +2498,34 @@ static void corner_mesh_destruction_test(MutableTriangleTopology& mesh, const ui
   }
 }
 
+// Time a few common traversals, for measuring the effect of reorder_for_locality.
+// Returns seconds per iteration of a full outgoing sweep, per-vertex normals, and face_tree construction.
+static Vector<real,3> corner_traversal_benchmark(const MutableTriangleTopology& mesh, RawArray<const TV3> X, const int iters) {
+  GEODE_ASSERT(X.size()==mesh.vertex_to_edge_.size() && iters>0);
+  const Field<const TV3,VertexId> XF(X.copy());
+  Vector<real,3> times;
+  int sum = 0;
+  real t = get_time();
+  for (int i=0;i<iters;i++)
+    for (const auto v : mesh.vertices())
+      for (const auto e : mesh.outgoing(v))
+        sum += mesh.dst(e).id;
+  times[0] = get_time()-t;
+  t = get_time();
+  TV3 total;
+  for (int i=0;i<iters;i++)
+    for (const auto v : mesh.vertices())
+      total += mesh.normal(XF,v);
+  times[1] = get_time()-t;
+  t = get_time();
+  for (int i=0;i<iters;i++)
+    sum += mesh.face_tree(XF).x->nodes();
+  times[2] = get_time()-t;
+  static volatile real sink GEODE_UNUSED;
+  sink = sum+total.x; // Keep the loops from being optimized away
+  return times/iters;
+}
+
 static string id_error(const TriangleTopology& mesh, const VertexId x) {
   return x.id==invalid_id              ? "invalid vertex id"
        : x.id==erased_id               ? "erased vertex id"
@@ -2536,12 +2860,15 @@ void wrap_corner_mesh() {
       .GEODE_METHOD_2("halfedge_field",halfedge_field_py)
       #endif
       .GEODE_METHOD(permute_vertices)
+      .GEODE_METHOD(permute_faces)
+      .GEODE_METHOD(reorder_for_locality)
       ;
   }
   // For testing purposes
   GEODE_FUNCTION(corner_random_edge_flips)
   GEODE_FUNCTION(corner_random_face_splits)
   GEODE_FUNCTION(corner_mesh_destruction_test)
+  GEODE_FUNCTION(corner_traversal_benchmark)
 
   GEODE_PYTHON_RANGE(TriangleTopologyIncoming, "IncomingHalfedgeIter")
   GEODE_PYTHON_RANGE(TriangleTopologyOutgoing, "OutgoingHalfedgeIter")
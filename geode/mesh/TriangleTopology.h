@@ -21,6 +21,10 @@ struct TriangleTopologyIncoming;
 template<class Id> struct TriangleTopologyIter;
 class MutableTriangleTopology;
 
+// Native binary mesh I/O (see io.h), declared here so that MutableTriangleTopology can befriend it
+GEODE_EXPORT void write_native_mesh(const string& filename, const MutableTriangleTopology& mesh);
+GEODE_EXPORT Ref<MutableTriangleTopology> read_native_mesh(const string& filename);
+
 // A TriangleTopology consists of vertices and faces connected into an oriented manifold,
 // plus special boundary halfedges along each boundary curve.  Treating boundary
 // halfedges specially removes a bit of the elegance of the corner mesh, but has the
@@ -65,7 +69,6 @@ class MutableTriangleTopology;
 // should go through the high level interface.
 //
 // TODO:
-// - Make add_faces that actually batch inserts.
 // - Make a more efficient version of erased(VertexId) and erase(HalfedgeId)
 // - Check in add_face/add_vertex whether we exceed the data structure limits.
 // - Make a field class for boundary halfedges
@@ -407,6 +410,10 @@ protected:
                      id_to_halfedge_field;
   int next_field_id;
 
+  // The native file format stores the flat arrays and fields directly
+  friend void write_native_mesh(const string& filename, const MutableTriangleTopology& mesh);
+  friend Ref<MutableTriangleTopology> read_native_mesh(const string& filename);
+
   GEODE_CORE_EXPORT MutableTriangleTopology();
   GEODE_CORE_EXPORT MutableTriangleTopology(const TriangleTopology& mesh, bool copy = false);
   GEODE_CORE_EXPORT MutableTriangleTopology(const MutableTriangleTopology& mesh, bool copy = false);
@@ -531,6 +538,15 @@ public:
   // Permute vertices: vertex v becomes vertex permutation[v]
   GEODE_CORE_EXPORT void permute_vertices(RawArray<const int> permutation, bool check=false);
 
+  // Permute faces: face f becomes face permutation[f], and halfedge 3f+i becomes 3*permutation[f]+i
+  GEODE_CORE_EXPORT void permute_faces(RawArray<const int> permutation, bool check=false);
+
+  // Collect garbage, then renumber faces and vertices for memory locality of traversals, using the vertex
+  // cache ordering of Sander et al., "Fast triangle reordering for vertex locality and reduced overdraw" (Tipsify).
+  // Vertices are numbered in order of first use by the new face order.  All fields are permuted.
+  // Returns permutations for vertices, faces, and boundary halfedges as in collect_garbage.
+  GEODE_CORE_EXPORT Vector<Array<int>,3> reorder_for_locality(const int cache_size=16);
+
   // Add another TriangleTopology, assuming the vertex sets are disjoint.
   // Returns the offsets of the other vertex, face, and boundary ids in the new arrays.
   GEODE_CORE_EXPORT Vector<int,3> add(const MutableTriangleTopology& other);
@@ -34,6 +34,12 @@ def loop_subdivide(mesh,X,steps=1,corners=zeros(0,dtype=int32)):
     X = subdivide.loop_subdivide(X)
   return mesh,X
 
+def read_soup(filename,deduplicate=True):
+  return geode_wrap.read_soup(filename,deduplicate)
+
+def read_polygon_soup(filename,deduplicate=True):
+  return geode_wrap.read_polygon_soup(filename,deduplicate)
+
 def read_obj(file):
   """Parse an obj file into a mesh and associated properties.
   Returns (mesh,props) where mesh is a PolygonSoup, and props is a dictionary containing some of X,normals,texcoord,material,face_normals,face_texcoords
@@ -181,8 +187,8 @@ def mesh_lower_hull(mesh, up, offset, draft_angle = 0., division_angle = 30./180
 def mesh_offset(mesh, offset):
   return meshify(*rough_offset_mesh(mesh, mesh.vertex_field(vertex_position_id), offset))
 
-def decimate(mesh,X,distance,max_angle=pi/2,min_vertices=-1,boundary_distance=0):
-  return geode_wrap.decimate(mesh,X,distance,max_angle,min_vertices,boundary_distance)
+def decimate(mesh,X,distance,max_angle=pi/2,min_vertices=-1,boundary_distance=0,parallel=False):
+  return geode_wrap.decimate(mesh,X,distance,max_angle,min_vertices,boundary_distance,parallel)
 
 def simplify(mesh,X,distance,max_angle=pi/2,min_vertices=-1,boundary_distance=0):
   return geode_wrap.simplify(mesh,X,distance,max_angle,min_vertices,boundary_distance)
@@ -6,6 +6,7 @@
 #include <geode/mesh/quadric.h>
 #include <geode/python/wrap.h>
 #include <geode/structure/Heap.h>
+#include <geode/utility/openmp.h>
 
 namespace geode {
 
@@ -177,7 +178,8 @@ static CollapseRank collapse_rank(const MutableTriangleTopology& mesh, const Hal
 }
 
 template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(MutableTriangleTopology& mesh, const TField& X,
-                      const T distance, const T max_angle, const int min_vertices, const T boundary_distance) {
+                      const T distance, const T max_angle, const int min_vertices, const T boundary_distance,
+                      const bool parallel=false) {
   if (mesh.n_vertices() <= min_vertices)
     return;
 
@@ -288,12 +290,27 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
   //   It might be faster to maintain a heap of halfedges only tracking error from quadrics so that normals and boundary distances don't get evaluated as often
   //   Need to be careful that an invalid collapse with a lower error doesn't hide another valid collapse
 
+  // Evaluate best_collapse for a list of vertices in parallel.  best_collapse only reads the mesh, so this is safe.
+  Array<Tuple<CollapsePriority,VertexId>> best;
+  const auto best_collapses = [&best,best_collapse](RawArray<const VertexId> vs) {
+    best.resize(vs.size(),uninit);
+    OmpExceptions errors;
+    #pragma omp parallel for schedule(dynamic,256)
+    for (int i=0;i<vs.size();i++)
+      errors.capture([&]{ best[i] = best_collapse(vs[i]); });
+    errors.rethrow();
+  };
+
   // Initialize quadrics and heap
   VertexHeap heap(mesh.allocated_vertices());
-  for (const auto v : mesh.vertices()) {
-    const auto qe = best_collapse(v);
-    if (qe.y.valid())
-      heap.inv_heap[v] = heap.heap.append(tuple(v,qe.x,qe.y));
+  {
+    Array<VertexId> vs;
+    for (const auto v : mesh.vertices())
+      vs.append(v);
+    best_collapses(vs);
+    for (const int i : range(vs.size()))
+      if (best[i].y.valid())
+        heap.inv_heap[vs[i]] = heap.heap.append(tuple(vs[i],best[i].x,best[i].y));
   }
   heap.make();
 
@@ -308,6 +325,77 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
 
   Array<VertexId> dirty;
 
+  if (parallel && !splitting_enabled(reduce_mode)) {
+    // Collapse in rounds.  Each round pops a batch of candidates from the heap in priority order and accepts those
+    // whose closed one-rings are disjoint from all previously accepted ones.  A collapse only changes faces around
+    // its source vertex, so accepted collapses can't invalidate each other.  The collapses themselves are cheap and
+    // applied in priority order; the expensive reevaluation of the affected vertices runs in parallel.
+    Field<int,VertexId> claimed(mesh.allocated_vertices()), touched(mesh.allocated_vertices());
+    Array<Tuple<VertexId,CollapsePriority,VertexId>> accepted, deferred;
+    for (int round=1;heap.size();round++) {
+      // Smaller batches follow the serial collapse order more closely
+      const int batch = heap.size()/8+1;
+      for (int i=0;i<batch && heap.size();i++) {
+        const auto c = heap.heap[0];
+        heap.pop();
+        bool free = claimed[c.x]!=round;
+        if (free)
+          for (const auto e : mesh.outgoing(c.x))
+            if (claimed[mesh.dst(e)]==round) {
+              free = false;
+              break;
+            }
+        if (!free) {
+          deferred.append(c);
+          continue;
+        }
+        claimed[c.x] = round;
+        for (const auto e : mesh.outgoing(c.x))
+          claimed[mesh.dst(e)] = round;
+        accepted.append(c);
+      }
+
+      // Apply collapses, collecting vertices whose best collapse may have changed
+      bool done = false;
+      for (const auto& c : accepted) {
+        const auto e = mesh.halfedge(c.x,c.z);
+        assert(e.valid() && mesh.is_collapse_safe(e));
+        mesh.unsafe_collapse(e);
+        if (mesh.n_vertices() <= min_vertices) {
+          done = true;
+          break;
+        }
+        const auto mark = [&](const VertexId v) {
+          if (touched[v]!=round) {
+            touched[v] = round;
+            dirty.append(v);
+          }
+        };
+        mark(c.z);
+        for (const auto e : mesh.outgoing(c.z))
+          mark(mesh.dst(e));
+      }
+      if (done)
+        break;
+
+      // Untouched candidates go back as is, and everything touched is reevaluated
+      for (const auto& c : deferred)
+        if (touched[c.x]!=round)
+          heap.set(c.x,c.y,c.z);
+      best_collapses(dirty);
+      for (const int i : range(dirty.size())) {
+        if (best[i].y.valid())
+          heap.set(dirty[i],best[i].x,best[i].y);
+        else
+          heap.erase(dirty[i]);
+      }
+      accepted.clear();
+      deferred.clear();
+      dirty.clear();
+    }
+    return;
+  }
+
   // Repeatedly collapse the best vertex
   while (heap.size()) {
     const CollapseRank rank = heap.heap[0].y.rank;
@@ -381,10 +469,10 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
 
 Tuple<Ref<const TriangleTopology>,Field<const TV,VertexId>>
 decimate(const TriangleTopology& mesh, RawField<const TV,VertexId> X,
-         const T distance, const T max_angle, const int min_vertices, const T boundary_distance) {
+         const T distance, const T max_angle, const int min_vertices, const T boundary_distance, const bool parallel) {
   const auto rmesh = mesh.mutate();
   const auto rX = X.copy();
-  decimate_inplace(rmesh,rX,distance,max_angle,min_vertices,boundary_distance);
+  decimate_inplace(rmesh,rX,distance,max_angle,min_vertices,boundary_distance,parallel);
   return Tuple<Ref<const TriangleTopology>,Field<const TV,VertexId>>(rmesh,rX);
 }
 
@@ -393,8 +481,9 @@ void decimate_inplace(MutableTriangleTopology& mesh,
                  const real distance,
                  const real max_angle,
                  const int min_vertices,
-                 const real boundary_distance) {
-  mesh_reduce_helper<ReduceMode::decimate_only>(mesh, X, distance, max_angle, min_vertices, boundary_distance);
+                 const real boundary_distance,
+                 const bool parallel) {
+  mesh_reduce_helper<ReduceMode::decimate_only>(mesh, X, distance, max_angle, min_vertices, boundary_distance, parallel);
 }
 
 void simplify_inplace_deprecated(MutableTriangleTopology& mesh,
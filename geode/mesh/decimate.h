@@ -10,7 +10,8 @@ decimate(const TriangleTopology& mesh,
          const real distance,             // (Very) approximate distance between original and decimation
          const real max_angle=pi/2,       // Max normal angle change in radians for one decimation step
          const int min_vertices=-1,       // Stop if we decimate down to this many vertices (-1 for no limit)
-         const real boundary_distance=0); // How far we're allowed to move the boundary
+         const real boundary_distance=0,  // How far we're allowed to move the boundary
+         const bool parallel=false);      // Collapse independent batches of edges, reevaluating in parallel (see decimate.cpp)
 
 GEODE_CORE_EXPORT void
 decimate_inplace(MutableTriangleTopology& mesh,
@@ -18,7 +19,8 @@ decimate_inplace(MutableTriangleTopology& mesh,
                  const real distance,             // (Very) approximate distance between original and decimation
                  const real max_angle=pi/2,       // Max normal angle change in radians for one decimation step
                  const int min_vertices=-1,       // Stop if we decimate down to this many vertices (-1 for no limit)
-                 const real boundary_distance=0); // How far we're allowed to move the boundary
+                 const real boundary_distance=0,  // How far we're allowed to move the boundary
+                 const bool parallel=false);      // Collapse independent batches of edges, reevaluating in parallel
 
 GEODE_CORE_EXPORT Tuple<Ref<const TriangleTopology>,Field<const Vector<real,3>,VertexId>>
 simplify_deprecated(const TriangleTopology& mesh,
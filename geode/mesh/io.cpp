@@ -8,8 +8,16 @@
 #include <geode/python/wrap.h>
 #include <geode/utility/endian.h>
 #include <geode/utility/function.h>
+#include <geode/utility/openmp.h>
 #include <geode/utility/path.h>
+#include <algorithm>
 #include <errno.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 namespace geode {
 
 typedef real T;
@@ -41,15 +49,75 @@ struct File {
     return f;
   }
 };
+
+// A view of an entire file.  Where possible the file is memory mapped, so that large meshes are parsed in place
+// without first being copied into memory.  If writable, the mapping is copy on write: changes are private and never
+// reach the file.
+struct MappedFile {
+  const char* data;
+  size_t size;
+#ifdef _WIN32
+private:
+  Array<char> buffer;
+public:
+#endif
+
+  MappedFile(const string& filename, const bool writable=false)
+    : data(0), size(0) {
+#ifdef _WIN32
+    File f(filename,"rb");
+    fseek(f,0,SEEK_END);
+    const long n = ftell(f);
+    fseek(f,0,SEEK_SET);
+    buffer.resize(n,uninit);
+    if (fread(buffer.data(),1,n,f) < size_t(n))
+      throw IOError(format("failed to read '%s': %s",filename,strerror(errno)));
+    data = buffer.data();
+    size = n;
+#else
+    const int fd = open(filename.c_str(),O_RDONLY);
+    if (fd < 0)
+      throw IOError(format("can't open '%s' for reading: %s",filename,strerror(errno)));
+    struct stat st;
+    if (fstat(fd,&st) < 0) {
+      const int error = errno;
+      close(fd);
+      throw IOError(format("can't stat '%s': %s",filename,strerror(error)));
+    }
+    size = st.st_size;
+    if (size) {
+      void* const p = mmap(0,size,writable ? PROT_READ|PROT_WRITE : PROT_READ,MAP_PRIVATE,fd,0);
+      const int error = errno;
+      close(fd);
+      if (p == MAP_FAILED)
+        throw IOError(format("can't map '%s': %s",filename,strerror(error)));
+      data = static_cast<const char*>(p);
+    } else
+      close(fd);
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  void operator=(const MappedFile&) = delete;
+
+  ~MappedFile() {
+#ifndef _WIN32
+    if (size)
+      munmap(const_cast<char*>(data),size);
+#endif
+  }
+
+  const char* end() const {
+    return data+size;
+  }
+};
 }
 
 // Determine whether a file is probably binary or ascii
-static bool is_binary(const string& filename) {
-  File f(filename,"rb");
-  char data[512];
-  const int n = int(fread(data,1,sizeof(data),f));
-  for (int i=0;i<n;i++)
-    if (!isascii(data[i]))
+static bool is_binary(const MappedFile& file) {
+  const size_t n = min(file.size,size_t(512));
+  for (size_t i=0;i<n;i++)
+    if (!isascii(file.data[i]))
       return true;
   return false;
 }
@@ -60,6 +128,58 @@ static const char* skip_white(const char* p) {
   return p;
 }
 
+// Deduplicate points in parallel, numbering unique points in order of first appearance exactly as a serial
+// pass would.  Points are sharded by hash so that each shard is deduplicated independently.  Returns the
+// unique points and the index of each input point among them.
+template<class TP> static Tuple<Array<TP>,Array<int>> parallel_deduplicate(RawArray<const TP> points) {
+  const int n = points.size(),
+            shards = 256,
+            blocks = 4*omp_get_max_threads();
+
+  // Stable counting sort by shard.  Shards use high hash bits, since Hashtable uses the low ones.
+  Array<uint8_t> shard(n,uninit);
+  Array<int> offsets(blocks*shards);
+  #pragma omp parallel for
+  for (int b=0;b<blocks;b++)
+    for (const int i : partition_loop(n,blocks,b)) {
+      const int s = unsigned(hash(points[i]))>>24;
+      shard[i] = s;
+      offsets[b*shards+s]++;
+    }
+  Array<int> shard_start(shards+1,uninit);
+  int total = 0;
+  for (const int s : range(shards)) {
+    shard_start[s] = total;
+    for (const int b : range(blocks)) {
+      const int count = offsets[b*shards+s];
+      offsets[b*shards+s] = total;
+      total += count;
+    }
+  }
+  shard_start[shards] = total;
+  Array<int> order(n,uninit);
+  #pragma omp parallel for
+  for (int b=0;b<blocks;b++)
+    for (const int i : partition_loop(n,blocks,b))
+      order[offsets[b*shards+shard[i]]++] = i;
+
+  // Find the first occurrence of each point
+  Array<int> first(n,uninit);
+  #pragma omp parallel for schedule(dynamic)
+  for (int s=0;s<shards;s++) {
+    Hashtable<TP,int> seen;
+    for (const int i : order.slice(shard_start[s],shard_start[s+1]))
+      first[i] = seen.get_or_insert(points[i],i);
+  }
+
+  // Number unique points in order
+  Array<TP> unique;
+  Array<int> index(n,uninit);
+  for (const int i : range(n))
+    index[i] = first[i]==i ? unique.append(points[i]) : index[first[i]];
+  return tuple(unique,index);
+}
+
 // Can't use a simple struct since StlTri has bad alignment
 struct StlTriData {
   Vector<float,3> n;
@@ -72,48 +192,47 @@ struct StlTri {
 static_assert(sizeof(StlTri)==12*4+2,"");
 
 // See http://en.wikipedia.org/wiki/STL_file for details
-static Tuple<Ref<TriangleSoup>,Array<TV>> read_stl(const string& filename) {
-  if (is_binary(filename)) {
-    File f(filename,"rb");
-
-    // Skip header
-    char header[80];
-    const auto nh = fread(header,1,sizeof(header),f);
-    if (nh < sizeof(header))
-      throw IOError(format("invalid binary stl '%s': %s",filename,
-        ferror(f) ? format("read failed: %s",strerror(errno)) : "incomplete header"));
-
-    // Read count
+static Tuple<Ref<TriangleSoup>,Array<TV>> read_stl(const string& filename, const bool deduplicate) {
+  const MappedFile file(filename);
+  if (is_binary(file)) {
+    // Read header and count
+    if (file.size < 84)
+      throw IOError(format("invalid binary stl '%s': incomplete header",filename));
     uint32_t count;
-    const auto nc = fread(&count,sizeof(count),1,f);
-    if (nc < 1)
-      throw IOError(format("invalid binary stl '%s': failed to read count",filename));
+    memcpy(&count,file.data+80,sizeof(count));
+    count = from_little_endian(count);
     if (count > (1u<<31)/3-1)
       throw IOError(format("binary stl has too many triangles: %u > 2^31/3-1",count));
-
-    // Read triangles
-    Array<StlTri> data(count,uninit);
-    const auto nt = fread(data.data(),sizeof(StlTri),count,f);
-    if (nt < count)
+    if (file.size < 84+sizeof(StlTri)*size_t(count))
       throw IOError(format("invalid binary stl '%s': failed to read triangles",filename));
 
-    // Deduplicate
-    Hashtable<Vector<float,3>,int> id;
-    Array<Vector<int,3>> tris;
-    Array<TV> X;
-    for (auto& t : data) {
+    // Read triangle corners straight out of the mapped file
+    const char* const data = file.data+84;
+    Array<Vector<float,3>> corners(3*count,uninit);
+    #pragma omp parallel for
+    for (int t=0;t<int(count);t++) {
       StlTriData d;
-      memcpy(&d,t.d,sizeof(d));
-      Vector<int,3> tri;
-      for (int a=0;a<3;a++) {
-        const int i = id.get_or_insert(d.x[a],X.size());
-        if (i == X.size())
-          X.append(TV(d.x[a]));
-        tri[a] = i;
-      }
-      tris.append(tri);
+      memcpy(&d,data+sizeof(StlTri)*t,sizeof(d));
+      for (int a=0;a<3;a++)
+        corners[3*t+a] = from_little_endian(d.x[a]);
     }
-    return tuple(new_<TriangleSoup>(tris,X.size()),X);
+
+    // Optionally deduplicate
+    Array<Vector<float,3>> unique;
+    Array<int> tris;
+    if (deduplicate) {
+      const auto D = parallel_deduplicate<Vector<float,3>>(corners);
+      unique = D.x;
+      tris = D.y;
+    } else {
+      unique = corners;
+      tris = arange(corners.size()).copy();
+    }
+    Array<TV> X(unique.size(),uninit);
+    #pragma omp parallel for
+    for (int i=0;i<X.size();i++)
+      X[i] = TV(unique[i]);
+    return tuple(new_<TriangleSoup>(vector_view_own<3>(tris),X.size()),X);
   } else { // ASCII
     File f(filename,"r");
 
@@ -166,7 +285,7 @@ static Tuple<Ref<TriangleSoup>,Array<TV>> read_stl(const string& filename) {
             Vector<double,3> x;
             if (sscanf(p+7,"%lg %lg %lg",&x.x,&x.y,&x.z) != 3)
               throw IOError(format("invalid ascii stl %s:%d: invalid vertex line: %s",filename,nl,repr(p)));
-            const int i = id.get_or_insert(x,X.size());
+            const int i = deduplicate ? id.get_or_insert(x,X.size()) : X.size();
             if (i == X.size()) {
               if (X.size()==numeric_limits<int>::max())
                 throw IOError(format("ascii stl %s has too many vertices, our limit is 2^31-1",filename));
@@ -211,75 +330,186 @@ static char* strtok_r(char* str, const char* delim, char** saveptr) {
 }
 #endif
 
-static Tuple<Ref<PolygonSoup>,Array<TV>> read_obj(const string& filename) {
-  File f(filename,"r");
+namespace {
+struct Line {
+  int lineno;
+  Array<char> line, split;
+  Array<const char*> words;
+
+  Line(const int lineno=0)
+    : lineno(lineno) {}
+
+  // Read the next line of [p,end), advancing p past its newline
+  bool read(const char*& p, const char* end) {
+    if (p == end)
+      return false;
+    lineno++;
+    const char* e = static_cast<const char*>(memchr(p,'\n',end-p));
+    e = e ? e+1 : end;
+    const int n = int(e-p);
+    line.resize(n+1,uninit);
+    memcpy(line.data(),p,n);
+    line[n] = 0;
+    p = e;
+    split.copy(line);
+    char* q = split.data();
+    char* save;
+    words.clear();
+    while (const char* w = strtok_r(q,white,&save)) {
+      words.append(w);
+      q = 0;
+    }
+    return true;
+  }
+
+  string repr() const {
+    return geode::repr(line.data());
+  }
+};
+
+struct LineChunk {
+  const char* begin;
+  const char* end;
+  int lineno; // Number of lines before this chunk
+  int lines; // Number of lines in this chunk
+};
+}
+
+// Split text into line aligned chunks for parallel parsing, and count the lines in each
+static Array<LineChunk> line_chunks(const char* begin, const char* end) {
+  const size_t size = end-begin,
+               min_chunk = 1<<20;
+  const int n = int(max(size_t(1),min(size_t(8*omp_get_max_threads()),size/min_chunk)));
+  Array<LineChunk> chunks(n,uninit);
+  const char* p = begin;
+  for (const int i : range(n)) {
+    const char* q = max(p,begin+size/n*(i+1));
+    if (i+1 == n)
+      q = end;
+    else if (q < end) {
+      q = static_cast<const char*>(memchr(q,'\n',end-q));
+      q = q ? q+1 : end;
+    }
+    chunks[i].begin = p;
+    chunks[i].end = p = q;
+  }
+  #pragma omp parallel for
+  for (int i=0;i<n;i++) {
+    auto& c = chunks[i];
+    c.lines = int(std::count(c.begin,c.end,'\n')) + (c.begin<c.end && c.end[-1]!='\n');
+  }
+  int lineno = 0;
+  for (auto& c : chunks) {
+    c.lineno = lineno;
+    lineno += c.lines;
+  }
+  return chunks;
+}
+
+// Concatenate per chunk arrays in order
+template<class T,class Chunks,class F> static Array<T> concatenate(const Chunks& chunks, const F& field, const char* what) {
+  int64_t n = 0;
+  for (const auto& c : chunks)
+    n += field(c).size();
+  if (n > numeric_limits<int>::max())
+    throw IOError(format("too many %s (our limit is 2^31-1)",what));
+  Array<T> all;
+  all.preallocate(int(n));
+  for (const auto& c : chunks)
+    all.extend(field(c));
+  return all;
+}
 
-  // Parse file
+namespace {
+struct ObjChunk {
   Array<TV> X, normals;
   Array<TV2> texcoords;
   Array<int> counts, vertices;
-  char orig[1024], line[1024];
-  int nl = 0;
-  while (fgets(orig,sizeof(orig),f)) {
-    nl++;
-    strcpy(line,orig);
-    char* save;
-    const char* cmd = strtok_r(line,white,&save);
-    if (!cmd || cmd[0] == '#')
-      continue;
-    else if (cmd[0]=='v' && (!cmd[1] || ((cmd[1]=='n' || cmd[1]=='t') && !cmd[2]))) { // cmd = v, vn, or vt
-      int n = 0;
-      double x[4];
-      for (int i=0;i<4;i++)
-        if (const char* q = strtok_r(0,white,&save)) {
+};
+}
+
+static Tuple<Ref<PolygonSoup>,Array<TV>> read_obj(const string& filename) {
+  const MappedFile file(filename);
+
+  // Parse line aligned chunks in parallel
+  const auto chunks = line_chunks(file.data,file.end());
+  vector<ObjChunk> parsed(chunks.size());
+  OmpExceptions errors;
+  #pragma omp parallel for schedule(dynamic)
+  for (int c=0;c<chunks.size();c++) errors.capture([&]() {
+    auto& P = parsed[c];
+    Line line(chunks[c].lineno);
+    const char* p = chunks[c].begin;
+    while (line.read(p,chunks[c].end)) {
+      const int nl = line.lineno;
+      const auto words = line.words.raw();
+      if (!words.size() || words[0][0] == '#')
+        continue;
+      const char* cmd = words[0];
+      if (cmd[0]=='v' && (!cmd[1] || ((cmd[1]=='n' || cmd[1]=='t') && !cmd[2]))) { // cmd = v, vn, or vt
+        int n = 0;
+        double x[4];
+        for (const char* q : words.slice(1,min(5,words.size()))) {
           char* end;
           x[n++] = strtod(q,&end);
           if (*end)
-            throw IOError(format("invalid obj file %s:%d: bad %s line: %s",filename,nl,cmd,repr(orig)));
+            throw IOError(format("invalid obj file %s:%d: bad %s line: %s",filename,nl,cmd,line.repr()));
         }
-      const int ne = !cmd[1] ? 3 : cmd[1]=='n' ? 3 : /*cmd[1]=='t'*/ 2;
-      if (n != ne)
-        throw IOError(format("invalid obj file %s:%d: %s expected %d floats, got %d. Line: %s",filename,nl,cmd,ne,n,repr(orig)));
-      if (!cmd[1]) { // v
-        if (X.size()==numeric_limits<int>::max())
-          throw IOError(format("unsupported obj file %s: too many vertices (our limit is 2^31-1)",filename));
-        X.append(TV(x[0],x[1],x[2]));
-      } else if (cmd[1]=='n') { // vn
-        if (normals.size()==numeric_limits<int>::max())
-          throw IOError(format("unsupported obj file %s: too many normals (our limit is 2^31-1)",filename));
-        normals.append(TV(x[0],x[1],x[2]));
-      } else { // vt
-        if (texcoords.size()==numeric_limits<int>::max())
-          throw IOError(format("unsupported obj file %s: too many texcoords (our limit is 2^31-1)",filename));
-        texcoords.append(TV2(x[0],x[1]));
-      }
-    } else if (cmd[0]=='f' && !cmd[1]) { // cmd = f
-      int n = 0;
-      while (const char* q = strtok_r(0,white,&save)) {
-        n++;
-        char* end;
-        const long v = strtol(q,&end,0);
-        if (*end && *end != '/')
-          throw IOError(format("invalid obj file %s:%d: f expected ints, got %s",filename,nl,repr(orig)));
-        // TODO: Don't skip face normal or face texcoord information
-        if (long(unsigned(int(v))) != v)
-          throw IOError(format("unsupported obj file %s:%d: f got invalid vertex id %ld",filename,nl,v));
-        vertices.append(int(v));
-      }
-      if (n < 3)
-        throw IOError(format("invalid obj file %s:%d: f got fewer than 3 vertices",filename,nl));
-      counts.append(n);
-    } else if (strcmp(cmd,"usemtl") || strcmp(cmd,"usemat") || strcmp(cmd,"mtllib")) {
-      // TODO: Don't skip these fields?
-    } else
-      throw IOError(format("invalid obj file %s:%d: invalid command %s",filename,nl,repr(cmd)));
+        const int ne = !cmd[1] ? 3 : cmd[1]=='n' ? 3 : /*cmd[1]=='t'*/ 2;
+        if (n != ne)
+          throw IOError(format("invalid obj file %s:%d: %s expected %d floats, got %d. Line: %s",filename,nl,cmd,ne,n,line.repr()));
+        if (!cmd[1]) // v
+          P.X.append(TV(x[0],x[1],x[2]));
+        else if (cmd[1]=='n') // vn
+          P.normals.append(TV(x[0],x[1],x[2]));
+        else // vt
+          P.texcoords.append(TV2(x[0],x[1]));
+      } else if (cmd[0]=='f' && !cmd[1]) { // cmd = f
+        for (const char* q : words.slice(1,words.size())) {
+          char* end;
+          const long v = strtol(q,&end,0);
+          if (*end && *end != '/')
+            throw IOError(format("invalid obj file %s:%d: f expected ints, got %s",filename,nl,line.repr()));
+          // TODO: Don't skip face normal or face texcoord information
+          if (long(unsigned(int(v))) != v)
+            throw IOError(format("unsupported obj file %s:%d: f got invalid vertex id %ld",filename,nl,v));
+          P.vertices.append(int(v));
+        }
+        const int n = words.size()-1;
+        if (n < 3)
+          throw IOError(format("invalid obj file %s:%d: f got fewer than 3 vertices",filename,nl));
+        P.counts.append(n);
+      } else if (strcmp(cmd,"usemtl") || strcmp(cmd,"usemat") || strcmp(cmd,"mtllib")) {
+        // TODO: Don't skip these fields?
+      } else
+        throw IOError(format("invalid obj file %s:%d: invalid command %s",filename,nl,repr(cmd)));
+    }
+  });
+  errors.rethrow();
+
+  // Concatenate chunks in order
+  Array<TV> X, normals;
+  Array<TV2> texcoords;
+  Array<int> counts, vertices;
+  try {
+    X         = concatenate<TV> (parsed,[](const ObjChunk& c) { return c.X.raw(); },"vertices");
+    normals   = concatenate<TV> (parsed,[](const ObjChunk& c) { return c.normals.raw(); },"normals");
+    texcoords = concatenate<TV2>(parsed,[](const ObjChunk& c) { return c.texcoords.raw(); },"texcoords");
+    counts    = concatenate<int>(parsed,[](const ObjChunk& c) { return c.counts.raw(); },"faces");
+    vertices  = concatenate<int>(parsed,[](const ObjChunk& c) { return c.vertices.raw(); },"face vertices");
+  } catch (const IOError& e) {
+    throw IOError(format("unsupported obj file %s: %s",filename,e.what()));
   }
 
   // Adjust vertices and check consistency
-  vertices -= 1;
-  for (const int v : vertices)
-    if (!X.valid(v))
-      throw IOError(format("invalid obj file %s: face vertex %d out of valid range [1,%d]",filename,v+1,X.size()));
+  bool valid = true;
+  #pragma omp parallel for reduction(&&:valid)
+  for (int i=0;i<vertices.size();i++)
+    valid = X.valid(--vertices[i]) && valid;
+  if (!valid)
+    for (const int v : vertices)
+      if (!X.valid(v))
+        throw IOError(format("invalid obj file %s: face vertex %d out of valid range [1,%d]",filename,v+1,X.size()));
   if (normals.size() && normals.size() != X.size())
     throw IOError(format("invalid obj file %s: %d vertices != %d normals",filename,X.size(),normals.size()));
   if (texcoords.size() && texcoords.size() != X.size())
@@ -320,35 +550,6 @@ static void write_obj(const string& filename, const PolygonSoup& soup, RawArray<
 }
 
 namespace {
-struct Line {
-  int lineno;
-  Array<char> line, split;
-  Array<const char*> words;
-
-  // TODO: Allow for longer lines
-  Line()
-    : lineno(0), line(1024), split(1024) {}
-
-  bool read(File& f) {
-    lineno++;
-    if (!fgets(line.data(),line.size(),f))
-      return false;
-    strcpy(split.data(),line.data());
-    char* p = split.data();
-    char* save;
-    words.clear();
-    while (const char* w = strtok_r(p,white,&save)) {
-      words.append(w);
-      p = 0;
-    }
-    return true;
-  }
-
-  string repr() const {
-    return geode::repr(line.data());
-  }
-};
-
 struct PlyProp : public Object {
   GEODE_NEW_FRIEND
   const string name;
@@ -356,9 +557,17 @@ protected:
   PlyProp(const string& name)
     : name(name) {}
 public:
-  virtual void read_ascii(RawArray<const char*> words, int& i) = 0;
-  virtual void read_binary_same_endian(FILE* f) = 0;
-  virtual void read_binary_flip_endian(FILE* f) = 0;
+  // Entries are read in contiguous chunks, possibly in parallel.  start must be called before reading,
+  // and finish afterwards.
+  virtual void start(const int count, const int chunks) = 0;
+  virtual void read_ascii(RawArray<const char*> words, int& i, const int index, const int chunk) = 0;
+  virtual void read_binary(const char*& p, const char* end, const int index, const int chunk, const bool flip) = 0;
+  virtual void finish() {}
+
+  // Size in bytes of the binary entry starting at p.  If fixed_size(), this is independent of p.
+  virtual bool fixed_size() const = 0;
+  virtual size_t binary_size(const char* p, const char* end) const = 0;
+
   virtual string type() const = 0;
 };
 
@@ -415,29 +624,34 @@ template<class T> struct PlyPropSingle : public PlyProp {
   GEODE_NEW_FRIEND
   Array<T> a;
 protected:
-  PlyPropSingle(const string& name, const int count)
-    : PlyProp(name) {
-    a.preallocate(count);
+  PlyPropSingle(const string& name)
+    : PlyProp(name) {}
+
+  void start(const int count, const int chunks) {
+    a.resize(count,uninit);
   }
 
-  void read_ascii(RawArray<const char*> words, int& i) {
+  void read_ascii(RawArray<const char*> words, int& i, const int index, const int chunk) {
     if (i==words.size())
       throw IOError(format("incomplete element (no %s)",name));
-    a.append_assuming_enough_space(parse<T>(words[i++]));
+    a[index] = parse<T>(words[i++]);
   }
 
-  void read_binary_same_endian(FILE* f) {
-    T x;
-    if (fread(&x,sizeof(T),1,f) < 1)
+  void read_binary(const char*& p, const char* end, const int index, const int chunk, const bool flip) {
+    if (size_t(end-p) < sizeof(T))
       throw IOError(format("incomplete element (no %s)",name));
-    a.append(x);
+    T x;
+    memcpy(&x,p,sizeof(T));
+    p += sizeof(T);
+    a[index] = flip ? flip_endian(x) : x;
   }
 
-  void read_binary_flip_endian(FILE* f) {
-    T x;
-    if (fread(&x,sizeof(T),1,f) < 1)
-      throw IOError(format("incomplete element (no %s)",name));
-    a.append(flip_endian(x));
+  bool fixed_size() const {
+    return true;
+  }
+
+  size_t binary_size(const char* p, const char* end) const {
+    return sizeof(T);
   }
 
   string type() const {
@@ -450,17 +664,24 @@ template<class L,class T> struct PlyPropList : public PlyProp {
   static_assert(is_same<L,uint8_t>::value,"L must be uint8_t for now");
   Array<int> counts;
   Array<T> flat;
+private:
+  vector<Array<T>> chunk_flat;
 protected:
-  PlyPropList(const string& name, const int n)
-    : PlyProp(name) {
-    counts.preallocate(n);
+  PlyPropList(const string& name)
+    : PlyProp(name) {}
+
+  void start(const int count, const int chunks) {
+    counts.resize(count,uninit);
+    chunk_flat.clear();
+    chunk_flat.resize(chunks);
   }
 
-  void read_ascii(RawArray<const char*> words, int& i) {
+  void read_ascii(RawArray<const char*> words, int& i, const int index, const int chunk) {
     if (i==words.size())
       throw IOError(format("incomplete element: no %s size",name));
     const auto n = parse<L>(words[i++]);
-    counts.append_assuming_enough_space(n);
+    counts[index] = n;
+    auto& flat = chunk_flat[chunk];
     flat.preallocate(flat.size()+n);
     for (int j=0;j<n;j++) {
       if (i==words.size())
@@ -469,29 +690,36 @@ protected:
     }
   }
 
-  void read_binary_same_endian(FILE* f) {
-    L n;
-    if (fread(&n,sizeof(L),1,f) < 1)
+  void read_binary(const char*& p, const char* end, const int index, const int chunk, const bool flip) {
+    if (p == end)
       throw IOError(format("incomplete element (no %s size)",name));
-    counts.append_assuming_enough_space(n);
-    const int offset = flat.size();
-    flat.resize(flat.size()+n);
-    if (fread(flat.data()+offset,sizeof(T),n,f) < n)
+    const L n = *p++; // L is a single byte, so no endian flip is needed
+    if (size_t(end-p) < n*sizeof(T))
       throw IOError(format("incomplete element (incomplete %s list)",name));
+    counts[index] = n;
+    auto& flat = chunk_flat[chunk];
+    const int offset = flat.size();
+    flat.resize(offset+n,uninit);
+    memcpy(flat.data()+offset,p,n*sizeof(T));
+    p += n*sizeof(T);
+    if (flip)
+      for (int i=0;i<n;i++)
+        flat[offset+i] = flip_endian(flat[offset+i]);
+  }
+
+  void finish() {
+    flat = concatenate<T>(chunk_flat,[](const Array<T>& a) { return a.raw(); },"list entries");
+    chunk_flat.clear();
+  }
+
+  bool fixed_size() const {
+    return false;
   }
 
-  void read_binary_flip_endian(FILE* f) {
-    L n;
-    if (fread(&n,sizeof(L),1,f) < 1)
+  size_t binary_size(const char* p, const char* end) const {
+    if (p == end)
       throw IOError(format("incomplete element (no %s size)",name));
-    n = flip_endian(n);
-    counts.append_assuming_enough_space(n);
-    const int offset = flat.size();
-    flat.resize(flat.size()+n);
-    if (fread(flat.data()+offset,sizeof(T),n,f) < n)
-      throw IOError(format("incomplete element (incomplete %s list)",name));
-    for (int i=0;i<n;i++)
-      flat[offset+i] = flip_endian(flat[offset+i]);
+    return 1+sizeof(T)*uint8_t(*p);
   }
 
   string type() const {
@@ -512,22 +740,151 @@ protected:
 };
 }
 
+// Read the ascii body of a ply file.  Each element entry is one line, so line aligned chunks of the body
+// can be parsed in parallel.
+static void read_ply_ascii(const string& filename, const vector<Ref<PlyElement>>& elements,
+                           const char* begin, const char* end, const int header_lines) {
+  Array<int> element_start(elements.size()+1,uninit);
+  int64_t total = 0;
+  for (const int e : range(int(elements.size()))) {
+    element_start[e] = int(total);
+    total += elements[e]->count;
+    if (total > numeric_limits<int>::max())
+      throw IOError(format("unsupported ply file %s: too many element entries (our limit is 2^31-1)",filename));
+  }
+  element_start.back() = int(total);
+
+  const auto chunks = line_chunks(begin,end);
+  for (const auto& E : elements)
+    for (const auto& prop : E->props)
+      prop->start(E->count,chunks.size());
+  OmpExceptions errors;
+  #pragma omp parallel for schedule(dynamic)
+  for (int c=0;c<chunks.size();c++) errors.capture([&]() {
+    Line line(header_lines+chunks[c].lineno);
+    const char* p = chunks[c].begin;
+    int e = 0;
+    for (int r=chunks[c].lineno;r<total && line.read(p,chunks[c].end);r++) {
+      while (r >= element_start[e+1])
+        e++;
+      const auto& E = *elements[e];
+      const int i = r-element_start[e];
+      int n = 0;
+      for (const auto& prop : E.props) {
+        try {
+          prop->read_ascii(line.words,n,i,c);
+        } catch (const IOError& error) {
+          throw IOError(format("invalid ply file %s:%d: failed to read element %s, index %d, prop %s: %s",
+            filename,line.lineno,repr(E.name),i,repr(prop->name),error.what()));
+        }
+      }
+      if (n != line.words.size())
+        throw IOError(format("invalid ply file %s:%d: failed to read element %s, index %d: extra fields",
+          filename,line.lineno,repr(E.name),i));
+    }
+  });
+  errors.rethrow();
+
+  // Check for truncated files
+  const int lines = chunks.back().lineno+chunks.back().lines;
+  if (lines < total) {
+    const int e = int(std::upper_bound(element_start.begin(),element_start.end(),lines)-element_start.begin())-1;
+    throw IOError(format("invalid ply file %s:%d: failed to read element %s, index %d: unexpected end of file",
+      filename,header_lines+lines+1,repr(elements[e]->name),lines-element_start[e]));
+  }
+  for (const auto& E : elements)
+    for (const auto& prop : E->props)
+      prop->finish();
+}
+
+// Read the binary body of a ply file.  Entries of each element are split into chunks and read in parallel.
+// If all properties have fixed size, chunk starts are computed directly.  Otherwise, a fast serial pass
+// over the list sizes finds them.
+static void read_ply_binary(const string& filename, const vector<Ref<PlyElement>>& elements,
+                            const char* p, const char* end, const bool flip) {
+  const int min_chunk = 1<<12,
+            max_chunks = 8*omp_get_max_threads();
+  for (const auto& E : elements) {
+    const int per_chunk = max(min_chunk,(E->count+max_chunks-1)/max_chunks),
+              chunks = (E->count+per_chunk-1)/per_chunk;
+    bool fixed = true;
+    size_t stride = 0;
+    for (const auto& prop : E->props) {
+      fixed &= prop->fixed_size();
+      if (fixed)
+        stride += prop->binary_size(p,end);
+    }
+    Array<const char*> starts(chunks+1,uninit);
+    if (fixed) {
+      if (size_t(end-p) < stride*E->count)
+        throw IOError(format("invalid ply file %s: failed to read element %s: unexpected end of file",
+          filename,repr(E->name)));
+      for (const int c : range(chunks))
+        starts[c] = p+stride*per_chunk*c;
+      starts[chunks] = p+stride*E->count;
+    } else {
+      const char* q = p;
+      for (const int i : range(E->count)) {
+        if (i%per_chunk == 0)
+          starts[i/per_chunk] = q;
+        for (const auto& prop : E->props) {
+          size_t size;
+          try {
+            size = prop->binary_size(q,end);
+          } catch (const IOError& error) {
+            throw IOError(format("invalid ply file %s: failed to read element %s, index %d, prop %s: %s",
+              filename,repr(E->name),i,repr(prop->name),error.what()));
+          }
+          if (size_t(end-q) < size)
+            throw IOError(format("invalid ply file %s: failed to read element %s, index %d, prop %s: "
+              "unexpected end of file",filename,repr(E->name),i,repr(prop->name)));
+          q += size;
+        }
+      }
+      starts[chunks] = q;
+    }
+
+    for (const auto& prop : E->props)
+      prop->start(E->count,chunks);
+    OmpExceptions errors;
+    #pragma omp parallel for schedule(dynamic)
+    for (int c=0;c<chunks;c++) errors.capture([&]() {
+      const char* q = starts[c];
+      for (const int i : range(per_chunk*c,min(per_chunk*(c+1),E->count)))
+        for (const auto& prop : E->props) {
+          try {
+            prop->read_binary(q,end,i,c,flip);
+          } catch (const IOError& error) {
+            throw IOError(format("invalid ply file %s: failed to read element %s, index %d, prop %s: %s",
+              filename,repr(E->name),i,repr(prop->name),error.what()));
+          }
+        }
+    });
+    errors.rethrow();
+    for (const auto& prop : E->props)
+      prop->finish();
+    p = starts[chunks];
+  }
+}
+
 static Tuple<Ref<PolygonSoup>,Array<TV>> read_ply(const string& filename) {
-  File f(filename,"rb");
+  const MappedFile file(filename);
+  const char* p = file.data;
+  const char* const end = file.end();
   Line line;
+  int fmt = 0; // 1 for ascii, 2 for binary little endian, 3 for binary big endian
+  vector<Ref<PlyElement>> elements;
+  Hashtable<string,Ref<PlyElement>> element_names;
   try {
     // Read magic string
-    if (!line.read(f) || line.words.size()!=1 || strcmp(line.words[0],"ply")) {
+    if (!line.read(p,end) || line.words.size()!=1 || strcmp(line.words[0],"ply")) {
       cout << "words = "<<line.words<<endl;
       throw IOError(format("expected magic string 'ply', got %s",repr(line)));
     }
 
     // Read rest of header
-    int fmt = 0; // 1 for ascii, 2 for binary little endian, 3 for binary big endian
-    vector<Ref<PlyElement>> elements;
-    Hashtable<string,Ref<PlyElement>> element_names;
     for (;;) {
-      if (!line.read(f))
+      if (!line.read(p,end))
         throw IOError("eof before end of header");
       const auto words = line.words.raw();
       if (!words.size() || !strcmp(words[0],"comment"))
@@ -567,10 +924,10 @@ static Tuple<Ref<PolygonSoup>,Array<TV>> read_ply(const string& filename) {
         Ptr<PlyProp> prop;
         #define SINGLE_CASE(name,T) \
           else if (!strcmp(words[1],#name)) \
-            prop = new_<PlyPropSingle<T>>(words[2],E.count);
+            prop = new_<PlyPropSingle<T>>(words[2]);
         #define LIST_CASE(name,T) \
           else if (!strcmp(words[3],#name)) \
-            prop = new_<PlyPropList<uint8_t,T>>(words[4],E.count);
+            prop = new_<PlyPropList<uint8_t,T>>(words[4]);
         if (!strcmp(words[1],"list")) {
           if (words.size() != 5)
             throw IOError("invalid list property declaration, expected 'property list uchar type name'");
@@ -597,60 +954,23 @@ static Tuple<Ref<PolygonSoup>,Array<TV>> read_ply(const string& filename) {
     }
     if (!fmt)
       throw IOError("missing format declaration");
+  } catch (const IOError& e) {
+    throw IOError(format("invalid ply file %s:%d: %s",filename,line.lineno,e.what()));
+  }
 
-    #if GEODE_ENDIAN == GEODE_LITTLE_ENDIAN
-      const int native = 2;
-    #elif GEODE_ENDIAN == GEODE_BIG_ENDIAN
-      const int native = 3;
-    #endif
-
-    // Read all elements
-    if (fmt == 1) {
-      for (const auto& E : elements) {
-        for (const int i : range(E->count)) {
-          if (!line.read(f))
-            throw IOError(format("failed to read element %s, index %d: unexpected end of file",repr(E->name),i));
-          int n = 0;
-          for (const auto& prop : E->props) {
-            try {
-              prop->read_ascii(line.words,n);
-            } catch (const IOError& e) {
-              throw IOError(format("failed to read element %s, index %d, prop %s: %s",
-                repr(E->name),i,repr(prop->name),e.what()));
-            }
-          }
-          if (n != line.words.size())
-            throw IOError(format("failed to read element %s, index %d: extra fields",repr(E->name),i));
-        }
-      }
-    } else if (fmt == native) {
-      for (const auto& E : elements) {
-        for (const int i : range(E->count)) {
-          for (const auto& prop : E->props) {
-            try {
-              prop->read_binary_same_endian(f);
-            } catch (const IOError& e) {
-              throw IOError(format("failed to read element %s, index %d, prop %s: %s",
-                repr(E->name),i,repr(prop->name),e.what()));
-            }
-          }
-        }
-      }
-    } else { // fmt == nonnative
-      for (const auto& E : elements) {
-        for (const int i : range(E->count)) {
-          for (const auto& prop : E->props) {
-            try {
-              prop->read_binary_flip_endian(f);
-            } catch (const IOError& e) {
-              throw IOError(format("failed to read element %s, index %d, prop %s: %s",
-                repr(E->name),i,repr(prop->name),e.what()));
-            }
-          }
-        }
-      }
-    }
+  #if GEODE_ENDIAN == GEODE_LITTLE_ENDIAN
+    const int native = 2;
+  #elif GEODE_ENDIAN == GEODE_BIG_ENDIAN
+    const int native = 3;
+  #endif
+
+  // Read all elements
+  if (fmt == 1)
+    read_ply_ascii(filename,elements,p,end,line.lineno);
+  else
+    read_ply_binary(filename,elements,p,end,fmt!=native);
 
+  try {
     // Pull out all the data we need
     // TODO: Don't discard all the rest of the data
     if (!element_names.contains("vertex"))
@@ -682,7 +1002,7 @@ static Tuple<Ref<PolygonSoup>,Array<TV>> read_ply(const string& filename) {
     else
       throw IOError(format("face.vertex_indices has unsupported type %s",vertices->type()));
   } catch (const IOError& e) {
-    throw IOError(format("invalid ply file %s:%d: %s",filename,line.lineno,e.what()));
+    throw IOError(format("invalid ply file %s: %s",filename,e.what()));
   }
 }
 
@@ -779,6 +1099,252 @@ static void write_x3d(const string& filename, const PolygonSoup& soup, RawArray<
   },X);
 }
 
+namespace {
+// Layout of .gmesh files: a header, a table of block descriptors, and the blocks themselves, each starting at
+// a multiple of native_alignment.  Everything is in native byte order.
+const char native_magic[8] = {'g','e','o','d','e','m','s','h'};
+const uint32_t native_version = 1,
+               native_endian = 0x01020304;
+const size_t native_alignment = 64;
+
+struct NativeHeader {
+  char magic[8];
+  uint32_t version, endian;
+  int32_t n_vertices, n_faces, n_boundary_edges, erased_boundaries, next_field_id, blocks;
+};
+
+enum NativeKind { native_faces, native_vertex_to_edge, native_boundaries,
+                  native_vertex_field, native_face_field, native_halfedge_field, native_kinds };
+
+struct NativeBlock {
+  int32_t kind, id, size, t_size;
+  uint64_t offset;
+  char type[64];
+};
+
+// Field types which can be stored.  These are the field types available from Python, plus ids.
+struct NativeType {
+  const char* name;
+  const type_info* type;
+  int t_size;
+  UntypedArray (*wrap[3])(const int size, char* data, PyObject* owner); // For vertex, face, and halfedge fields
+};
+
+template<class T,class Id> UntypedArray wrap_native_field(const int size, char* data, PyObject* owner) {
+  return UntypedArray(Field<T,Id>(Array<T>(size,(T*)data,owner)));
+}
+
+#define NATIVE_TYPE(...) {#__VA_ARGS__,&typeid(__VA_ARGS__),sizeof(__VA_ARGS__), \
+  {wrap_native_field<__VA_ARGS__,VertexId>,wrap_native_field<__VA_ARGS__,FaceId>,wrap_native_field<__VA_ARGS__,HalfedgeId>}},
+#define NATIVE_TYPES(T) NATIVE_TYPE(T) NATIVE_TYPE(Vector<T,2>) NATIVE_TYPE(Vector<T,3>) NATIVE_TYPE(Vector<T,4>)
+const NativeType native_types[] = {
+  NATIVE_TYPES(bool)
+  NATIVE_TYPES(char)
+  NATIVE_TYPES(unsigned char)
+  NATIVE_TYPES(short)
+  NATIVE_TYPES(unsigned short)
+  NATIVE_TYPES(int)
+  NATIVE_TYPES(unsigned int)
+  NATIVE_TYPES(long)
+  NATIVE_TYPES(unsigned long)
+  NATIVE_TYPES(long long)
+  NATIVE_TYPES(unsigned long long)
+  NATIVE_TYPES(float)
+  NATIVE_TYPES(double)
+  NATIVE_TYPE(VertexId)
+  NATIVE_TYPE(FaceId)
+  NATIVE_TYPE(HalfedgeId)
+};
+#undef NATIVE_TYPES
+#undef NATIVE_TYPE
+
+// Keeps a mapped .gmesh file alive for as long as any array points into it
+struct NativeMapping : public Object {
+  GEODE_NEW_FRIEND
+  const MappedFile file;
+protected:
+  NativeMapping(const string& filename)
+    : file(filename,true) {}
+};
+}
+
+static size_t native_align(const size_t n) {
+  return (n+native_alignment-1)/native_alignment*native_alignment;
+}
+
+void write_native_mesh(const string& filename, const MutableTriangleTopology& mesh) {
+  // Collect blocks
+  vector<Tuple<NativeBlock,const char*>> blocks;
+  const auto add = [&](const NativeKind kind, const int id, const int size, const int t_size,
+                       const char* type, const void* data) {
+    NativeBlock b;
+    memset(&b,0,sizeof(b));
+    b.kind = kind;
+    b.id = id;
+    b.size = size;
+    b.t_size = t_size;
+    strncpy(b.type,type,sizeof(b.type)-1);
+    blocks.push_back(tuple(b,(const char*)data));
+  };
+  typedef TriangleTopology::FaceInfo FaceInfo;
+  typedef TriangleTopology::BoundaryInfo BoundaryInfo;
+  add(native_faces,0,mesh.faces_.size(),sizeof(FaceInfo),"FaceInfo",mesh.faces_.flat.data());
+  add(native_vertex_to_edge,0,mesh.vertex_to_edge_.size(),sizeof(HalfedgeId),"HalfedgeId",mesh.vertex_to_edge_.flat.data());
+  add(native_boundaries,0,mesh.boundaries_.size(),sizeof(BoundaryInfo),"BoundaryInfo",mesh.boundaries_.data());
+  const auto add_fields = [&](const NativeKind kind, const Hashtable<int,int>& ids, const vector<UntypedArray>& fields) {
+    Array<int> sorted; // Sort by id so that output is deterministic
+    for (const auto& h : ids)
+      sorted.append(h.x);
+    std::sort(sorted.begin(),sorted.end());
+    for (const int id : sorted) {
+      const auto& field = fields[ids.get(id)];
+      const NativeType* type = 0;
+      for (const auto& t : native_types)
+        if (*t.type == field.type())
+          type = &t;
+      if (!type)
+        throw TypeError(format("write_native_mesh: field %d has unsupported type %s",id,field.type().name()));
+      add(kind,id,field.size(),field.t_size(),type->name,field.data());
+    }
+  };
+  add_fields(native_vertex_field,mesh.id_to_vertex_field,mesh.vertex_fields);
+  add_fields(native_face_field,mesh.id_to_face_field,mesh.face_fields);
+  add_fields(native_halfedge_field,mesh.id_to_halfedge_field,mesh.halfedge_fields);
+
+  // Lay out blocks
+  NativeHeader header;
+  memcpy(header.magic,native_magic,sizeof(header.magic));
+  header.version = native_version;
+  header.endian = native_endian;
+  header.n_vertices = mesh.n_vertices_;
+  header.n_faces = mesh.n_faces_;
+  header.n_boundary_edges = mesh.n_boundary_edges_;
+  header.erased_boundaries = mesh.erased_boundaries_.id;
+  header.next_field_id = mesh.next_field_id;
+  header.blocks = int(blocks.size());
+  size_t offset = native_align(sizeof(NativeHeader)+sizeof(NativeBlock)*blocks.size());
+  for (auto& b : blocks) {
+    b.x.offset = offset;
+    offset = native_align(offset+size_t(b.x.size)*b.x.t_size);
+  }
+
+  // Write
+  File f(filename,"wb");
+  const char zeros[native_alignment] = {0};
+  size_t written = 0;
+  const auto write = [&](const void* data, const size_t size) {
+    if (size && fwrite(data,1,size,f) < size)
+      throw IOError(format("failed to write native mesh %s: %s",filename,strerror(errno)));
+    written += size;
+  };
+  write(&header,sizeof(header));
+  for (const auto& b : blocks)
+    write(&b.x,sizeof(b.x));
+  for (const auto& b : blocks) {
+    write(zeros,b.x.offset-written);
+    write(b.y,size_t(b.x.size)*b.x.t_size);
+  }
+}
+
+Ref<MutableTriangleTopology> read_native_mesh(const string& filename) {
+  const auto mapping = new_<NativeMapping>(filename);
+  const auto owner = steal_ref(*to_python(*mapping));
+  char* const data = const_cast<char*>(mapping->file.data);
+  const size_t size = mapping->file.size;
+
+  // Check header
+  NativeHeader header;
+  if (size < sizeof(header))
+    throw IOError(format("invalid native mesh %s: incomplete header",filename));
+  memcpy(&header,data,sizeof(header));
+  if (memcmp(header.magic,native_magic,sizeof(header.magic)))
+    throw IOError(format("invalid native mesh %s: bad magic string",filename));
+  if (header.endian != native_endian)
+    throw IOError(format("native mesh %s was written on a machine with different byte order",filename));
+  if (header.version != native_version)
+    throw IOError(format("native mesh %s has unsupported version %u",filename,header.version));
+  if (header.blocks < 0 || size < sizeof(header)+sizeof(NativeBlock)*size_t(header.blocks))
+    throw IOError(format("invalid native mesh %s: incomplete block table",filename));
+
+  // Wrap each block as an array owned by the mapping
+  const auto mesh = new_<MutableTriangleTopology>();
+  typedef TriangleTopology::FaceInfo FaceInfo;
+  typedef TriangleTopology::BoundaryInfo BoundaryInfo;
+  int seen[native_kinds] = {0};
+  Array<Vector<int,2>> expected_sizes; // kind, size
+  for (const int i : range(header.blocks)) {
+    NativeBlock b;
+    memcpy(&b,data+sizeof(header)+sizeof(NativeBlock)*i,sizeof(b));
+    b.type[sizeof(b.type)-1] = 0;
+    if (unsigned(b.kind) >= unsigned(native_kinds) || b.size < 0 || b.t_size <= 0 || b.offset%native_alignment
+        || b.offset > size || (size-b.offset)/b.t_size < size_t(b.size))
+      throw IOError(format("invalid native mesh %s: bad block %d",filename,i));
+    char* const p = data+b.offset;
+    seen[b.kind]++;
+    const auto check_t_size = [&](const int t_size) {
+      if (b.t_size != t_size)
+        throw IOError(format("invalid native mesh %s: block %d has element size %d, expected %d",
+          filename,i,b.t_size,t_size));
+    };
+    if (b.kind == native_faces) {
+      check_t_size(sizeof(FaceInfo));
+      mesh->mutable_faces_ = Field<FaceInfo,FaceId>(Array<FaceInfo>(b.size,(FaceInfo*)p,&*owner));
+    } else if (b.kind == native_vertex_to_edge) {
+      check_t_size(sizeof(HalfedgeId));
+      mesh->mutable_vertex_to_edge_ = Field<HalfedgeId,VertexId>(Array<HalfedgeId>(b.size,(HalfedgeId*)p,&*owner));
+    } else if (b.kind == native_boundaries) {
+      check_t_size(sizeof(BoundaryInfo));
+      mesh->mutable_boundaries_ = Array<BoundaryInfo>(b.size,(BoundaryInfo*)p,&*owner);
+    } else {
+      const NativeType* type = 0;
+      for (const auto& t : native_types)
+        if (!strcmp(t.name,b.type))
+          type = &t;
+      if (!type)
+        throw IOError(format("native mesh %s: field %d has unknown type %s",filename,b.id,repr(b.type)));
+      check_t_size(type->t_size);
+      auto& ids = b.kind==native_vertex_field ? mesh->id_to_vertex_field
+                : b.kind==native_face_field   ? mesh->id_to_face_field
+                                              : mesh->id_to_halfedge_field;
+      auto& fields = b.kind==native_vertex_field ? mesh->vertex_fields
+                   : b.kind==native_face_field   ? mesh->face_fields
+                                                 : mesh->halfedge_fields;
+      if (!ids.set(b.id,int(fields.size())))
+        throw IOError(format("invalid native mesh %s: duplicate field id %d",filename,b.id));
+      fields.push_back(type->wrap[b.kind-native_vertex_field](b.size,p,&*owner));
+      expected_sizes.append(vec(b.kind,b.size));
+    }
+  }
+  if (seen[native_faces]!=1 || seen[native_vertex_to_edge]!=1 || seen[native_boundaries]!=1)
+    throw IOError(format("invalid native mesh %s: missing or duplicate topology blocks",filename));
+  for (const auto& k : expected_sizes) {
+    const int n = k.x==native_vertex_field ? mesh->vertex_to_edge_.size()
+                : k.x==native_face_field   ? mesh->faces_.size()
+                                           : 3*mesh->faces_.size();
+    if (k.y != n)
+      throw IOError(format("invalid native mesh %s: field size %d does not match mesh size %d",filename,k.y,n));
+  }
+  // Check counts and entry points against the block sizes.  Full validation would touch every page of the mapping,
+  // so it is left to callers via assert_consistent.
+  const int erased = header.erased_boundaries;
+  if (   unsigned(header.n_vertices) > unsigned(mesh->vertex_to_edge_.size())
+      || unsigned(header.n_faces) > unsigned(mesh->faces_.size())
+      || unsigned(header.n_boundary_edges) > unsigned(mesh->boundaries_.size())
+      || (erased!=invalid_id && (erased>=0 || -1-erased>=mesh->boundaries_.size())))
+    throw IOError(format("invalid native mesh %s: header counts do not match block sizes",filename));
+  for (const auto* ids : {&mesh->id_to_vertex_field,&mesh->id_to_face_field,&mesh->id_to_halfedge_field})
+    for (const auto& id : *ids)
+      if (id.x >= header.next_field_id)
+        throw IOError(format("invalid native mesh %s: field id %d is not below next field id %d",
+          filename,id.x,header.next_field_id));
+  mesh->mutable_n_vertices_ = header.n_vertices;
+  mesh->mutable_n_faces_ = header.n_faces;
+  mesh->mutable_n_boundary_edges_ = header.n_boundary_edges;
+  mesh->mutable_erased_boundaries_ = HalfedgeId(erased);
+  mesh->next_field_id = header.next_field_id;
+  return mesh;
+}
+
 static Tuple<Ref<TriangleSoup>,Array<TV>> convert(const Tuple<Ref<PolygonSoup>,Array<TV>>& d) {
   return tuple(d.x->triangle_mesh(),d.y);
 }
@@ -787,18 +1353,18 @@ static Tuple<Ref<PolygonSoup>,Array<TV>> convert(const Tuple<Ref<TriangleSoup>,A
   return tuple(new_<PolygonSoup>(arange(d.x->elements.size()).copy(),scalar_view_own(d.x->elements),d.y.size()),d.y);
 }
 
-Tuple<Ref<TriangleSoup>,Array<TV>> read_soup(const string& filename) {
+Tuple<Ref<TriangleSoup>,Array<TV>> read_soup(const string& filename, const bool deduplicate) {
   const auto ext = path::extension(filename);
-  if      (ext == ".stl") return         read_stl(filename);
+  if      (ext == ".stl") return         read_stl(filename,deduplicate);
   else if (ext == ".obj") return convert(read_obj(filename));
   else if (ext == ".ply") return convert(read_ply(filename));
   else
     throw ValueError(format("unsupported mesh filename '%s', expected one of .stl, .obj, .ply",filename));
 }
 
-Tuple<Ref<PolygonSoup>,Array<TV>> read_polygon_soup(const string& filename) {
+Tuple<Ref<PolygonSoup>,Array<TV>> read_polygon_soup(const string& filename, const bool deduplicate) {
   const auto ext = path::extension(filename);
-  if      (ext == ".stl") return convert(read_stl(filename));
+  if      (ext == ".stl") return convert(read_stl(filename,deduplicate));
   else if (ext == ".obj") return         read_obj(filename);
   else if (ext == ".ply") return         read_ply(filename);
   else
@@ -806,6 +1372,13 @@ Tuple<Ref<PolygonSoup>,Array<TV>> read_polygon_soup(const string& filename) {
 }
 
 Tuple<Ref<TriangleTopology>,Array<TV>> read_mesh(const string& filename) {
+  if (path::extension(filename) == ".gmesh") {
+    const auto mesh = read_native_mesh(filename);
+    const FieldId<TV,VertexId> pos_id(vertex_position_id);
+    if (!mesh->has_field(pos_id))
+      throw IOError(format("native mesh %s has no vertex positions",filename));
+    return tuple(Ref<TriangleTopology>(mesh),mesh->field(pos_id).flat);
+  }
   const auto soup = read_soup(filename);
   return tuple(new_<TriangleTopology>(soup.x),soup.y);
 }
@@ -840,6 +1413,8 @@ void write_mesh(const string& filename, const TriangleTopology& mesh, RawArray<c
 }
 
 void write_mesh(const string& filename, const MutableTriangleTopology& mesh) {
+  if (path::extension(filename) == ".gmesh")
+    return write_native_mesh(filename,mesh);
   FieldId<Vector<real,3>, VertexId> pos_id(vertex_position_id);
   GEODE_ASSERT(mesh.has_field(pos_id));
   write_helper(filename,mesh.elements(),mesh.field(pos_id).flat);
@@ -863,5 +1438,7 @@ void wrap_mesh_io() {
   GEODE_FUNCTION(read_soup)
   GEODE_FUNCTION(read_polygon_soup)
   GEODE_FUNCTION(read_mesh)
+  GEODE_FUNCTION(read_native_mesh)
+  GEODE_FUNCTION(write_native_mesh)
   GEODE_FUNCTION_2(write_mesh,write_mesh_py)
 }
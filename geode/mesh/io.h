@@ -5,9 +5,10 @@
 #include <geode/mesh/TriangleTopology.h>
 namespace geode {
 
-// Read a mesh format as triangle or polygon soup
-GEODE_EXPORT Tuple<Ref<TriangleSoup>,Array<Vector<real,3>>> read_soup(const string& filename);
-GEODE_EXPORT Tuple<Ref<PolygonSoup>,Array<Vector<real,3>>> read_polygon_soup(const string& filename);
+// Read a mesh format as triangle or polygon soup.  Files are memory mapped and parsed in parallel.
+// stl files store each triangle's corners separately; if deduplicate is true, equal corners are merged into one vertex.
+GEODE_EXPORT Tuple<Ref<TriangleSoup>,Array<Vector<real,3>>> read_soup(const string& filename, const bool deduplicate=true);
+GEODE_EXPORT Tuple<Ref<PolygonSoup>,Array<Vector<real,3>>> read_polygon_soup(const string& filename, const bool deduplicate=true);
 
 // Read a mesh format and convert to a manifold mesh.  If the mesh is not manifold, an exception is thrown.
 GEODE_EXPORT Tuple<Ref<TriangleTopology>,Array<Vector<real,3>>> read_mesh(const string& filename);
@@ -21,4 +22,12 @@ GEODE_EXPORT void write_mesh(const string& filename, const TriangleTopology& mes
 // id and have type Vector<real,3>. 
 GEODE_EXPORT void write_mesh(const string &filename, const MutableTriangleTopology &mesh);
 
+// Geode's native binary format (.gmesh) stores the topology arrays and all fields of a MutableTriangleTopology
+// as aligned blocks.  Reading maps the file and wraps the blocks as arrays, with no parsing and no rebuilding
+// of topology.  The mapping is copy on write, so the loaded mesh can be freely modified.  Files are only
+// readable on machines with the same byte order.  write_mesh and read_mesh use this format for .gmesh files.
+// Reading checks only the header and block sizes; call assert_consistent to validate untrusted files.
+GEODE_EXPORT void write_native_mesh(const string& filename, const MutableTriangleTopology& mesh);
+GEODE_EXPORT Ref<MutableTriangleTopology> read_native_mesh(const string& filename);
+
 }
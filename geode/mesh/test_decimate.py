@@ -24,12 +24,14 @@ def test_decimate():
     mesh,X = loop_subdivide(mesh,X,steps=steps)
     mesh = TriangleTopology(mesh)
     def test(distance,boundary_distance=0):
-      md,Xd = decimate(mesh,X,distance=distance,boundary_distance=boundary_distance)
-      H = hausdorff((mesh,X),(md,Xd))
-      Hb = hausdorff((mesh,X),(md,Xd),boundary=1)
-      print('distance %g, boundary %g, H %g, Hb %g'%(distance,boundary_distance,H,Hb))
-      assert H<=distance
-      assert Hb<=boundary_distance
+      for parallel in False,True:
+        md,Xd = decimate(mesh,X,distance=distance,boundary_distance=boundary_distance,parallel=parallel)
+        md.assert_consistent(True)
+        H = hausdorff((mesh,X),(md,Xd))
+        Hb = hausdorff((mesh,X),(md,Xd),boundary=1)
+        print('distance %g, boundary %g, parallel %d, H %g, Hb %g'%(distance,boundary_distance,parallel,H,Hb))
+        assert H<=distance
+        assert Hb<=boundary_distance
     test(distance=.01)
     test(distance=.05,boundary_distance=.02)
     test(distance=3,boundary_distance=.1)
@@ -26,12 +26,42 @@ def test_collect_boundary_garbage():
   mesh = MutableTriangleTopology()
   assert mesh.is_garbage_collected()
   mesh.add_vertices(soup.nodes())
-  mesh.add_faces(tris)
+  # Batch insertion into isolated vertices creates no garbage, so add the second half incrementally
+  mesh.add_faces(tris[:len(tris)//2])
+  mesh.add_faces(tris[len(tris)//2:])
   assert not mesh.is_garbage_collected()
   mesh.collect_boundary_garbage()
   mesh.assert_consistent(True)
   assert mesh.is_garbage_collected()
 
+def test_add_faces_batch():
+  random.seed(81231)
+  soup,X = sphere_mesh(3)
+  tris = soup.elements
+  for subset in xrange(20):
+    # Random subsets leave vertices with several boundary fans
+    ts = tris[random.permutation(len(tris))[:random.randint(1,len(tris)+1)]]
+    batch = MutableTriangleTopology()
+    batch.add_vertices(len(X))
+    batch.add_faces(ts)
+    batch.assert_consistent(True)
+    single = MutableTriangleTopology()
+    single.add_vertices(len(X))
+    for t in ts:
+      single.add_face(t)
+    single.assert_consistent(True)
+    assert all(batch.elements()==single.elements())
+    assert batch.n_boundary_edges==single.n_boundary_edges
+    assert all([batch.is_boundary_vertex(v)==single.is_boundary_vertex(v) for v in xrange(len(X))])
+  # Invalid batches still fail
+  mesh = MutableTriangleTopology()
+  mesh.add_vertices(4)
+  try:
+    mesh.add_faces([(0,1,2),(0,1,3)])
+    assert False
+  except ValueError:
+    pass
+
 def test_collapse():
   random.seed(131313)
   soup = torus_topology(8,10)
@@ -264,8 +294,45 @@ def test_fields():
     # Flip some edges, check that the content of affected faces is as expected
     # (we're already checking consistency)
 
+def test_reorder_for_locality(benchmark=False):
+  random.seed(178131)
+  soup,X = sphere_mesh(7 if benchmark else 3)
+  # Scatter vertex and face ids, as CSG and decimation tend to
+  p = random.permutation(len(X)).astype(int32)
+  tris = p[soup.elements]
+  random.shuffle(tris)
+  Y = empty_like(X)
+  Y[p] = X
+  mesh = MutableTriangleTopology()
+  mesh.add_vertices(len(X))
+  mesh.add_faces(tris)
+  mesh.erase_face(7,False)
+  Xi = mesh.add_vertex_field('3d',vertex_position_id)
+  mesh.field(Xi)[:] = Y
+  Hi = mesh.add_halfedge_field('i',invalid_id)
+  H = mesh.field(Hi)
+  H[:] = arange(len(H))
+  old = mesh.copy()
+  if benchmark:
+    before = corner_traversal_benchmark(mesh,Y,3)
+  vp,fp,_ = mesh.reorder_for_locality(16)
+  mesh.assert_consistent(True)
+  if benchmark:
+    after = corner_traversal_benchmark(mesh,mesh.field(Xi),3)
+    for name,b,a in zip(('outgoing','normals','face_tree'),before,after):
+      print('%s: %g s -> %g s, speedup %g'%(name,b,a,b/a))
+  # Faces, positions, and halfedge fields all follow the permutations
+  assert all(sort(vp[vp>=0])==arange(mesh.n_vertices))
+  assert fp[7]<0
+  for f in old.faces():
+    nf = fp[f]
+    assert all(vp[old.face_vertices(f)]==mesh.face_vertices(nf))
+    assert all(mesh.field(Hi)[3*nf:3*nf+3]==arange(3*f,3*f+3))
+  assert all(mesh.field(Xi)[vp]==Y)
+
 if __name__=='__main__':
   test_fields()
   test_corner_construction()
   test_halfedge_construction()
   test_collapse()
+  test_reorder_for_locality(benchmark=True)
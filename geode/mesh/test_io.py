@@ -105,5 +105,60 @@ end_header
       open(f.name,'w').write(ascii[ext])
       check_read()
 
+  # Without deduplication, each stl triangle gets its own vertices
+  for text in False,True:
+    f = named_tmpfile(suffix='.stl')
+    if text:
+      open(f.name,'w').write(ascii['.stl'])
+    else:
+      write_mesh(f.name,soup,X)
+    soup2,X2 = read_soup(f.name,deduplicate=False)
+    assert all(soup2.elements.ravel()==arange(6))
+    assert all(X2==X[soup.elements.ravel()])
+
+def test_io_large():
+  # Large enough to be split into several chunks when read in parallel
+  from geode.geometry.platonic import sphere_mesh
+  soup,X = sphere_mesh(7)
+  X = X.astype(float32).astype(real)
+  for ext in '.stl .obj .ply'.split():
+    f = named_tmpfile(suffix=ext)
+    write_mesh(f.name,soup,X)
+    soup2,X2 = read_soup(f.name)
+    assert len(X2)==len(X)
+    # stl numbers vertices in order of appearance, so compare triangle positions
+    assert allclose(X[soup.elements],X2[soup2.elements],atol=1e-5)
+
+def test_native_io():
+  from geode.geometry.platonic import sphere_mesh
+  soup,X = sphere_mesh(3)
+  mesh = MutableTriangleTopology()
+  mesh.add_vertices(soup.nodes())
+  mesh.add_faces(soup.elements)
+  mesh.erase_face(7,False)
+  Xi = mesh.add_vertex_field('3d',vertex_position_id)
+  mesh.field(Xi)[:] = X
+  Fi = mesh.add_face_field('3i',face_color_id)
+  mesh.field(Fi)[:] = arange(3*mesh.allocated_faces).reshape(-1,3)
+  Hi = mesh.add_halfedge_field('i',invalid_id)
+  mesh.field(Hi)[:] = arange(3*mesh.allocated_faces)
+  f = named_tmpfile(suffix='.gmesh')
+  write_mesh(f.name,mesh)
+  mesh2 = read_native_mesh(f.name)
+  mesh2.assert_consistent(True)
+  assert mesh2.n_faces==mesh.n_faces and mesh2.n_vertices==mesh.n_vertices
+  assert all(mesh2.elements()==mesh.elements())
+  for i in Xi,Fi,Hi:
+    assert all(mesh2.field(i)==mesh.field(i))
+
+  # Loaded meshes can be modified without touching the file
+  mesh2.erase_face(8,True)
+  mesh2.field(Fi)[0] = -1
+  mesh3,X3 = read_mesh(f.name)
+  assert all(mesh3.elements()==mesh.elements())
+  assert all(X3==X)
+
 if __name__=='__main__':
   test_io()
+  test_io_large()
+  test_native_io()
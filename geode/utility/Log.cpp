@@ -289,6 +289,7 @@ template void stat(const string&,const int&);
 template void stat(const string&,const bool&);
 template void stat(const string&,const float&);
 template void stat(const string&,const double&);
+template void stat(const string&,const uint64_t&);
 
 void push_scope(const string& name) {
   initialize();
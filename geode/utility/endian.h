@@ -76,6 +76,7 @@ template<class T,int d> static inline Vector<T,d> flip_endian(const Vector<T,d>&
   Vector<T,d> r;
   for (int i=0;i<d;i++)
     r[i] = flip_endian(v[i]);
+  return r;
 }
 
 // For everything else, use the int case
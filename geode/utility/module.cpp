@@ -57,6 +57,18 @@ static void large_partition_loop_test(const uint64_t loop_steps, const int threa
   }
 }
 
+// Thread count control, so that tests can check that parallel results do not depend on the number of threads
+static int omp_max_threads() {
+  return omp_get_max_threads();
+}
+
+static void set_omp_max_threads(const int threads) {
+  GEODE_ASSERT(threads>0);
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+}
+
 static bool geode_endian_matches_native() {
   uint8_t a0 = 0xa0, a1 = 0xa1, a2 = 0xa2, a3 = 0xa3;
   uint32_t test_int = 0;
@@ -97,6 +109,8 @@ void wrap_utility() {
 
   GEODE_FUNCTION(partition_loop_test)
   GEODE_FUNCTION(large_partition_loop_test)
+  GEODE_FUNCTION(omp_max_threads)
+  GEODE_FUNCTION(set_omp_max_threads)
 
   GEODE_FUNCTION(geode_endian_matches_native)
 
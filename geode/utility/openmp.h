@@ -5,6 +5,7 @@
 #include <geode/utility/debug.h>
 #include <geode/utility/range.h>
 #include <geode/utility/type_traits.h>
+#include <exception>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -46,4 +47,25 @@ template<class I,class TI> inline TI partition_loop_inverse(const I loop_steps,
                                : 0); // Only occurs if loop_steps==0
 }
 
+// Exceptions must not escape an OpenMP parallel region.  Wrap the body of each parallel iteration in capture(...),
+// then call rethrow() after the region to rethrow the first exception caught by any thread.
+class OmpExceptions {
+  std::exception_ptr error;
+public:
+  template<class F> void capture(F&& f) {
+    try {
+      f();
+    } catch (...) {
+      #pragma omp critical(geode_omp_exceptions)
+      if (!error)
+        error = std::current_exception();
+    }
+  }
+
+  void rethrow() const {
+    if (error)
+      std::rethrow_exception(error);
+  }
+};
+
 }